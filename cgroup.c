@@ -0,0 +1,553 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			cgroup.c
+ * @Description			cgroup v2 based CPU load throttling
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include "cgroup.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define CGROUP_PATH_MAX		512
+#define CGROUP_QUOTA_MIN_US	1000
+#define CGROUP_PERIOD_MIN_US	1000
+#define CGROUP_PERIOD_MAX_US	1000000
+
+
+typedef struct {
+	int created;
+	unsigned long long usage_start;
+	unsigned long long psi_some_start;
+	unsigned long long psi_full_start;
+	struct timespec start;
+} cgroup_worker;
+
+
+static char cgroup_base[CGROUP_PATH_MAX];
+static char cgroup_orig[CGROUP_PATH_MAX];
+static char cgroup_mnt[CGROUP_PATH_MAX];
+static char cgroup_parent[CGROUP_PATH_MAX];
+static int cgroup_cpu_enabled = 0;	/* cpu controller enabled by us */
+static cgroup_worker *cgroup_workers = NULL;
+static unsigned int cgroup_count = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_write
+ * @BRIEF		write formatted string into a cgroup interface file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		dir: cgroup directory
+ * @param[in]		file: cgroup interface file name
+ * @param[in]		fmt: format string
+ * @DESCRIPTION		write formatted string into a cgroup interface file.
+ *			Use a single write() call, as cgroup files do not
+ *			support partial writes.
+ *//*------------------------------------------------------------------------ */
+static int cgroup_write(const char *dir, const char *file,
+	const char *fmt, ...)
+{
+	char path[CGROUP_PATH_MAX + 64];
+	char buf[128];
+	va_list ap;
+	FILE *fp;
+	int len, ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	fp = fopen(path, "w");
+	if (fp == NULL)
+		return -errno;
+	setvbuf(fp, NULL, _IONBF, 0);
+	ret = (fwrite(buf, 1, len, fp) == (size_t) len) ? 0 : -errno;
+	fclose(fp);
+	dprintf("%s(): %s <- %s (%d)\n", __func__, path, buf, ret);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_read_key
+ * @BRIEF		read value of a given key in a cgroup interface file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		dir: cgroup directory
+ * @param[in]		file: cgroup interface file name
+ * @param[in]		line: line prefix ("some", "full") or NULL (any line)
+ * @param[in]		key: key name ("usage_usec", "total", ...)
+ * @param[out]		val: key value
+ * @DESCRIPTION		read value of a given key in a cgroup interface file.
+ *			Support both "key value" (cpu.stat) and
+ *			"line key=value ..." (cpu.pressure) formats.
+ *//*------------------------------------------------------------------------ */
+static int cgroup_read_key(const char *dir, const char *file,
+	const char *line, const char *key, unsigned long long *val)
+{
+	char path[CGROUP_PATH_MAX + 64];
+	char buf[256];
+	char pattern[64];
+	char *p;
+	FILE *fp;
+	int ret = -ENOENT;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		if (line == NULL) {
+			snprintf(pattern, sizeof(pattern), "%s %%llu", key);
+			if (sscanf(buf, pattern, val) == 1) {
+				ret = 0;
+				break;
+			}
+		} else if (strncmp(buf, line, strlen(line)) == 0) {
+			snprintf(pattern, sizeof(pattern), " %s=", key);
+			p = strstr(buf, pattern);
+			if ((p != NULL) && (sscanf(p + strlen(pattern),
+				"%llu", val) == 1))
+				ret = 0;
+			break;
+		}
+	}
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_has_token
+ * @BRIEF		check if a space-separated list contains a given token.
+ * @RETURNS		1 if list contains token, 0 otherwise
+ * @param[in]		list: space-separated list (e.g. cgroup.controllers)
+ * @param[in]		token: token to look for
+ * @DESCRIPTION		check if a space-separated list contains a given token.
+ *//*------------------------------------------------------------------------ */
+static int cgroup_has_token(const char *list, const char *token)
+{
+	size_t len = strlen(token);
+	const char *p = list;
+
+	while ((p = strstr(p, token)) != NULL) {
+		if (((p == list) || (*(p - 1) == ' ')) &&
+			((p[len] == ' ') || (p[len] == '\n') || (p[len] == '\0')))
+			return 1;
+		p += len;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_cpu_restore
+ * @BRIEF		disable cpu controller in parent subtree.
+ * @DESCRIPTION		disable cpu controller in parent subtree, if it was
+ *			enabled by cgroup_init(), leaving system cgroup
+ *			configuration as found.
+ *//*------------------------------------------------------------------------ */
+static void cgroup_cpu_restore(void)
+{
+	int ret;
+
+	if (!cgroup_cpu_enabled)
+		return;
+	cgroup_cpu_enabled = 0;
+	ret = cgroup_write(cgroup_parent, "cgroup.subtree_control", "-cpu");
+	if (ret != 0)
+		fprintf(stderr, "cpuloadgen: could not disable cpu controller in %s (%s)!\n",
+			cgroup_parent, strerror(-ret));
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_init
+ * @BRIEF		create cpuloadgen cgroup and move process into it.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		parent: parent cgroup v2 directory
+ *				(e.g. /sys/fs/cgroup)
+ * @param[in]		cpu_count: number of CPU cores
+ * @DESCRIPTION		create cpuloadgen cgroup and move process into it.
+ *			This cgroup becomes the root of a threaded subtree
+ *			once per-worker threaded children are created, so that
+ *			each load thread can be throttled independently.
+ *			cpu controller is enabled in parent subtree if needed,
+ *			and disabled again by cgroup_deinit().
+ *//*------------------------------------------------------------------------ */
+int cgroup_init(const char *parent, unsigned int cpu_count)
+{
+	char buf[CGROUP_PATH_MAX];
+	char type[16];
+	char *p;
+	FILE *fp;
+	int ret;
+
+	/* Save original cgroup, to move back into it when done */
+	cgroup_orig[0] = '\0';
+	fp = fopen("/proc/self/cgroup", "r");
+	if (fp != NULL) {
+		while (fgets(buf, sizeof(buf), fp) != NULL) {
+			if (strncmp(buf, "0::", 3) != 0)
+				continue;
+			p = strchr(buf, '\n');
+			if (p != NULL)
+				*p = '\0';
+			strncpy(cgroup_orig, buf + 3, sizeof(cgroup_orig) - 1);
+		}
+		fclose(fp);
+	}
+
+	/* cpu controller must be available for cpu.max throttling */
+	snprintf(buf, sizeof(buf), "%s/cgroup.controllers", parent);
+	fp = fopen(buf, "r");
+	if (fp == NULL) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: %s is not a cgroup v2 directory (%s)!\n",
+			parent, strerror(-ret));
+		return ret;
+	}
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	if ((p == NULL) || (!cgroup_has_token(buf, "cpu"))) {
+		fprintf(stderr, "cpuloadgen: cpu controller not available in %s!\n",
+			parent);
+		return -ENOTSUP;
+	}
+
+	cgroup_workers = calloc(cpu_count, sizeof(cgroup_worker));
+	if (cgroup_workers == NULL)
+		return -ENOMEM;
+	cgroup_count = cpu_count;
+
+	/*
+	 * Enable cpu controller in parent subtree, unless already enabled,
+	 * remembering to disable it when done.
+	 */
+	strncpy(cgroup_parent, parent, sizeof(cgroup_parent) - 1);
+	cgroup_cpu_enabled = 0;
+	snprintf(buf, sizeof(buf), "%s/cgroup.subtree_control", parent);
+	fp = fopen(buf, "r");
+	p = NULL;
+	if (fp != NULL) {
+		p = fgets(buf, sizeof(buf), fp);
+		fclose(fp);
+	}
+	if ((p == NULL) || (!cgroup_has_token(buf, "cpu"))) {
+		ret = cgroup_write(parent, "cgroup.subtree_control", "+cpu");
+		if (ret != 0) {
+			fprintf(stderr, "cpuloadgen: could not enable cpu controller in %s (%s)!\n",
+				parent, strerror(-ret));
+			goto err;
+		}
+		cgroup_cpu_enabled = 1;
+	}
+
+	snprintf(cgroup_base, sizeof(cgroup_base), "%s/cpuloadgen.%d",
+		parent, (int) getpid());
+	if (mkdir(cgroup_base, 0755) != 0) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not create cgroup %s (%s)!\n",
+			cgroup_base, strerror(-ret));
+		goto err;
+	}
+
+	ret = cgroup_write(cgroup_base, "cgroup.procs", "%d", (int) getpid());
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: could not move process into cgroup %s (%s)!\n",
+			cgroup_base, strerror(-ret));
+		rmdir(cgroup_base);
+		goto err;
+	}
+
+	/* Retrieve cgroup v2 mount point, to be able to move back */
+	cgroup_mnt[0] = '\0';
+	fp = fopen("/proc/mounts", "r");
+	if (fp != NULL) {
+		while (fgets(buf, sizeof(buf), fp) != NULL) {
+			if ((sscanf(buf, "%*s %511s %15s", cgroup_mnt,
+				type) == 2) && (strcmp(type, "cgroup2") == 0))
+				break;
+			cgroup_mnt[0] = '\0';
+		}
+		fclose(fp);
+	}
+
+	dprintf("%s(): base=%s orig=%s mnt=%s\n", __func__,
+		cgroup_base, cgroup_orig, cgroup_mnt);
+	return 0;
+
+err:
+	cgroup_cpu_restore();
+	free(cgroup_workers);
+	cgroup_workers = NULL;
+	cgroup_count = 0;
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_worker_create
+ * @BRIEF		create threaded cgroup of a given load thread.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID loaded by the thread
+ * @param[in]		load: requested load ([1-100])
+ * @param[in]		period: cpu.max period (in microseconds)
+ * @DESCRIPTION		create threaded cgroup of a given load thread, and
+ *			program cpu.max quota so that the kernel throttles
+ *			the thread down to the requested load. Periods out of
+ *			cpu.max range, and loads whose quota would be below
+ *			cpu.max minimum, are rejected rather than silently
+ *			clamped.
+ *//*------------------------------------------------------------------------ */
+int cgroup_worker_create(unsigned int cpu, unsigned int load, long int period)
+{
+	char dir[CGROUP_PATH_MAX + 16];
+	long int quota;
+	int ret;
+
+	if (cpu >= cgroup_count)
+		return -EINVAL;
+	if ((period < CGROUP_PERIOD_MIN_US) ||
+		(period > CGROUP_PERIOD_MAX_US)) {
+		fprintf(stderr,
+			"cpuloadgen: CPU%u: %ldus period is out of cpu.max range ([%d-%d]us)!\n",
+			cpu, period, CGROUP_PERIOD_MIN_US, CGROUP_PERIOD_MAX_US);
+		return -EINVAL;
+	}
+	quota = (period * load) / 100;
+	if ((load != 100) && (quota < CGROUP_QUOTA_MIN_US)) {
+		fprintf(stderr,
+			"cpuloadgen: CPU%u: %u%% of %ldus period is below cpu.max minimum quota (%dus), use period >= %uus!\n",
+			cpu, load, period, CGROUP_QUOTA_MIN_US,
+			(CGROUP_QUOTA_MIN_US * 100 + load - 1) / load);
+		return -EINVAL;
+	}
+
+	snprintf(dir, sizeof(dir), "%s/cpu%u", cgroup_base, cpu);
+	/* Already created (e.g. previous sweep step): only update cpu.max */
+	if (!cgroup_workers[cpu].created) {
+		if (mkdir(dir, 0755) != 0) {
+			ret = -errno;
+			goto err;
+		}
+		cgroup_workers[cpu].created = 1;
+		ret = cgroup_write(dir, "cgroup.type", "threaded");
+		if (ret != 0)
+			goto err;
+		/* cpu is a threaded controller, may be enabled in threaded root */
+		cgroup_write(cgroup_base, "cgroup.subtree_control", "+cpu");
+	}
+	if (load == 100)
+		ret = cgroup_write(dir, "cpu.max", "max %ld", period);
+	else
+		ret = cgroup_write(dir, "cpu.max", "%ld %ld", quota, period);
+	if (ret != 0)
+		goto err;
+
+	dprintf("%s(): CPU%u cpu.max=%ld/%ld\n", __func__, cpu, quota, period);
+	return 0;
+
+err:
+	fprintf(stderr, "cpuloadgen: CPU%u: could not set up cgroup %s (%s)!\n",
+		cpu, dir, strerror(-ret));
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_worker_attach
+ * @BRIEF		move calling thread into its cgroup.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID loaded by the calling thread
+ * @DESCRIPTION		move calling thread into its cgroup, and save
+ *			initial timestamp, usage and pressure counters.
+ *//*------------------------------------------------------------------------ */
+int cgroup_worker_attach(unsigned int cpu)
+{
+	char dir[CGROUP_PATH_MAX + 16];
+	cgroup_worker *w;
+	int ret;
+
+	if ((cpu >= cgroup_count) || (!cgroup_workers[cpu].created))
+		return -EINVAL;
+	w = &cgroup_workers[cpu];
+
+	snprintf(dir, sizeof(dir), "%s/cpu%u", cgroup_base, cpu);
+	ret = cgroup_write(dir, "cgroup.threads", "%ld",
+		(long) syscall(SYS_gettid));
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: CPU%u: could not move thread into cgroup %s (%s)!\n",
+			cpu, dir, strerror(-ret));
+		return ret;
+	}
+
+	w->usage_start = 0;
+	w->psi_some_start = 0;
+	w->psi_full_start = 0;
+	cgroup_read_key(dir, "cpu.stat", NULL, "usage_usec", &w->usage_start);
+	cgroup_read_key(dir, "cpu.pressure", "some", "total",
+		&w->psi_some_start);
+	cgroup_read_key(dir, "cpu.pressure", "full", "total",
+		&w->psi_full_start);
+	clock_gettime(CLOCK_MONOTONIC, &w->start);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_worker_report
+ * @BRIEF		report load achieved by a given load thread.
+ * @param[in]		cpu: CPU core ID loaded by the thread
+ * @param[in]		load: requested load ([1-100])
+ * @DESCRIPTION		report load achieved by a given load thread, from
+ *			cgroup cpu.stat usage and throttling counters, and
+ *			CPU pressure stall information (PSI) from cpu.pressure.
+ *//*------------------------------------------------------------------------ */
+void cgroup_worker_report(unsigned int cpu, unsigned int load)
+{
+	char dir[CGROUP_PATH_MAX + 16];
+	unsigned long long usage, periods, throttled, throttled_us;
+	unsigned long long psi_some, psi_full;
+	struct timespec now;
+	double elapsed_us;
+	cgroup_worker *w;
+
+	if ((cpu >= cgroup_count) || (!cgroup_workers[cpu].created))
+		return;
+	w = &cgroup_workers[cpu];
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_us = ((double) (now.tv_sec - w->start.tv_sec)) * 1.0e6 +
+		((double) (now.tv_nsec - w->start.tv_nsec)) * 1.0e-3;
+	if (elapsed_us <= 0.0)
+		return;
+
+	snprintf(dir, sizeof(dir), "%s/cpu%u", cgroup_base, cpu);
+	printf("CPU%u cgroup: requested %3u%%", cpu, load);
+	if (cgroup_read_key(dir, "cpu.stat", NULL, "usage_usec", &usage) == 0)
+		printf(", achieved %5.1f%%", 100.0 *
+			(double) (usage - w->usage_start) / elapsed_us);
+	if ((cgroup_read_key(dir, "cpu.stat", NULL, "nr_periods",
+		&periods) == 0) &&
+		(cgroup_read_key(dir, "cpu.stat", NULL, "nr_throttled",
+		&throttled) == 0) &&
+		(cgroup_read_key(dir, "cpu.stat", NULL, "throttled_usec",
+		&throttled_us) == 0))
+		printf(", throttled %llu/%llu periods (%.1fms)",
+			throttled, periods, (double) throttled_us / 1000.0);
+	if (cgroup_read_key(dir, "cpu.pressure", "some", "total",
+		&psi_some) == 0)
+		printf(", PSI some %.2f%%", 100.0 *
+			(double) (psi_some - w->psi_some_start) / elapsed_us);
+	else
+		printf(", PSI n/a");
+	if (cgroup_read_key(dir, "cpu.pressure", "full", "total",
+		&psi_full) == 0)
+		printf(" full %.2f%%", 100.0 *
+			(double) (psi_full - w->psi_full_start) / elapsed_us);
+	printf("\n");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cgroup_deinit
+ * @BRIEF		move process back into its cgroup and remove
+ *			cpuloadgen cgroups.
+ * @DESCRIPTION		move process back into its cgroup and remove
+ *			cpuloadgen cgroups, and disable cpu controller in
+ *			parent subtree if it was enabled by cgroup_init().
+ *			Must be called once all load threads have exited.
+ *//*------------------------------------------------------------------------ */
+void cgroup_deinit(void)
+{
+	char dir[CGROUP_PATH_MAX + 16];
+	char orig[2 * CGROUP_PATH_MAX];
+	unsigned int cpu;
+
+	if (cgroup_workers == NULL)
+		return;
+
+	for (cpu = 0; cpu < cgroup_count; cpu++) {
+		if (!cgroup_workers[cpu].created)
+			continue;
+		snprintf(dir, sizeof(dir), "%s/cpu%u", cgroup_base, cpu);
+		if (rmdir(dir) != 0)
+			fprintf(stderr, "cpuloadgen: could not remove cgroup %s (%s)!\n",
+				dir, strerror(errno));
+	}
+
+	snprintf(orig, sizeof(orig), "%s%s", cgroup_mnt, cgroup_orig);
+	cgroup_write(orig, "cgroup.procs", "%d", (int) getpid());
+	if (rmdir(cgroup_base) != 0)
+		fprintf(stderr, "cpuloadgen: could not remove cgroup %s (%s)!\n",
+			cgroup_base, strerror(errno));
+	cgroup_cpu_restore();
+
+	free(cgroup_workers);
+	cgroup_workers = NULL;
+	cgroup_count = 0;
+}
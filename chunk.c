@@ -0,0 +1,120 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			chunk.c
+ * @Description			Adaptive busy loop chunk sizing
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <time.h>
+#include "chunk.h"
+
+
+/* Initial chunk, small enough to stay responsive on slow cores */
+#define CHUNK_ITERATIONS_INIT	1000
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		chunk_clock_ns
+ * @BRIEF		return monotonic time.
+ * @RETURNS		monotonic time (in nanoseconds)
+ * @DESCRIPTION		return monotonic time. CLOCK_MONOTONIC is served by
+ *			the vDSO (no system call), costing a few tens of
+ *			nanoseconds, i.e. a few 1e-5 of a 1ms chunk.
+ *			CLOCK_MONOTONIC_COARSE would be cheaper, but its tick
+ *			resolution is too coarse for 1ms chunks.
+ *//*------------------------------------------------------------------------ */
+uint64_t chunk_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		chunk_init
+ * @BRIEF		initialize chunk sizer.
+ * @param[out]		c: chunk sizer
+ * @param[in]		target_us: target time between two checks (us)
+ * @DESCRIPTION		initialize chunk sizer, and start timing first chunk.
+ *//*------------------------------------------------------------------------ */
+void chunk_init(chunk_sizer *c, unsigned int target_us)
+{
+	c->size = CHUNK_ITERATIONS_INIT;
+	c->target_ns = (uint64_t) target_us * 1000ULL;
+	c->last_ns = chunk_clock_ns();
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		chunk_update
+ * @BRIEF		time last chunk and rescale next one.
+ * @RETURNS		monotonic time (in nanoseconds)
+ * @param[in, out]	c: chunk sizer
+ * @DESCRIPTION		time last chunk and rescale next one towards target
+ *			interval. Rescaling is bounded to a factor of 2 per
+ *			chunk, so that a chunk stretched by preemption or an
+ *			interrupt does not collapse chunk size at once.
+ *			Returned time saves caller another clock read.
+ *//*------------------------------------------------------------------------ */
+uint64_t chunk_update(chunk_sizer *c)
+{
+	uint64_t now, elapsed, size;
+
+	now = chunk_clock_ns();
+	elapsed = now - c->last_ns;
+	c->last_ns = now;
+	if (elapsed == 0)
+		elapsed = 1;
+
+	size = ((uint64_t) c->size * c->target_ns) / elapsed;
+	if (size > 2 * (uint64_t) c->size)
+		size = 2 * (uint64_t) c->size;
+	else if (size < c->size / 2)
+		size = c->size / 2;
+	if (size < CHUNK_ITERATIONS_MIN)
+		size = CHUNK_ITERATIONS_MIN;
+	else if (size > CHUNK_ITERATIONS_MAX)
+		size = CHUNK_ITERATIONS_MAX;
+	c->size = (unsigned int) size;
+
+	return now;
+}
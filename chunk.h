@@ -0,0 +1,74 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			chunk.h
+ * @Description			Adaptive busy loop chunk sizing
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_CHUNK_H__
+#define __CPULOADGEN_CHUNK_H__
+
+
+#include <stdint.h>
+
+
+#define CHUNK_TARGET_US		1000
+#define CHUNK_ITERATIONS_MIN	100
+#define CHUNK_ITERATIONS_MAX	100000000
+
+
+/*
+ * Busy loop chunk sizer: number of kernel iterations to run between two
+ * time checks, rescaled after each chunk so that time is checked about
+ * every target interval whatever the core speed.
+ */
+typedef struct {
+	unsigned int size;
+	uint64_t target_ns;
+	uint64_t last_ns;
+} chunk_sizer;
+
+
+uint64_t chunk_clock_ns(void);
+void chunk_init(chunk_sizer *c, unsigned int target_us);
+uint64_t chunk_update(chunk_sizer *c);
+
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			coherence.c
+ * @Description			Cache line ping-pong and false sharing
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "coherence.h"
+#include "idle.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define COHERENCE_SLOTS_PER_LINE	(COHERENCE_CACHE_LINE / sizeof(uint64_t))
+#define C2C_WARMUP_DIVIDER		10
+
+
+typedef struct {
+	unsigned int cpu;
+	unsigned int roundtrips;
+	unsigned int first;
+	volatile uint64_t *flag;
+	volatile int *stop;
+	struct timespec start;
+	struct timespec end;
+} c2c_thread;
+
+
+static const char *coherence_names[COHERENCE_MODES_COUNT] = {
+	"true",
+	"false",
+	"padded"
+};
+
+static coherence_mode mode = COHERENCE_TRUE;
+static uint64_t *counters = NULL;
+static unsigned int stride = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_parse
+ * @BRIEF		convert sharing mode name into sharing mode.
+ * @RETURNS		sharing mode
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: sharing mode name
+ * @DESCRIPTION		convert sharing mode name into sharing mode.
+ *//*------------------------------------------------------------------------ */
+int coherence_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < COHERENCE_MODES_COUNT; i++) {
+		if (strcmp(name, coherence_names[i]) == 0)
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_name
+ * @BRIEF		return sharing mode name.
+ * @RETURNS		sharing mode name
+ * @param[in]		m: sharing mode
+ * @DESCRIPTION		return sharing mode name.
+ *//*------------------------------------------------------------------------ */
+const char *coherence_name(coherence_mode m)
+{
+	if ((m < 0) || (m >= COHERENCE_MODES_COUNT))
+		return "unknown";
+	return coherence_names[m];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_init
+ * @BRIEF		allocate shared counters.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		m: sharing mode
+ * @param[in]		slots: number of load threads
+ * @DESCRIPTION		allocate shared counters, cache line aligned: a
+ *			single counter for all threads (true sharing), one
+ *			counter per thread packed into as few cache lines as
+ *			possible (false sharing), or one counter per thread
+ *			on its own cache line (padded).
+ *//*------------------------------------------------------------------------ */
+int coherence_init(coherence_mode m, unsigned int slots)
+{
+	size_t size;
+	int ret;
+
+	mode = m;
+	switch (mode) {
+	case COHERENCE_TRUE:
+		stride = 0;
+		size = COHERENCE_CACHE_LINE;
+		break;
+	case COHERENCE_FALSE:
+		stride = 1;
+		size = ((slots + COHERENCE_SLOTS_PER_LINE - 1) /
+			COHERENCE_SLOTS_PER_LINE) * COHERENCE_CACHE_LINE;
+		break;
+	case COHERENCE_PADDED:
+	default:
+		stride = COHERENCE_SLOTS_PER_LINE;
+		size = slots * COHERENCE_CACHE_LINE;
+		break;
+	}
+
+	ret = posix_memalign((void **) &counters, COHERENCE_CACHE_LINE, size);
+	if (ret != 0) {
+		counters = NULL;
+		return -ret;
+	}
+	memset(counters, 0, size);
+	dprintf("%s(): %s sharing, %u slots, %zu bytes\n", __func__,
+		coherence_names[mode], slots, size);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_deinit
+ * @BRIEF		release shared counters.
+ * @DESCRIPTION		release shared counters.
+ *//*------------------------------------------------------------------------ */
+void coherence_deinit(void)
+{
+	free(counters);
+	counters = NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_touch
+ * @BRIEF		increment counter of a load thread.
+ * @param[in]		slot: load thread index
+ * @param[in]		count: number of increments
+ * @DESCRIPTION		atomically increment counter of a load thread, so
+ *			that each increment needs the cache line in exclusive
+ *			state. Only cache line placement differs between
+ *			sharing modes.
+ *//*------------------------------------------------------------------------ */
+void coherence_touch(unsigned int slot, unsigned int count)
+{
+	uint64_t *p = &counters[slot * stride];
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		__atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		c2c_thread_run
+ * @BRIEF		core-to-core ping-pong thread.
+ * @param[in]		ptr: pointer to thread context
+ * @DESCRIPTION		core-to-core ping-pong thread: wait for the shared
+ *			flag to reach own turn, then hand it over by
+ *			incrementing it, so that each round trip moves the
+ *			cache line twice. First rounds are a warm-up.
+ *//*------------------------------------------------------------------------ */
+static void *c2c_thread_run(void *ptr)
+{
+	c2c_thread *t = (c2c_thread *) ptr;
+	unsigned int warmup, r;
+	uint64_t turn;
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(t->cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+
+	warmup = t->roundtrips / C2C_WARMUP_DIVIDER;
+	for (r = 0; r < warmup + t->roundtrips; r++) {
+		if (r == warmup)
+			clock_gettime(CLOCK_MONOTONIC, &t->start);
+		turn = 2 * (uint64_t) r + (t->first ? 0 : 1);
+		while (__atomic_load_n(t->flag, __ATOMIC_ACQUIRE) != turn) {
+			if (*t->stop)
+				return NULL;
+			cpu_relax();
+		}
+		__atomic_store_n(t->flag, turn + 1, __ATOMIC_RELEASE);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t->end);
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		c2c_pair
+ * @BRIEF		measure one-way cache line transfer latency.
+ * @RETURNS		one-way latency (in nanoseconds)
+ *			< 0 in case of failure (-errno)
+ * @param[in]		cpu_a: first CPU core ID
+ * @param[in]		cpu_b: second CPU core ID
+ * @param[in]		roundtrips: number of measured round trips
+ * @DESCRIPTION		measure one-way cache line transfer latency between
+ *			two CPU cores, as half of ping-pong round trip time.
+ *//*------------------------------------------------------------------------ */
+static double c2c_pair(int cpu_a, int cpu_b, unsigned int roundtrips)
+{
+	c2c_thread a, b;
+	volatile int stop = 0;
+	uint64_t *flag;
+	pthread_t ta, tb;
+	double ns;
+	int ret;
+
+	ret = posix_memalign((void **) &flag, COHERENCE_CACHE_LINE,
+		COHERENCE_CACHE_LINE);
+	if (ret != 0)
+		return -ret;
+	*flag = 0;
+
+	a.cpu = cpu_a;
+	b.cpu = cpu_b;
+	a.roundtrips = b.roundtrips = roundtrips;
+	a.first = 1;
+	b.first = 0;
+	a.flag = b.flag = flag;
+	a.stop = b.stop = &stop;
+	ret = pthread_create(&ta, NULL, c2c_thread_run, &a);
+	if (ret != 0) {
+		free(flag);
+		return -ret;
+	}
+	ret = pthread_create(&tb, NULL, c2c_thread_run, &b);
+	if (ret != 0) {
+		stop = 1;
+		pthread_join(ta, NULL);
+		free(flag);
+		return -ret;
+	}
+	pthread_join(ta, NULL);
+	pthread_join(tb, NULL);
+	free(flag);
+
+	ns = ((double) (a.end.tv_sec - a.start.tv_sec)) * 1.0e9 +
+		(double) (a.end.tv_nsec - a.start.tv_nsec);
+
+	return ns / (2.0 * (double) roundtrips);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_c2c
+ * @BRIEF		measure and display core-to-core latency matrix.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpus: CPU core IDs
+ * @param[in]		count: number of CPU cores
+ * @param[in]		roundtrips: number of measured round trips per pair
+ * @DESCRIPTION		measure and display core-to-core latency matrix
+ *			(one-way cache line transfer latency, in nanoseconds)
+ *			between all pairs of given CPU cores.
+ *//*------------------------------------------------------------------------ */
+int coherence_c2c(const int *cpus, unsigned int count,
+	unsigned int roundtrips)
+{
+	unsigned int i, j;
+	double ns;
+
+	if (count < 2) {
+		fprintf(stderr,
+			"cpuloadgen: core-to-core latency needs at least 2 CPU cores!\n");
+		return -EINVAL;
+	}
+
+	printf("Core-to-core latency (ns, one-way, %u round trips):\n",
+		roundtrips);
+	printf("%6s", "");
+	for (j = 0; j < count; j++)
+		printf(" %7s%-3d", "CPU", cpus[j]);
+	printf("\n");
+	for (i = 0; i < count; i++) {
+		printf("CPU%-3d", cpus[i]);
+		for (j = 0; j < count; j++) {
+			if (i == j) {
+				printf(" %10s", "-");
+				continue;
+			}
+			ns = c2c_pair(cpus[i], cpus[j], roundtrips);
+			if (ns < 0.0) {
+				printf("\n");
+				fprintf(stderr,
+					"cpuloadgen: CPU%d-CPU%d ping-pong failed! (%d)\n",
+					cpus[i], cpus[j], (int) ns);
+				return (int) ns;
+			}
+			printf(" %10.1f", ns);
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,749 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			coord.c
+ * @Description			Multi-host coordinator and agent
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "scenario.h"
+#include "coord.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define COORD_LINE_MAX		1100
+#define COORD_NAME_MAX		64
+#define COORD_SYNC_ROUNDS	16
+#define COORD_START_DELAY_MS	500
+
+
+typedef enum {
+	COORD_CONNECTED,
+	COORD_READY,
+	COORD_DONE
+} coord_state;
+
+
+/* Connection, with line buffer */
+typedef struct {
+	int fd;
+	char buf[COORD_LINE_MAX];
+	size_t len;
+	char name[COORD_NAME_MAX];
+	coord_state state;
+} coord_conn;
+
+
+/* Agent side */
+static coord_conn agent = {.fd = -1};
+static long long clock_offset_ns = 0;	/* coordinator - agent */
+static pthread_t watcher;
+static int watcher_running = 0;
+static volatile int closing = 0;
+static void (*stop_cb)(void) = NULL;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		realtime_ns
+ * @BRIEF		return current CLOCK_REALTIME time.
+ * @RETURNS		current CLOCK_REALTIME time, in nanoseconds
+ * @DESCRIPTION		return current CLOCK_REALTIME time, the only clock
+ *			comparable across hosts.
+ *//*------------------------------------------------------------------------ */
+static long long realtime_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		conn_send
+ * @BRIEF		send a formatted line.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		fd: socket
+ * @param[in]		fmt: line format (without newline)
+ * @DESCRIPTION		send a formatted line, appending newline.
+ *//*------------------------------------------------------------------------ */
+static int conn_send(int fd, const char *fmt, ...)
+{
+	char line[COORD_LINE_MAX];
+	va_list ap;
+	ssize_t ret;
+	size_t len, off = 0;
+
+	va_start(ap, fmt);
+	len = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+	va_end(ap);
+	if (len > sizeof(line) - 2)
+		len = sizeof(line) - 2;
+	line[len++] = '\n';
+
+	while (off < len) {
+		ret = send(fd, line + off, len - off, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		off += ret;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		conn_fill
+ * @BRIEF		read available data into connection buffer.
+ * @RETURNS		number of bytes read, 0 if connection closed
+ *			-errno in case of failure
+ * @param[in, out]	c: connection
+ * @DESCRIPTION		read available data into connection buffer (single
+ *			read() call, blocking if no data is available).
+ *//*------------------------------------------------------------------------ */
+static int conn_fill(coord_conn *c)
+{
+	ssize_t ret;
+
+	if (c->len >= sizeof(c->buf) - 1)
+		return -EMSGSIZE;
+	ret = read(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+	if (ret < 0)
+		return -errno;
+	c->len += ret;
+
+	return (int) ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		conn_line
+ * @BRIEF		extract a line from connection buffer.
+ * @RETURNS		1 if a line was extracted, 0 if none is complete
+ * @param[in, out]	c: connection
+ * @param[out]		line: line, without newline
+ * @DESCRIPTION		extract a line from connection buffer.
+ *//*------------------------------------------------------------------------ */
+static int conn_line(coord_conn *c, char line[COORD_LINE_MAX])
+{
+	char *nl;
+	size_t n;
+
+	nl = memchr(c->buf, '\n', c->len);
+	if (nl == NULL)
+		return 0;
+	n = nl - c->buf;
+	memcpy(line, c->buf, n);
+	line[n] = '\0';
+	c->len -= n + 1;
+	memmove(c->buf, nl + 1, c->len);
+
+	return 1;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		conn_getline
+ * @BRIEF		wait for a line.
+ * @RETURNS		0 on success
+ *			-errno in case of failure (-ECONNRESET if closed)
+ * @param[in, out]	c: connection
+ * @param[out]		line: line, without newline
+ * @DESCRIPTION		wait for a line. Waiting ends early (-EINTR) if
+ *			interrupted by a signal.
+ *//*------------------------------------------------------------------------ */
+static int conn_getline(coord_conn *c, char line[COORD_LINE_MAX])
+{
+	struct pollfd pfd;
+	int ret;
+
+	pfd.fd = c->fd;
+	pfd.events = POLLIN;
+	while (conn_line(c, line) == 0) {
+		/* Unlike read(), poll() is never restarted after a signal */
+		if (poll(&pfd, 1, -1) < 0)
+			return -errno;
+		ret = conn_fill(c);
+		if (ret <= 0)
+			return (ret == 0) ? -ECONNRESET : ret;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_send_scenario
+ * @BRIEF		send scenario file to an agent.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		fd: agent socket
+ * @param[in]		filename: scenario file name
+ * @DESCRIPTION		send scenario file to an agent, one "S <line>" per
+ *			line, then "E".
+ *//*------------------------------------------------------------------------ */
+static int coord_send_scenario(int fd, const char *filename)
+{
+	char line[COORD_LINE_MAX - 2];
+	FILE *fp;
+	int ret = 0;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL)
+		return -errno;
+	while ((ret == 0) && (fgets(line, sizeof(line), fp) != NULL)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		ret = conn_send(fd, "S %s", line);
+	}
+	fclose(fp);
+	if (ret != 0)
+		return ret;
+
+	return conn_send(fd, "E");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_phase_offset_ns
+ * @BRIEF		return scheduled start of a scenario phase.
+ * @RETURNS		scheduled start of phase, relative to scenario start
+ *			(in nanoseconds)
+ * @param[in]		phase: phase number
+ * @DESCRIPTION		return scheduled start of a scenario phase.
+ *//*------------------------------------------------------------------------ */
+static long long coord_phase_offset_ns(unsigned int phase)
+{
+	const scenario_phase *ph;
+	double s = 0.0;
+	unsigned int k;
+
+	for (k = 0; k < phase; k++) {
+		ph = scenario_get(k);
+		if (ph != NULL)
+			s += ph->duration_s;
+	}
+
+	return (long long) (s * 1.0e9);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_listen
+ * @BRIEF		create coordinator listening socket.
+ * @RETURNS		socket on success
+ *			-errno in case of failure
+ * @param[in]		addr: "[ip:]port" (default ip: 127.0.0.1)
+ * @param[in]		agents: number of agents (listen backlog)
+ * @DESCRIPTION		create coordinator listening socket, on loopback
+ *			unless an address is given (0.0.0.0 for all).
+ *//*------------------------------------------------------------------------ */
+static int coord_listen(const char *addr, unsigned int agents)
+{
+	struct sockaddr_in sa;
+	char ip[INET_ADDRSTRLEN] = "127.0.0.1";
+	const char *port;
+	int fd, one = 1, n, ret;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	port = strrchr(addr, ':');
+	if (port != NULL) {
+		if ((size_t) (port - addr) >= sizeof(ip))
+			return -EINVAL;
+		memcpy(ip, addr, port - addr);
+		ip[port - addr] = '\0';
+		port++;
+	} else {
+		port = addr;
+	}
+	if ((inet_pton(AF_INET, ip, &sa.sin_addr) != 1) ||
+		(sscanf(port, "%d%n", &ret, &n) != 1) || (port[n] != '\0') ||
+		(ret < 1) || (ret > 65535))
+		return -EINVAL;
+	sa.sin_port = htons(ret);
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -errno;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if ((bind(fd, (struct sockaddr *) &sa, sizeof(sa)) != 0) ||
+		(listen(fd, agents) != 0)) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_serve
+ * @BRIEF		run coordinator.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		addr: "[ip:]port" to listen on (default ip:
+ *			127.0.0.1)
+ * @param[in]		agents: number of agents to wait for
+ * @param[in]		scenario_file: scenario file name (already loaded)
+ * @param[in]		halt: set when user requests to stop
+ * @DESCRIPTION		run coordinator: wait for given number of agents,
+ *			send them the scenario, answer their clock
+ *			synchronisation requests, and once all are ready,
+ *			send them a common start time (CLOCK_REALTIME of
+ *			coordinator, COORD_START_DELAY_MS ahead). Then
+ *			display their telemetry until all are done: phase
+ *			start offsets from schedule, and achieved loads.
+ *			On halt, agents are asked to stop. Agents leaving
+ *			before reporting they are done (e.g. crashed) fail
+ *			the run.
+ *//*------------------------------------------------------------------------ */
+int coord_serve(const char *addr, unsigned int agents,
+	const char *scenario_file, volatile sig_atomic_t *halt)
+{
+	coord_conn *conns;
+	struct pollfd *pfds;
+	struct sockaddr_in sa;
+	socklen_t salen;
+	char line[COORD_LINE_MAX];
+	long long start = 0, t;
+	unsigned int i, n, phase, ready = 0, done = 0, lost = 0;
+	int lfd, one = 1, ret = 0, step, cpu, load;
+	double achieved, dmips;
+
+	if ((agents < 1) || (agents > COORD_AGENTS_MAX))
+		return -EINVAL;
+	conns = calloc(agents, sizeof(coord_conn));
+	pfds = calloc(agents, sizeof(struct pollfd));
+	if ((conns == NULL) || (pfds == NULL)) {
+		free(conns);
+		free(pfds);
+		return -ENOMEM;
+	}
+	for (i = 0; i < agents; i++)
+		conns[i].fd = -1;
+
+	lfd = coord_listen(addr, agents);
+	if (lfd < 0) {
+		ret = lfd;
+		fprintf(stderr, "cpuloadgen: could not listen on %s (%s)!\n",
+			addr, strerror(-ret));
+		goto out;
+	}
+
+	printf("Waiting for %u agent(s) on %s...\n", agents, addr);
+	fflush(stdout);
+	pfds[0].fd = lfd;
+	pfds[0].events = POLLIN;
+	for (n = 0; n < agents; ) {
+		/* accept() would be restarted after CTRL+C, poll() is not */
+		if (poll(pfds, 1, -1) < 0) {
+			ret = -errno;
+			if ((ret == -EINTR) && (!*halt))
+				continue;
+			goto out;
+		}
+		salen = sizeof(sa);
+		conns[n].fd = accept(lfd, (struct sockaddr *) &sa, &salen);
+		if (conns[n].fd < 0)
+			continue;
+		setsockopt(conns[n].fd, IPPROTO_TCP, TCP_NODELAY, &one,
+			sizeof(one));
+		snprintf(conns[n].name, sizeof(conns[n].name), "%s:%u",
+			inet_ntoa(sa.sin_addr), ntohs(sa.sin_port));
+		printf("Agent %u connected (%s).\n", n, conns[n].name);
+		ret = coord_send_scenario(conns[n].fd, scenario_file);
+		if (ret != 0)
+			goto out;
+		n++;
+	}
+
+	while ((done < agents) && (!*halt)) {
+		for (i = 0; i < agents; i++) {
+			pfds[i].fd = (conns[i].state == COORD_DONE) ?
+				-1 : conns[i].fd;
+			pfds[i].events = POLLIN;
+		}
+		if (poll(pfds, agents, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			break;
+		}
+		for (i = 0; i < agents; i++) {
+			if ((pfds[i].fd < 0) || (pfds[i].revents == 0))
+				continue;
+			if (conn_fill(&conns[i]) <= 0) {
+				if (start == 0)
+					goto left;
+				fprintf(stderr,
+					"cpuloadgen: agent %u (%s) disconnected before done!\n",
+					i, conns[i].name);
+				conns[i].state = COORD_DONE;
+				done++;
+				lost++;
+				continue;
+			}
+			while (conn_line(&conns[i], line)) {
+				if (sscanf(line, "SYNC %lld", &t) == 1) {
+					conn_send(conns[i].fd, "TIME %lld %lld",
+						t, realtime_ns());
+				} else if (strcmp(line, "READY") == 0) {
+					conns[i].state = COORD_READY;
+					if (++ready < agents)
+						continue;
+					start = realtime_ns() +
+						COORD_START_DELAY_MS * 1000000LL;
+					for (n = 0; n < agents; n++)
+						conn_send(conns[n].fd,
+							"START %lld", start);
+					printf("All agents ready, starting in %dms.\n",
+						COORD_START_DELAY_MS);
+				} else if (strcmp(line, "DONE") == 0) {
+					if (start == 0)
+						goto left;
+					printf("Agent %u (%s) done.\n", i,
+						conns[i].name);
+					conns[i].state = COORD_DONE;
+					done++;
+					break;
+				} else if (sscanf(line, "PHASE %u %lld",
+					&phase, &t) == 2) {
+					printf("Agent %u: phase %u started %+.3fms from schedule\n",
+						i, phase, (double) (t - start -
+						coord_phase_offset_ns(phase)) /
+						1.0e6);
+				} else if (sscanf(line, "STEP %d %d %d %lf %lf",
+					&step, &cpu, &load, &achieved,
+					&dmips) == 5) {
+					printf("Agent %u: phase %d: CPU%d requested %3d%%, achieved %5.1f%%, %.1f DMIPS\n",
+						i, step, cpu, load, achieved,
+						dmips);
+				} else {
+					printf("Agent %u: %s\n", i, line);
+				}
+			}
+			fflush(stdout);
+		}
+	}
+	if ((ret == 0) && (lost != 0))
+		ret = -ECONNRESET;
+	goto out;
+
+left:
+	fprintf(stderr, "cpuloadgen: agent %u (%s) left before start!\n",
+		i, conns[i].name);
+	conns[i].state = COORD_DONE;
+	ret = -ECONNRESET;
+out:
+	for (i = 0; i < agents; i++) {
+		if (conns[i].fd < 0)
+			continue;
+		if (conns[i].state != COORD_DONE)
+			conn_send(conns[i].fd, "STOP");
+		close(conns[i].fd);
+	}
+	if (lfd >= 0)
+		close(lfd);
+	free(conns);
+	free(pfds);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_connect
+ * @BRIEF		connect to coordinator and retrieve scenario.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		addr: coordinator address ("host:port")
+ * @param[out]		scenario: scenario file content (to be freed)
+ * @param[out]		len: scenario file content length
+ * @DESCRIPTION		connect to coordinator and retrieve scenario.
+ *//*------------------------------------------------------------------------ */
+int coord_agent_connect(const char *addr, char **scenario, size_t *len)
+{
+	struct addrinfo hints, *res, *ai;
+	char host[COORD_NAME_MAX], line[COORD_LINE_MAX];
+	const char *port;
+	char *buf = NULL, *tmp;
+	size_t size = 0, n = 0, l;
+	int one = 1, ret;
+
+	port = strrchr(addr, ':');
+	if ((port == NULL) || (port == addr) || (port[1] == '\0') ||
+		((size_t) (port - addr) >= sizeof(host)))
+		return -EINVAL;
+	memcpy(host, addr, port - addr);
+	host[port - addr] = '\0';
+	port++;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	ret = getaddrinfo(host, port, &hints, &res);
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: could not resolve %s (%s)!\n",
+			addr, gai_strerror(ret));
+		return -EHOSTUNREACH;
+	}
+	for (ai = res; ai != NULL; ai = ai->ai_next) {
+		agent.fd = socket(ai->ai_family, ai->ai_socktype,
+			ai->ai_protocol);
+		if (agent.fd < 0)
+			continue;
+		if (connect(agent.fd, ai->ai_addr, ai->ai_addrlen) == 0)
+			break;
+		close(agent.fd);
+		agent.fd = -1;
+	}
+	freeaddrinfo(res);
+	if (agent.fd < 0) {
+		fprintf(stderr, "cpuloadgen: could not connect to %s!\n", addr);
+		return -ECONNREFUSED;
+	}
+	setsockopt(agent.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	agent.len = 0;
+	snprintf(agent.name, sizeof(agent.name), "%s", addr);
+
+	while ((ret = conn_getline(&agent, line)) == 0) {
+		if (strcmp(line, "E") == 0)
+			break;
+		if (strncmp(line, "S ", 2) != 0) {
+			ret = -EPROTO;
+			break;
+		}
+		l = strlen(line + 2);
+		if (n + l + 2 > size) {
+			size = (size == 0) ? 4096 : size * 2;
+			size = (size < n + l + 2) ? n + l + 2 : size;
+			tmp = realloc(buf, size);
+			if (tmp == NULL) {
+				ret = -ENOMEM;
+				break;
+			}
+			buf = tmp;
+		}
+		memcpy(buf + n, line + 2, l);
+		n += l;
+		buf[n++] = '\n';
+		buf[n] = '\0';
+	}
+	if ((ret != 0) || (buf == NULL)) {
+		fprintf(stderr, "cpuloadgen: could not retrieve scenario from %s!\n",
+			addr);
+		free(buf);
+		coord_agent_close();
+		return (ret != 0) ? ret : -EPROTO;
+	}
+	*scenario = buf;
+	*len = n;
+	dprintf("%s(): %zu bytes of scenario received\n", __func__, n);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_watch
+ * @BRIEF		coordinator watcher thread.
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		coordinator watcher thread: call stop callback when
+ *			coordinator asks to stop, or goes away.
+ *//*------------------------------------------------------------------------ */
+static void *coord_agent_watch(void *ptr)
+{
+	char line[COORD_LINE_MAX];
+
+	(void) ptr;
+	while (conn_getline(&agent, line) == 0) {
+		if (strcmp(line, "STOP") == 0)
+			break;
+	}
+	if ((!closing) && (stop_cb != NULL))
+		stop_cb();
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_start
+ * @BRIEF		synchronise with coordinator and get start time.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[out]		start: scenario start time (CLOCK_MONOTONIC)
+ * @param[in]		stop: callback called if coordinator asks to stop
+ * @DESCRIPTION		synchronise with coordinator and get start time:
+ *			estimate clock offset (NTP-like: offset of the
+ *			exchange with the shortest round trip among
+ *			COORD_SYNC_ROUNDS), report ready, wait for the common
+ *			start time, and convert it into local monotonic time.
+ *			Then watch coordinator for stop requests.
+ *//*------------------------------------------------------------------------ */
+int coord_agent_start(struct timespec *start, void (*stop)(void))
+{
+	char line[COORD_LINE_MAX];
+	long long t0, t1, t2, echo, rtt, best = LLONG_MAX, ns;
+	struct timespec now;
+	int i, ret;
+
+	for (i = 0; i < COORD_SYNC_ROUNDS; i++) {
+		t0 = realtime_ns();
+		ret = conn_send(agent.fd, "SYNC %lld", t0);
+		if (ret == 0)
+			ret = conn_getline(&agent, line);
+		t2 = realtime_ns();
+		if (ret != 0)
+			return ret;
+		if ((sscanf(line, "TIME %lld %lld", &echo, &t1) != 2) ||
+			(echo != t0))
+			return -EPROTO;
+		rtt = t2 - t0;
+		if (rtt < best) {
+			best = rtt;
+			clock_offset_ns = t1 - (t0 + t2) / 2;
+		}
+	}
+	printf("Clock offset to coordinator: %+.3fms (round trip %.3fms)\n",
+		(double) clock_offset_ns / 1.0e6, (double) best / 1.0e6);
+
+	ret = conn_send(agent.fd, "READY");
+	if (ret == 0)
+		ret = conn_getline(&agent, line);
+	if (ret != 0)
+		return ret;
+	if (sscanf(line, "START %lld", &t0) != 1)
+		return (strcmp(line, "STOP") == 0) ? -ECANCELED : -EPROTO;
+
+	/* Coordinator realtime -> local realtime -> local monotonic */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (long long) now.tv_sec * 1000000000LL + now.tv_nsec +
+		(t0 - clock_offset_ns) - realtime_ns();
+	start->tv_sec = ns / 1000000000LL;
+	start->tv_nsec = ns % 1000000000LL;
+
+	stop_cb = stop;
+	closing = 0;
+	if (pthread_create(&watcher, NULL, coord_agent_watch, NULL) == 0)
+		watcher_running = 1;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_time_ns
+ * @BRIEF		return current time of coordinator.
+ * @RETURNS		current CLOCK_REALTIME time of coordinator, estimated
+ *			from clock offset (in nanoseconds)
+ * @DESCRIPTION		return current time of coordinator.
+ *//*------------------------------------------------------------------------ */
+long long coord_agent_time_ns(void)
+{
+	return realtime_ns() + clock_offset_ns;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_report
+ * @BRIEF		send telemetry line to coordinator.
+ * @param[in]		fmt: line format (without newline)
+ * @DESCRIPTION		send telemetry line to coordinator, if connected.
+ *//*------------------------------------------------------------------------ */
+void coord_agent_report(const char *fmt, ...)
+{
+	char line[COORD_LINE_MAX];
+	va_list ap;
+
+	if (agent.fd < 0)
+		return;
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	conn_send(agent.fd, "%s", line);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_agent_close
+ * @BRIEF		disconnect from coordinator.
+ * @DESCRIPTION		report completion and disconnect from coordinator.
+ *//*------------------------------------------------------------------------ */
+void coord_agent_close(void)
+{
+	if (agent.fd < 0)
+		return;
+
+	closing = 1;
+	conn_send(agent.fd, "DONE");
+	shutdown(agent.fd, SHUT_RDWR);
+	if (watcher_running)
+		pthread_join(watcher, NULL);
+	watcher_running = 0;
+	close(agent.fd);
+	agent.fd = -1;
+}
@@ -46,7 +46,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
-#include "dhry.h"
 #include <sys/time.h>
 #include <time.h>
 #include <sys/types.h>
@@ -56,9 +55,75 @@
 #include <signal.h>
 #include <errno.h>
 #include <pthread.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "cgroup.h"
+#include "latency.h"
+#include "sampler.h"
+#include "perf.h"
+#include "idle.h"
+#include "dist.h"
+#include "request.h"
+#include "wsdeque.h"
+#include "lock.h"
+#include "coherence.h"
+#include "tlb.h"
+#include "sysload.h"
+#include "scenario.h"
+#include "coord.h"
+#include "results.h"
+#include "metrics.h"
+#include "tui.h"
+#include "hotplug.h"
+#include "energy.h"
+#include "libcpuloadgen.h"
+#include "chunk.h"
+#include "dhrystone.h"
 
 #define CPULOADGEN_REVISION ((const char *) "0.94")
 
+#define DEFAULT_PERIOD_US	100000
+#define PWM_CHUNK_ITERATIONS	1000
+#define NICE_UNSET		20
+#define THREADS_PER_CPU_MAX	256
+#define DEFAULT_SWEEP_DWELL	10
+#define DHRYSTONE_VAX_MIPS	1757.0
+#define DEFAULT_SAMPLE_INTERVAL_MS	100
+#define CALIBRATION_US		50000
+#define POOL_DEQUE_SIZE		16384
+#define POOL_BACKOFF_US		50
+#define DEFAULT_CS_US		1.0
+#define KERNEL_BATCH		16
+#define DEFAULT_C2C_ROUNDTRIPS	100000
+#define DEFAULT_CHUNKBENCH_S	10
+#define CHUNKBENCH_ROUNDS	10
+#define FIXED_CHUNK_ITERATIONS	1000000
+#define DEFAULT_DHRYBENCH_S	10
+
+#ifndef SCHED_IDLE
+#define SCHED_IDLE		5
+#endif
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE		6
+#endif
+
+/*
+ * glibc does not provide a sched_setattr() wrapper, hence the local
+ * definition of the kernel ABI structure.
+ */
+struct dl_sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+};
+
 
 /* #define DEBUG */
 #ifdef DEBUG
@@ -68,38 +133,202 @@
 #endif
 
 
-#ifndef ROPT
-#define REG
-#else
-#define REG register
-#endif
-
-/* Global Variables: */
-
-Rec_Pointer Ptr_Glob, Next_Ptr_Glob;
-int Int_Glob;
-Boolean Bool_Glob;
-char Ch_1_Glob, Ch_2_Glob;
-int Arr_1_Glob [50];
-int Arr_2_Glob [50][50];
-
-char Reg_Define[] = "Register option selected.";
-
-Enumeration     Func_1();
-/* forward declaration necessary since Enumeration may not simply be int */
-
 extern char *builddate;
-extern double dtime();
 
 
 int cpu_count = -1;
 int *cpuloads = NULL;
 long int duration = -1;
 pthread_t *threads = NULL;
-pthread_mutex_t mutex1 = PTHREAD_MUTEX_INITIALIZER;
+int policy = -1;
+int priority = -1;
+int nice_level = NICE_UNSET;
+long int period = -1;
+char *cgroup_parent = NULL;
+volatile sig_atomic_t halt = 0;
+volatile sig_atomic_t interrupted = 0;
+int threads_per_cpu = 1;
+long int wakeup_max = -1;
+int migrate = 0;
+long int probe_interval = -1;
+int probe_prio = 0;
+
+/* Per-thread statistics */
+typedef struct {
+	unsigned long long run_ns;
+	unsigned long long wait_ns;
+	unsigned long long slices;
+	unsigned long long vcsw;
+	unsigned long long ivcsw;
+	unsigned long long iterations;
+	double elapsed_s;
+	perf_counts perf;
+	unsigned long long tasks_produced;
+	unsigned long long tasks_run;
+	unsigned long long tasks_stolen;
+	unsigned long long depth_sum;
+	unsigned long long depth_samples;
+	unsigned long long depth_max;
+	unsigned long long tasks_left;
+	unsigned long long kernel_ops;
+	unsigned long long kernel_busy_ns;
+	unsigned long long syscalls;
+	unsigned long long io_reads;
+	unsigned long long repins;
+	unsigned long long parks;
+	unsigned long long parked_ns;
+} worker_stats;
+worker_stats *thread_stats = NULL;
+
+/* Load sweep */
+int sweep_start = -1;
+int sweep_stop = -1;
+int sweep_step = -1;
+long int sweep_dwell = DEFAULT_SWEEP_DWELL;
+long int sweep_cooldown = 0;
+FILE *sweep_csv = NULL;
+
+/* Power, frequency and thermal sampling */
+long int sample_interval = -1;
+char *samples_file = NULL;
+
+/* Hardware performance counters */
+int perf_enabled = 0;
+int perf_set = 0;		/* perf option given (tlb implies counters) */
+volatile int perf_warned = 0;
+
+/* Idle phase behaviour */
+int idle_set = 0;
+idle_mode idle = IDLE_SLEEP;
+int dma_latency = -1;
+
+/* Duty cycle jitter */
+dist jitter = { DIST_CONSTANT, 0.0 };
+int seed_set = 0;
+unsigned long long seed = 0;
+unsigned int run_index = 0;
+/* Per-thread generator, seeded from (seed, run_index, thread index) */
+__thread rng_state thread_rng;
+
+/* Open-loop request arrivals */
+double service_us = -1.0;
+dist service_dist = { DIST_CONSTANT, 0.0 };
+double request_rate = -1.0;
+char *trace_file = NULL;
+
+/* Work-stealing pool */
+double pool_task_us = -1.0;
+int pool_imbalance = 0;
+int pool_imbalance_set = 0;
+wsdeque *pool_deques = NULL;
+__thread unsigned int thread_idx;
+__thread metrics_worker *thread_metrics = NULL;
+__thread hotplug_worker thread_hotplug;
+/* Per-thread run accounting, from loadgen_thread_begin() to _end() */
+__thread perf_group thread_perf;
+__thread int thread_perf_ok;
+__thread worker_stats thread_sched_start;
+__thread struct timespec thread_ts_start;
+
+/* Load engine running the basic Dhrystone and TLB loads */
+cpuloadgen_engine *engine = NULL;
+unsigned int *engine_threads = NULL;	/* engine worker -> thread index */
+__thread int thread_throttled;
+__thread unsigned int thread_load;
+__thread unsigned long long thread_iterations;
+
+/* Lock contention */
+int lock_set = 0;
+lock_type lock_kind = LOCK_MUTEX;
+int lock_write_pct = 100;
+double cs_us = -1.0;
+double ncs_us = -1.0;
+
+/* Cache line ping-pong */
+int coherence_set = 0;
+coherence_mode coherence = COHERENCE_TRUE;
+long int c2c_roundtrips = -1;
+int chunkbench_s = -1;
+
+/* Dhrystone variant of load threads */
+dhry_variant dhrystone_variant = DHRY_FAITHFUL;
+int dhrystone_set = 0;
+int dhrybench_s = -1;
+
+/* TLB pressure */
+int tlb_set = 0;
+size_t tlb_footprint = 0;
+tlb_pages tlb_backing = TLB_PAGES_4K;
+
+/* System call and I/O wait load */
+int syscall_pct = 0;
+sysload_mix syscall_mix = SYSLOAD_ALL;
+int iowait_pct = 0;
+char *iowait_file = NULL;
+
+/* Multi-phase scenario */
+char *scenario_file = NULL;
+int scenario_start_set = 0;
+struct timespec scenario_start;
+
+/* Multi-host coordination */
+char *coord_bind = NULL;
+int coord_agents = -1;
+char *coord_addr = NULL;
+int coord_hooks = 0;
+pthread_t main_thread;
+
+/* Machine-readable results */
+char *results_file = NULL;
+
+/* OpenMetrics endpoint */
+char *metrics_addr = NULL;
 
-void dhryStone(unsigned int iterations);
-void loadgen(unsigned int cpu, unsigned int load, unsigned int duration);
+/* Live per-core load heatmap */
+int tui_set = 0;
+
+/* Energy per load level characterisation */
+int energy_set = 0;
+unsigned int energy_settle = DEFAULT_ENERGY_SETTLE;
+unsigned int energy_window = DEFAULT_ENERGY_WINDOW;
+unsigned int energy_windows = DEFAULT_ENERGY_WINDOWS;
+energy_step step_energy;
+
+unsigned long long loadgen(unsigned int cpu, unsigned int load,
+	unsigned int duration);
+static int loadgen_setup(unsigned int cpu, unsigned int load);
+static unsigned long long loadgen_requests(unsigned int cpu,
+	unsigned int load, unsigned int duration);
+static unsigned long long loadgen_pool(unsigned int cpu, unsigned int load,
+	unsigned int duration);
+typedef unsigned long long (*kernel_batch)(worker_stats *st, double ipus);
+static unsigned long long loadgen_kernel(unsigned int cpu, unsigned int load,
+	unsigned int duration, int throttled, kernel_batch batch,
+	int calibrate);
+static unsigned long long lock_batch(worker_stats *st, double ipus);
+static unsigned long long coherence_batch(worker_stats *st, double ipus);
+static unsigned long long tlb_batch(worker_stats *st, double ipus);
+static void sweep_step_report(int step);
+static void results_report(int step);
+static void results_config(void);
+static void sampler_report(void);
+static void perf_report(void);
+static void cstate_report(void);
+static void pool_report(void);
+static void lock_report(void);
+static void coherence_report(void);
+static void tlb_report(void);
+static void sysload_report(void);
+static int cpu_achieved(int cpu, double *achieved, double *dmips,
+	double *elapsed_s);
+static int loadgen_run(int step, const struct timespec *deadline);
+static int loadgen_sweep(void);
+static int loadgen_scenario(void);
+static int chunk_bench(int cpu, unsigned int duration);
+static int dhry_bench(int cpu, unsigned int duration);
+static void timespec_add_us(struct timespec *ts, double us);
+static double timespec_diff_us(const struct timespec *a,
+	const struct timespec *b);
 
 /* ------------------------------------------------------------------------*//**
  * @FUNCTION		usage
@@ -109,20 +338,190 @@ void loadgen(unsigned int cpu, unsigned int load, unsigned int duration);
 static void usage(void)
 {
 	printf("Usage:\n");
-	printf("\tcpuloadgen [<cpu[n]=load>] [<duration=time>]\n\n");
+	printf("\tcpuloadgen [<cpu[n]=load>] [<duration=time>] [<period=us>]\n");
+	printf("\t\t[<policy=other|batch|idle|fifo|rr|deadline>] [<prio=n>] [<nice=n>]\n");
+	printf("\t\t[<cgroup=path>] [<threads=n>] [<wakeup=us>] [<migrate>]\n");
+	printf("\t\t[<probe=us>] [<probeprio=n>]\n");
+	printf("\t\t[<sweep=start:stop:step[,dwell=s][,cooldown=s]>] [<csv=file>]\n");
+	printf("\t\t[<energy[=settle:window:windows]>]\n");
+	printf("\t\t[<sample=ms>] [<samples=file>] [<perf>]\n");
+	printf("\t\t[<idle=sleep|pause|yield|tpause>] [<dmalatency=us>]\n");
+	printf("\t\t[<jitter=uniform|exponential|lognormal|pareto[:shape]>] [<seed=n>]\n");
+	printf("\t\t[<service=us[,dist=name[:shape]]>] [<rate=n>] [<trace=file>]\n");
+	printf("\t\t[<pool=us>] [<imbalance=n>]\n");
+	printf("\t\t[<lock=mutex|spin|ticket|mcs|rwlock[:write%%]|atomic>] [<cs=us>] [<ncs=us>]\n");
+	printf("\t\t[<pingpong=true|false|padded>] [<c2c[=roundtrips]>] [<chunkbench[=s]>]\n");
+	printf("\t\t[<dhrystone=faithful|power>] [<dhrybench[=s]>]\n");
+	printf("\t\t[<tlb=MB[,pages=4k|thp|huge]>]\n");
+	printf("\t\t[<syscall=%%[,mix=getpid|rw|pipe|futex|all]>] [<iowait=%%[,file=path]>]\n");
+	printf("\t\t[<scenario=file>] [<coordinator=[ip:]port> <agents=n>]\n");
+	printf("\t\t[<agent=host:port> [<hooks>]]\n");
+	printf("\t\t[<results=file>] [<metrics=[ip:]port|path>] [<tui>]\n\n");
 	printf("Generate adjustable processing load on selected CPU core(s) for a given duration.\n");
 	printf("Load is a percentage which may be any integer value between 1 and 100.\n");
 	printf("Duration time unit is seconds.\n");
 	printf("Arguments may be provided in any order.\n");
 	printf("If duration is omitted, generate load(s) until CTRL+C is pressed.\n");
-	printf("If no argument is given, generate 100%% load on all online CPU cores indefinitely.\n\n");
+	printf("If no argument is given, generate 100%% load on all online CPU cores indefinitely.\n");
+	printf("Period is the PWM period in microseconds ([1-%ld], default: 100ms).\n",
+		PERIOD_MAX_US);
+	printf("Policy selects the scheduling policy of the load threads (default: other).\n");
+	printf("Prio is the real-time priority ([1-99]) used with fifo and rr policies.\n");
+	printf("Nice is the nice level ([-20-19]) used with other and batch policies.\n");
+	printf("With deadline policy, runtime and period are derived from load and period,\n");
+	printf("and the kernel enforces the duty cycle.\n");
+	printf("Cgroup is a cgroup v2 directory under which each load thread is moved into its own\n");
+	printf("child cgroup, throttled by cpu.max. Achieved load, throttling and pressure are reported.\n");
+	printf("Threads is the number of load threads per selected CPU core ([1-%d]), each running\n",
+		THREADS_PER_CPU_MAX);
+	printf("its own PWM loop at the core load (oversubscription).\n");
+	printf("Wakeup splits PWM idle time into random sleeps of at most the given microseconds.\n");
+	printf("Migrate does not pin load threads, letting the scheduler migrate them.\n");
+	printf("Otherwise, load threads are pinned again after CPU hotplug or cpuset changes, and\n");
+	printf("parked while their CPU core is offline or out of cpuset (reported per core).\n");
+	printf("With threads, wakeup or migrate, runqueue delay and context switch rate are reported.\n");
+	printf("Probe starts a wakeup latency probe thread on each loaded CPU core, waking up every\n");
+	printf("given microseconds (cyclictest-like). Latency percentiles are reported per core.\n");
+	printf("Probeprio runs probe threads with SCHED_FIFO at given priority ([1-99]).\n");
+	printf("Sweep steps load of selected CPU cores (all if none) from start to stop (in %%),\n");
+	printf("each step lasting dwell seconds (default %d), optionally followed by cooldown\n",
+		DEFAULT_SWEEP_DWELL);
+	printf("seconds without load. Achieved load and DMIPS are reported per step.\n");
+	printf("Csv saves sweep results (and latency percentiles if probe is set) into file.\n");
+	printf("Energy characterises each sweep step: after settle seconds (default %d), it integrates\n",
+		DEFAULT_ENERGY_SETTLE);
+	printf("RAPL (powercap) package energy over windows (default %d) of window seconds (default %d),\n",
+		DEFAULT_ENERGY_WINDOWS, DEFAULT_ENERGY_WINDOW);
+	printf("and reports average power and energy per Dhrystone iteration (all loaded CPU cores)\n");
+	printf("with their 95%% confidence interval across windows. It sets sweep dwell accordingly.\n");
+	printf("Sample samples CPU frequency, temperature, RAPL energy and C-state residency\n");
+	printf("every given milliseconds (default %d). Averages are reported per run or sweep step.\n",
+		DEFAULT_SAMPLE_INTERVAL_MS);
+	printf("Samples saves timestamped samples and load phases into file.\n");
+	printf("Perf collects cycles, instructions, IPC, cache, branch and dTLB misses of each load\n");
+	printf("thread (perf_event_open), reported per run or sweep step.\n");
+	printf("Idle selects how PWM idle time is spent: sleeping (default), or spinning with\n");
+	printf("pause (cpu_relax), sched_yield() or tpause (C0.2, falls back to pause if not supported).\n");
+	printf("Dmalatency holds /dev/cpu_dma_latency at given microseconds during the whole run,\n");
+	printf("preventing deeper C-states. With idle or dmalatency, C-state residency is reported.\n");
+	printf("Jitter draws each PWM busy and idle time from given distribution, keeping their mean.\n");
+	printf("Shape is uniform half-width ((0-1], default 1), lognormal sigma (default 1) or\n");
+	printf("Pareto alpha (> 1, default 2.5).\n");
+	printf("Seed seeds jitter and wakeup random generators, to reproduce a run (default: time).\n");
+	printf("Service switches to open-loop request mode: each load thread serves requests arriving\n");
+	printf("as a Poisson process, each running Dhrystone loops for a service time drawn from dist\n");
+	printf("(default: constant) with given mean (us). Arrival rate is derived from load, unless\n");
+	printf("rate (requests/s per thread) is set. Trace replays inter-arrival times (us, one per line).\n");
+	printf("Utilisation, throughput, backlog, response time and queueing delay are reported.\n");
+	printf("Pool switches to a thread pool mode: each period, load threads push tasks of given\n");
+	printf("duration (us) into their own lock-free deque, and run them, stealing from others when\n");
+	printf("theirs is empty. Imbalance is the share (in %%) of all tasks produced by the first\n");
+	printf("thread instead. Steals, queue depth and utilisation are reported.\n");
+	printf("Lock makes load threads contend on a shared lock during PWM active time, holding it\n");
+	printf("cs us (default 1), then working ncs us (default 0) outside of it. Rwlock takes write%%\n");
+	printf("(default 10) write locks. Throughput and fairness (Jain index) are reported.\n");
+	printf("Pingpong makes load threads atomically increment counters during PWM active time:\n");
+	printf("a single shared one (true), one per thread in the same cache line (false), or one per\n");
+	printf("thread in its own cache line (padded). Increment rate and latency are reported.\n");
+	printf("C2c only measures the core-to-core cache line transfer latency between all pairs of\n");
+	printf("selected CPU cores (all if none) with given round trips (default %d), then exits.\n",
+		DEFAULT_C2C_ROUNDTRIPS);
+	printf("Chunkbench only compares 100%% load throughput of fixed Dhrystone chunks and of\n");
+	printf("the load engine, along with their time check interval and stop latency, on the\n");
+	printf("first selected CPU core during given time (default %ds), then exits.\n",
+		DEFAULT_CHUNKBENCH_S);
+	printf("Dhrystone selects the load kernel variant: faithful (default, matching classic\n");
+	printf("Dhrystone numbers) or power (inlined, %d interleaved states, more ILP). Dhrybench\n",
+		dhry_power_lanes);
+	printf("only compares both variants on the first selected CPU core during given time\n");
+	printf("(default %ds), then exits.\n\n", DEFAULT_DHRYBENCH_S);
+	printf("Tlb makes load threads chase pointers through their own buffer of given size (MB),\n");
+	printf("one access per 4K page, during PWM active time. Pages selects buffer backing: 4K pages\n");
+	printf("(default), transparent huge pages or reserved huge pages (MAP_HUGETLB). Perf is implied:\n");
+	printf("access rate, latency and dTLB misses per access are reported.\n");
+	printf("Syscall spends given share (in %%) of PWM active time in system calls: getpid(),\n");
+	printf("4K write and read on tmpfs (rw), pipe write and read, futex wakes, or all of them\n");
+	printf("(default). Iowait spends given share (in %%) of PWM idle time blocked in O_DIRECT 4K\n");
+	printf("reads of file (default: 16MB temporary file in current directory). Achieved\n");
+	printf("user/system/iowait/idle split (/proc/stat), system call and read rates are reported.\n");
+	printf("Scenario runs the phases of file in a row, with precise (absolute) boundaries. Each phase\n");
+	printf("starts with a [name] line, followed by cpu[n]=load, duration (s, mandatory), period,\n");
+	printf("jitter, tlb, pingpong, syscall and iowait options, sample=on|off (resume/pause the\n");
+	printf("sampler from this phase on, enabling it if needed) and onstart=/onstop= lines (shell\n");
+	printf("command run at phase start/end). Phases are reported as sweep steps (csv allowed).\n");
+	printf("Coordinator listens on a TCP port (of 127.0.0.1 unless ip is set) for the given number\n");
+	printf("of agents, sends them the scenario, estimates their clock offsets and starts them all\n");
+	printf("at the same time, displaying their telemetry.\n");
+	printf("Agent connects to a coordinator and runs its scenario on the local CPU cores. Scenarios\n");
+	printf("with hooks are refused, unless hooks is set (the connection is not authenticated:\n");
+	printf("only allow hooks from a trusted coordinator on a trusted network).\n");
+	printf("Results saves run metadata (build, host, kernel, CPU model and topology, command line,\n");
+	printf("configuration) and per core and step results (requested and achieved load, iterations,\n");
+	printf("counters, sampled values and histograms) into file: JSON, or CSV if named *.csv.\n");
+	printf("Metrics serves live per load thread setpoint, CPU time, iterations, errors and sleep\n");
+	printf("overshoot histogram in OpenMetrics text format over HTTP, on given TCP port (of\n");
+	printf("127.0.0.1 unless ip is set) or Unix socket path, e.g. for long soak runs.\n");
+	printf("Tui displays a live heatmap of loaded CPU cores (requested and achieved load, frequency\n");
+	printf("and temperature), refreshed every %dms. Arrow keys select a core and change its load\n",
+		TUI_REFRESH_MS);
+	printf("by %d%%, digits set it to 10-90%% (0: 100%%), q quits. Period-based PWM is implied.\n\n",
+		TUI_STEP);
 	printf("e.g.:\n");
 	printf(" - Generate 100%% load on all online CPU cores until CTRL+C is pressed:\n");
 	printf("	# cpuloadgen\n");
 	printf(" - Generate 100%% load on all online CPU cores during 10 seconds:\n");
 	printf("	# cpuloadgen duration=10\n");
 	printf(" - Generate 50%% load on CPU1 and 100%% load on CPU3 during 10 seconds:\n");
-	printf("	# cpuloadgen cpu3=100 cpu1=50 duration=5\n\n");
+	printf("	# cpuloadgen cpu3=100 cpu1=50 duration=5\n");
+	printf(" - Generate 30%% load on CPU0 with SCHED_DEADLINE and a 10ms period:\n");
+	printf("	# cpuloadgen cpu0=30 policy=deadline period=10000\n");
+	printf(" - Generate 40%% load on CPU2 throttled by cgroup v2 cpu.max during 10 seconds:\n");
+	printf("	# cpuloadgen cpu2=40 cgroup=/sys/fs/cgroup duration=10\n");
+	printf(" - Run 8 threads at 50%% load on CPU0 and CPU1, with idle sleeps of at most 200us:\n");
+	printf("	# cpuloadgen cpu0=50 cpu1=50 threads=8 wakeup=200 duration=10\n");
+	printf(" - Measure wakeup latency every 1ms on CPU1 loaded at 70%% during 30 seconds:\n");
+	printf("	# cpuloadgen cpu1=70 probe=1000 duration=30\n");
+	printf(" - Sweep CPU0 load from 10%% to 100%% by 10%% steps of 30 seconds, into sweep.csv:\n");
+	printf("	# cpuloadgen cpu0=100 sweep=10:100:10,dwell=30,cooldown=5 csv=sweep.csv\n");
+	printf(" - Measure energy per Dhrystone iteration of CPU0 from 10%% to 100%% load, 5 windows of 2s:\n");
+	printf("	# cpuloadgen cpu0=100 sweep=10:100:10 energy=5:2:5 csv=energy.csv\n");
+	printf(" - Generate 100%% load on all CPU cores during 60 seconds, sampling sensors every 50ms:\n");
+	printf("	# cpuloadgen duration=60 sample=50 samples=samples.csv\n");
+	printf(" - Generate 30%% load on CPU0 spinning with pause when idle, C-states limited to 0us:\n");
+	printf("	# cpuloadgen cpu0=30 idle=pause dmalatency=0 duration=10\n");
+	printf(" - Generate 50%% load on CPU1 with lognormal busy and idle times, reproducibly:\n");
+	printf("	# cpuloadgen cpu1=50 jitter=lognormal:0.5 seed=42 duration=10\n");
+	printf(" - Serve Poisson requests of 200us exponential service time on CPU0 at 80%% utilisation:\n");
+	printf("	# cpuloadgen cpu0=80 service=200,dist=exponential duration=30\n");
+	printf(" - Run a 4-thread pool on CPU0-CPU3 at 60%% load, with tasks of 100us all produced by CPU0:\n");
+	printf("	# cpuloadgen cpu0=60 cpu1=60 cpu2=60 cpu3=60 pool=100 imbalance=100 duration=10\n");
+	printf(" - Contend on an MCS lock from CPU0 and CPU1, holding it 2us every 10us:\n");
+	printf("	# cpuloadgen cpu0=100 cpu1=100 lock=mcs cs=2 ncs=8 duration=10\n");
+	printf(" - Bounce a falsely shared cache line between CPU0 and CPU2 at 50%% duty cycle:\n");
+	printf("	# cpuloadgen cpu0=50 cpu2=50 pingpong=false duration=10\n");
+	printf(" - Measure core-to-core latency matrix of all online CPU cores:\n");
+	printf("	# cpuloadgen c2c\n");
+	printf(" - Check that load engine adaptive chunks at 100%% load do not lose throughput:\n");
+	printf("	# cpuloadgen chunkbench=20\n");
+	printf(" - Compare faithful and maximum power Dhrystone variants, then load CPU0 with the latter:\n");
+	printf("	# cpuloadgen dhrybench\n");
+	printf("	# cpuloadgen cpu0=100 dhrystone=power duration=10\n");
+	printf(" - Stress dTLB on CPU1 at 50%% duty cycle with a 256MB buffer of 4K, then THP pages:\n");
+	printf("	# cpuloadgen cpu1=50 tlb=256 duration=10\n");
+	printf("	# cpuloadgen cpu1=50 tlb=256,pages=thp duration=10\n");
+	printf(" - Generate 40%% load on CPU0, a quarter of it in pipe system calls, half of idle time in I/O:\n");
+	printf("	# cpuloadgen cpu0=40 syscall=25,mix=pipe iowait=50 duration=10\n");
+	printf(" - Run phases of lab.scn, saving results of each phase into lab.csv:\n");
+	printf("	# cpuloadgen scenario=lab.scn csv=lab.csv\n");
+	printf(" - Run phases of lab.scn on 2 hosts at once, coordinated from a third one:\n");
+	printf("	# cpuloadgen coordinator=0.0.0.0:7777 agents=2 scenario=lab.scn\n");
+	printf("	# cpuloadgen agent=coordinator-host:7777\n");
+	printf(" - Generate 50%% load on CPU0 during 10 seconds, saving results into run.json:\n");
+	printf("	# cpuloadgen cpu0=50 duration=10 results=run.json\n");
+	printf(" - Generate 30%% load on all CPU cores until CTRL+C is pressed, serving metrics on port 9100:\n");
+	printf("	# cpuloadgen cpu0=30 cpu1=30 cpu2=30 cpu3=30 metrics=9100\n");
+	printf(" - Tune loads of CPU0 and CPU1 interactively, watching their heatmap:\n");
+	printf("	# cpuloadgen cpu0=30 cpu1=30 tui\n\n");
 }
 
 
@@ -133,10 +532,32 @@ static void usage(void)
  *//*------------------------------------------------------------------------ */
 static void free_buffers(void)
 {
+	int i;
+
+	tui_stop();
+	energy_close();
+	hotplug_stop();
 	if (threads != NULL)
 		free(threads);
 	if (cpuloads != NULL)
 		free(cpuloads);
+	if (thread_stats != NULL)
+		free(thread_stats);
+	free(engine_threads);
+	if (sweep_csv != NULL)
+		fclose(sweep_csv);
+	request_trace_free();
+	coherence_deinit();
+	sysload_io_deinit();
+	scenario_free();
+	coord_agent_close();
+	results_close(interrupted);
+	metrics_stop();
+	if (pool_deques != NULL) {
+		for (i = 0; i < cpu_count * threads_per_cpu; i++)
+			wsdeque_deinit(&pool_deques[i]);
+		free(pool_deques);
+	}
 }
 
 
@@ -158,454 +579,3738 @@ static int einval(const char *arg)
 
 
 /* ------------------------------------------------------------------------*//**
- * @FUNCTION		sigterm_handler
- * @BRIEF		parent SIGTERM callback function.
- *			Send SIGTERM signal to child process.
- * @DESCRIPTION		parent SIGTERM callback function.
- *			Send SIGTERM signal to child process.
+ * @FUNCTION		sweep_parse
+ * @BRIEF		parse load sweep argument.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ * @param[in]		arg: sweep argument, without "sweep=" prefix:
+ *			<start>:<stop>:<step>[,dwell=<s>][,cooldown=<s>]
+ * @DESCRIPTION		parse load sweep argument.
  *//*------------------------------------------------------------------------ */
-void sigterm_handler(void)
+static int sweep_parse(const char *arg)
 {
-	unsigned int i;
+	const char *p;
+	long int val;
 
-	printf("Halting load generation...\n");
-	fflush(stdout);
+	if ((sscanf(arg, "%d:%d:%d", &sweep_start, &sweep_stop,
+		&sweep_step) != 3) ||
+		(sweep_start < 1) || (sweep_start > 100) ||
+		(sweep_stop < sweep_start) || (sweep_stop > 100) ||
+		(sweep_step < 1))
+		return -EINVAL;
 
-	free_buffers();
+	for (p = strchr(arg, ','); p != NULL; p = strchr(p + 1, ',')) {
+		if (sscanf(p, ",dwell=%ld", &val) == 1) {
+			if (val < 1)
+				return -EINVAL;
+			sweep_dwell = val;
+		} else if (sscanf(p, ",cooldown=%ld", &val) == 1) {
+			if (val < 0)
+				return -EINVAL;
+			sweep_cooldown = val;
+		} else {
+			return -EINVAL;
+		}
+	}
+	dprintf("Sweep: %d:%d:%d dwell=%lds cooldown=%lds\n", sweep_start,
+		sweep_stop, sweep_step, sweep_dwell, sweep_cooldown);
 
-	printf("done.\n\n");
-	fflush(stdout);
+	return 0;
 }
 
 
 /* ------------------------------------------------------------------------*//**
- * @FUNCTION		thread_loadgen
- * @BRIEF		pthread wrapper around loadgen() function.
- * @param[in]		ptr: pointer to the cpu core id
- * @DESCRIPTION		pthread wrapper around loadgen() function.
+ * @FUNCTION		energy_parse
+ * @BRIEF		parse energy characterisation argument.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ * @param[in]		arg: energy argument, without "energy=" prefix:
+ *			<settle>:<window>:<windows>
+ * @DESCRIPTION		parse energy characterisation argument.
  *//*------------------------------------------------------------------------ */
-void *thread_loadgen(void *ptr)
+static int energy_parse(const char *arg)
 {
-	unsigned int cpu;
+	int settle, window, windows;
+	char c;
 
-	cpu = *((unsigned int *) ptr);
-	pthread_mutex_unlock(&mutex1);
-	if (cpu < cpu_count) {
-		loadgen(cpu, cpuloads[cpu], duration);
-	} else {
-		fprintf(stderr, "%s: invalid cpu argument!!! (%d)\n",
-			__func__, cpu);
-	}
+	if ((sscanf(arg, "%d:%d:%d%c", &settle, &window, &windows, &c) != 3) ||
+		(settle < 0) || (window < 1) || (windows < 2) ||
+		(windows > ENERGY_WINDOWS_MAX))
+		return -EINVAL;
+	energy_settle = settle;
+	energy_window = window;
+	energy_windows = windows;
+	dprintf("Energy: settle=%us window=%us windows=%u\n", energy_settle,
+		energy_window, energy_windows);
 
-	pthread_exit(NULL);
+	return 0;
 }
 
 
 /* ------------------------------------------------------------------------*//**
- * @FUNCTION		main
- * @BRIEF		main entry point
- * @RETURNS		0 on success
- *			-EINVAL in case of invalid argument
- *			-ECHILD in case of failure to fork
- * @param[in, out]	argc: shell input argument number
- * @param[in, out]	argv: shell input argument(s)
- * @DESCRIPTION		main entry point
+ * @FUNCTION		sigterm_handler
+ * @BRIEF		SIGTERM/SIGINT callback function.
+ *			Request load threads to stop.
+ * @DESCRIPTION		SIGTERM/SIGINT callback function.
+ *			Request load threads to stop, so that main() can
+ *			join them and release resources (e.g. cgroups).
  *//*------------------------------------------------------------------------ */
-int main(int argc, char *argv[])
+void sigterm_handler(void)
 {
-	unsigned int cpu0load, cpu1load, cpu2load, cpu3load;
-	int i, ret, n, load;
-	long int duration2;
+	static const char msg[] = "\nHalting load generation...\n";
 
-	/*
-	 * Register signal handler in order to be able to
-	 * kill child process if user kills parent process
-	 */
-	signal(SIGTERM, (sighandler_t) sigterm_handler);
+	halt = 1;
+	interrupted = 1;
+	write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+}
 
-	printf("CPULOADGEN (REV %s built %s)\n\n",
-		CPULOADGEN_REVISION, builddate);
 
-	cpu_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
-	if (cpu_count < 1) {
-		fprintf(stderr, "cpuloadgen: could not determine CPU cores count!!! (%d)\n",
-			cpu_count);
-		return cpu_count;
-	}
-	dprintf("main: found %d CPU cores.\n", cpu_count);
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wakeup_handler
+ * @BRIEF		SIGUSR1 callback function.
+ * @DESCRIPTION		SIGUSR1 callback function. Does nothing: the signal
+ *			only interrupts load thread sleeps, so that they
+ *			notice halt without waiting for the end of their
+ *			PWM period.
+ *//*------------------------------------------------------------------------ */
+static void wakeup_handler(void)
+{
+}
 
-	/* Allocate buffers */
-	threads = malloc(cpu_count * sizeof(pthread_t));
-	cpuloads = malloc(cpu_count * sizeof(int));
-	if ((threads == NULL) || (cpuloads == NULL)) {
-		fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
-		return -ENOMEM;
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coord_stop
+ * @BRIEF		coordinator and TUI stop callback function.
+ * @DESCRIPTION		coordinator and TUI stop callback function, called
+ *			from coordinator watcher or TUI thread. Interrupts
+ *			main thread as CTRL+C would.
+ *//*------------------------------------------------------------------------ */
+static void coord_stop(void)
+{
+	pthread_kill(main_thread, SIGINT);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		policy_parse
+ * @BRIEF		convert scheduling policy name into policy ID.
+ * @RETURNS		policy ID (SCHED_xyz)
+ *			-EINVAL in case of unknown policy name
+ * @param[in]		name: policy name
+ * @DESCRIPTION		convert scheduling policy name into policy ID.
+ *//*------------------------------------------------------------------------ */
+static int policy_parse(const char *name)
+{
+	if (strcmp(name, "other") == 0)
+		return SCHED_OTHER;
+	else if (strcmp(name, "batch") == 0)
+		return SCHED_BATCH;
+	else if (strcmp(name, "idle") == 0)
+		return SCHED_IDLE;
+	else if (strcmp(name, "fifo") == 0)
+		return SCHED_FIFO;
+	else if (strcmp(name, "rr") == 0)
+		return SCHED_RR;
+	else if (strcmp(name, "deadline") == 0)
+		return SCHED_DEADLINE;
+	else
+		return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		policy_name
+ * @BRIEF		convert scheduling policy ID into policy name.
+ * @RETURNS		policy name
+ * @param[in]		pol: policy ID (SCHED_xyz)
+ * @DESCRIPTION		convert scheduling policy ID into policy name.
+ *//*------------------------------------------------------------------------ */
+static const char *policy_name(int pol)
+{
+	switch (pol) {
+	case SCHED_OTHER:
+		return "SCHED_OTHER";
+	case SCHED_BATCH:
+		return "SCHED_BATCH";
+	case SCHED_IDLE:
+		return "SCHED_IDLE";
+	case SCHED_FIFO:
+		return "SCHED_FIFO";
+	case SCHED_RR:
+		return "SCHED_RR";
+	case SCHED_DEADLINE:
+		return "SCHED_DEADLINE";
+	default:
+		return "UNKNOWN";
 	}
-	/* Initialize variables */
-	if (argc == 1) {
-		/* No user arguments, use default */
-		for (i = 0; i < cpu_count; i++) {
-			threads[i] = -1;
-			cpuloads[i] = 100;
-		}
-		duration = -1;
-	} else {
-		for (i = 0; i < cpu_count; i++) {
-			threads[i] = -1;
-			cpuloads[i] = -1;
-		}
-		duration = -1;
+}
 
-		/* Parse arguments */
-		for (i = 1; i < argc; i++) {
-			dprintf("main: argv[i]=%s\n", argv[i]);
-			if (argv[i][0] == 'c') {
-				ret = sscanf(argv[i], "cpu%d=%d", &n, &load);
-				if ((ret != 2) ||
-					((n < 0) || (n >= cpu_count)) ||
-					((load < 1) || (load > 100)))
-					return einval(argv[i]);
-				if (cpuloads[n] != -1) {
-					fprintf(stderr,
-						"cpuloadgen: CPU%d was already assigned a load of %d!\n\n",
-						n, cpuloads[n]);
-					free_buffers();
-					return -EINVAL;
-				}
-				cpuloads[n] = load;
-				dprintf("Load assigned to CPU%d: %d%%\n",
-					n, cpuloads[n]);
-			} else if (argv[i][0] == 'd') {
-				ret = sscanf(argv[i], "duration=%ld",
-					&duration2);
-				if ((ret != 1) || (duration2 < 1)) {
-					return einval(argv[i]);
-				}
-				if (duration != -1) {
-					fprintf(stderr,
-						"cpuloadgen: duration was already set to %ld!\n\n",
-						duration);
-					free_buffers();
-					return -EINVAL;
-				}
-				duration = duration2;
-				dprintf("Duration of the load generation: %lds\n",
-					duration);
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sched_setup
+ * @BRIEF		apply selected scheduling policy to calling thread.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID the calling thread is loading
+ * @param[in]		load: load generated by calling thread ([1-100])
+ * @DESCRIPTION		apply selected scheduling policy (and priority or nice
+ *			level) to calling thread.
+ *			SCHED_DEADLINE runtime and period are derived from
+ *			load and PWM period. As the kernel rejects deadline
+ *			tasks whose affinity is narrower than their root
+ *			domain, retry unpinned if pinned admission is denied.
+ *			Report any denied request, in which case thread keeps
+ *			running with its previous policy.
+ *//*------------------------------------------------------------------------ */
+static int sched_setup(unsigned int cpu, unsigned int load)
+{
+	struct sched_param param;
+	struct dl_sched_attr attr;
+	cpu_set_t set, pinned;
+	int i, ret, err;
+
+	if (policy == SCHED_DEADLINE) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.sched_policy = SCHED_DEADLINE;
+		attr.sched_period = (uint64_t) period * 1000;
+		attr.sched_deadline = attr.sched_period;
+		attr.sched_runtime = (attr.sched_period * load) / 100;
+		ret = syscall(SYS_sched_setattr, 0, &attr, 0);
+		err = errno;
+		if ((ret != 0) && (err == EPERM) &&
+			(sched_getaffinity(0, sizeof(pinned), &pinned) == 0)) {
+			/*
+			 * Retry unpinned. If it still fails, restore placement
+			 * and report the original error.
+			 */
+			CPU_ZERO(&set);
+			for (i = 0; i < cpu_count; i++)
+				CPU_SET(i, &set);
+			if (sched_setaffinity(0, sizeof(set), &set) == 0)
+				ret = syscall(SYS_sched_setattr, 0, &attr, 0);
+			if (ret == 0) {
+				printf("CPU%d: SCHED_DEADLINE task cannot be pinned, running unpinned.\n",
+					cpu);
 			} else {
-				return einval(argv[i]);
+				sched_setaffinity(0, sizeof(pinned), &pinned);
+				errno = err;
 			}
 		}
+		if (ret != 0)
+			goto denied;
+		dprintf("%s(): CPU%d runtime=%lluns period=%lluns\n", __func__,
+			cpu, (unsigned long long) attr.sched_runtime,
+			(unsigned long long) attr.sched_period);
+		return 0;
 	}
 
-	printf("Press CTRL+C to stop load generation at any time.\n\n");
+	if (policy != -1) {
+		memset(&param, 0, sizeof(param));
+		if ((policy == SCHED_FIFO) || (policy == SCHED_RR))
+			param.sched_priority = (priority == -1) ? 1 : priority;
+		if (sched_setscheduler(0, policy, &param) != 0)
+			goto denied;
+	}
 
-	/* Start load generation on cores accordingly */
-	for (i = 0; i < cpu_count; i++) {
-		if (cpuloads[i] == -1) {
-			dprintf("main: no load to be generated on CPU%d\n", i);
-			continue;
+	if (nice_level != NICE_UNSET) {
+		/* On Linux, setpriority() on a thread ID affects this thread only */
+		if (setpriority(PRIO_PROCESS, syscall(SYS_gettid),
+			nice_level) != 0) {
+			ret = -errno;
+			fprintf(stderr,
+				"cpuloadgen: CPU%d: nice level %d denied (%s)!\n",
+				cpu, nice_level, strerror(-ret));
+			return ret;
 		}
-		/*
-		 * Why is a mutex needed here?
-		 * There is a race condition between this loop which updates
-		 * variable i and thread_loadgen() which also reads it.
-		 * Hence locking a mutex here, and unlocking it in
-		 * thread_loadgen() after the value was retrieved and saved.
-		 */
-		pthread_mutex_lock(&mutex1);
-		ret = pthread_create(&threads[i], NULL, thread_loadgen, &i);
-		if (ret != 0) {
-			fprintf(stderr, "cpuloadgen: failed to fork %d! (%d)",
-			i, ret);
+	}
+
+	return 0;
+
+denied:
+	ret = -errno;
+	fprintf(stderr,
+		"cpuloadgen: CPU%d: %s policy denied (%s), running with default policy!\n",
+		cpu, policy_name(policy), strerror(-ret));
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sched_stats_read
+ * @BRIEF		read scheduler statistics of calling thread.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[out]		st: scheduler statistics
+ * @DESCRIPTION		read scheduler statistics of calling thread:
+ *			on-cpu time, runqueue wait time and timeslices
+ *			from /proc/self/task/<tid>/schedstat, context
+ *			switches from /proc/self/task/<tid>/status.
+ *//*------------------------------------------------------------------------ */
+static int sched_stats_read(worker_stats *st)
+{
+	char path[64];
+	char line[128];
+	FILE *fp;
+	long tid;
+	int ret;
+
+	memset(st, 0, sizeof(worker_stats));
+	tid = (long) syscall(SYS_gettid);
+
+	snprintf(path, sizeof(path), "/proc/self/task/%ld/schedstat", tid);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	ret = fscanf(fp, "%llu %llu %llu",
+		&st->run_ns, &st->wait_ns, &st->slices);
+	fclose(fp);
+	if (ret != 3)
+		return -EIO;
+
+	snprintf(path, sizeof(path), "/proc/self/task/%ld/status", tid);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		sscanf(line, "voluntary_ctxt_switches: %llu", &st->vcsw);
+		sscanf(line, "nonvoluntary_ctxt_switches: %llu", &st->ivcsw);
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		placement_report
+ * @BRIEF		display load threads placement events.
+ * @DESCRIPTION		display load threads placement events per CPU core
+ *			(pinnings restored, parkings and parked time), if any
+ *			CPU core changed state or any load thread lost its
+ *			placement.
+ *//*------------------------------------------------------------------------ */
+static void placement_report(void)
+{
+	unsigned long long repins, parks, parked_ns, total = 0;
+	worker_stats *st;
+	int i, cpu;
+
+	for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+		if (cpuloads[i / threads_per_cpu] != -1)
+			total += thread_stats[i].repins + thread_stats[i].parks;
+	}
+	if ((total == 0) && (hotplug_events() == 0))
+		return;
+
+	printf("\nPlacement (%llu CPU core state changes since start):\n",
+		hotplug_events());
+	printf("%-6s %4s %8s %8s %11s\n", "CPU", "Load", "Repins", "Parks",
+		"Parked (s)");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
 			continue;
+		repins = parks = parked_ns = 0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			repins += st->repins;
+			parks += st->parks;
+			parked_ns += st->parked_ns;
 		}
+		printf("CPU%-3d %3d%% %8llu %8llu %11.3f\n", cpu, cpuloads[cpu],
+			repins, parks, (double) parked_ns * 1.0e-9);
 	}
+}
 
-	for (i = 0; i < cpu_count; i++) {
-		if (cpuloads[i] == -1) {
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sched_stats_report
+ * @BRIEF		display scheduler statistics of load threads.
+ * @DESCRIPTION		display scheduler statistics of load threads:
+ *			runqueue delay and context switch rate.
+ *//*------------------------------------------------------------------------ */
+static void sched_stats_report(void)
+{
+	worker_stats *st, total;
+	double elapsed_s = 0.0;
+	int i, cpu;
+
+	memset(&total, 0, sizeof(total));
+	printf("\n%-12s %10s %14s %14s %12s %12s\n", "Thread", "Run (ms)",
+		"RQ wait (ms)", "RQ wait/slice", "Ctxsw/s", "Invol./s");
+	for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+		cpu = i / threads_per_cpu;
+		st = &thread_stats[i];
+		if ((cpuloads[cpu] == -1) || (st->elapsed_s <= 0.0))
 			continue;
-		}
-		pthread_join(threads[i], NULL);
+		printf("CPU%-3d #%-4d %10.1f %14.1f %11.1fus %12.0f %12.0f\n",
+			cpu, i % threads_per_cpu,
+			(double) st->run_ns / 1.0e6,
+			(double) st->wait_ns / 1.0e6,
+			(st->slices != 0) ?
+				(double) st->wait_ns / st->slices / 1.0e3 : 0.0,
+			(double) (st->vcsw + st->ivcsw) / st->elapsed_s,
+			(double) st->ivcsw / st->elapsed_s);
+		total.run_ns += st->run_ns;
+		total.wait_ns += st->wait_ns;
+		total.slices += st->slices;
+		total.vcsw += st->vcsw;
+		total.ivcsw += st->ivcsw;
+		if (st->elapsed_s > elapsed_s)
+			elapsed_s = st->elapsed_s;
 	}
+	if (elapsed_s <= 0.0)
+		return;
+	printf("%-12s %10.1f %14.1f %11.1fus %12.0f %12.0f\n", "Total",
+		(double) total.run_ns / 1.0e6,
+		(double) total.wait_ns / 1.0e6,
+		(total.slices != 0) ?
+			(double) total.wait_ns / total.slices / 1.0e3 : 0.0,
+		(double) (total.vcsw + total.ivcsw) / elapsed_s,
+		(double) total.ivcsw / elapsed_s);
+}
 
-	free_buffers();
 
-	printf("\ndone.\n\n");
-	return 0;
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_thread_begin
+ * @BRIEF		start accounting a load thread run.
+ * @param[in]		idx: thread index
+ *				(cpu core id * threads_per_cpu + thread number)
+ * @DESCRIPTION		start accounting a load thread run, from the load
+ *			thread itself: seed its generator, open its
+ *			performance counters, and save its scheduler
+ *			statistics.
+ *//*------------------------------------------------------------------------ */
+static void loadgen_thread_begin(unsigned int idx)
+{
+	unsigned int cpu = idx / threads_per_cpu;
+	int ret;
+
+	rng_seed(&thread_rng, seed, ((uint64_t) run_index << 32) | idx);
+	thread_idx = idx;
+	dhry_variant_set(dhrystone_variant);
+	thread_perf_ok = 0;
+	if (perf_enabled) {
+		ret = perf_open(&thread_perf);
+		if (ret == 0)
+			thread_perf_ok = 1;
+		else if (__sync_lock_test_and_set(&perf_warned, 1) == 0)
+			fprintf(stderr,
+				"cpuloadgen: performance counters not available (%s)!\n",
+				strerror(-ret));
+	}
+	thread_metrics = metrics_worker_get(idx);
+	metrics_worker_begin(thread_metrics, cpu, cpuloads[cpu]);
+	sched_stats_read(&thread_sched_start);
+	clock_gettime(CLOCK_MONOTONIC, &thread_ts_start);
 }
 
 
 /* ------------------------------------------------------------------------*//**
- * @FUNCTION		loadgen
- * @BRIEF		Programmable CPU load generator
- * @RETURNS		0 on success
- *			OMAPCONF_ERR_CPU
- *			OMAPCONF_ERR_ARG
- *			OMAPCONF_ERR_REG_ACCESS
- * @param[in]		cpu: target CPU core ID (loaded CPU core)
- * @param[in]		load: load to generate on that CPU ([1-100])
- * @param[in]		duration: how long this CPU core shall be loaded
- *				(in seconds)
- * @DESCRIPTION		Programmable CPU load generator. Use Dhrystone loops
- *			to generate load, and apply PWM (Pulse Width Modulation)
- *			principle on it to make average CPU load vary between
- *			0 and 100%
- *//*------------------------------------------------------------------------ */
-void loadgen(unsigned int cpu, unsigned int load, unsigned int duration)
-{
-	double dhrystone_start_time, dhrystone_end_time;
-	double idle_time_us;
-	double loadgen_start_time_us, active_time_us;
-	double total_time_us;
-	struct timeval tv_cpuloadgen_start, tv_cpuloadgen;
-	struct timeval tv_idle_start, tv_idle_stop;
-	struct timezone tz;
-	double time_us;
-	unsigned long mask;
-	unsigned int len = sizeof(mask);
-	cpu_set_t set;
+ * @FUNCTION		loadgen_thread_end
+ * @BRIEF		complete accounting of a load thread run.
+ * @param[in]		iterations: Dhrystone iterations performed
+ * @DESCRIPTION		complete accounting of a load thread run, from the
+ *			load thread itself: save placement, performance
+ *			counters and scheduler statistics deltas.
+ *//*------------------------------------------------------------------------ */
+static void loadgen_thread_end(unsigned long long iterations)
+{
+	worker_stats end, *st = &thread_stats[thread_idx];
+	struct timespec ts_end;
+	perf_counts perf_end;
 
-	CPU_ZERO(&set);
-	CPU_SET(cpu, &set);
-	sched_setaffinity(0, len, &set);
-	printf("Generating %3d%% load on CPU%d...\n", load, cpu);
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	metrics_worker_end(thread_metrics);
+	st->repins = thread_hotplug.repins;
+	st->parks = thread_hotplug.parks;
+	st->parked_ns = thread_hotplug.parked_ns;
+	if (thread_perf_ok) {
+		if (perf_read(&thread_perf, &perf_end) == 0)
+			perf_delta(&thread_perf.start, &perf_end, &st->perf);
+		perf_close(&thread_perf);
+	}
+	if (sched_stats_read(&end) == 0) {
+		st->iterations = iterations;
+		st->run_ns = end.run_ns - thread_sched_start.run_ns;
+		st->wait_ns = end.wait_ns - thread_sched_start.wait_ns;
+		st->slices = end.slices - thread_sched_start.slices;
+		st->vcsw = end.vcsw - thread_sched_start.vcsw;
+		st->ivcsw = end.ivcsw - thread_sched_start.ivcsw;
+		st->elapsed_s = (double) (ts_end.tv_sec -
+			thread_ts_start.tv_sec) + (double) (ts_end.tv_nsec -
+			thread_ts_start.tv_nsec) * 1.0e-9;
+	}
+}
 
-	gettimeofday(&tv_cpuloadgen_start, &tz);
-	loadgen_start_time_us = ((double) tv_cpuloadgen_start.tv_sec
-		+ ((double) tv_cpuloadgen_start.tv_usec * 1.0e-6));
-	dprintf("%s(): CPU%d start time: %fus\n", __func__,
-		cpu, loadgen_start_time_us);
 
-	if (load != 100) {
-		while (1) {
-			/* Generate load (100%) */
-			dhrystone_start_time = dtime();
-			dhryStone(200000);
-			dhrystone_end_time = dtime();
-			active_time_us =
-				(dhrystone_end_time - dhrystone_start_time) * 1.0e6;
-			dprintf("%s(): CPU%d running time: %dus\n", __func__,
-				cpu, (unsigned int) active_time_us);
-
-			/* Compute needed idle time */
-			total_time_us =
-				active_time_us * (100.0 / (double) (load + 1));
-			dprintf("%s(): CPU%d total time: %dus\n", __func__, cpu,
-				(unsigned int) total_time_us);
-			idle_time_us = total_time_us - active_time_us;
-			dprintf("%s(): CPU%d computed idle_time_us = %dus\n",
-				__func__, cpu, (unsigned int) idle_time_us);
-
-			/* Generate idle time */
-			#ifdef DEBUG
-			gettimeofday(&tv_idle_start, &tz);
-			#endif
-			usleep((unsigned int) (idle_time_us));
-			#ifdef DEBUG
-			gettimeofday(&tv_idle_stop, &tz);
-			idle_time_us = 1.0e6 * (
-				((double) tv_idle_stop.tv_sec +
-				((double) tv_idle_stop.tv_usec * 1.0e-6))
-				- ((double) tv_idle_start.tv_sec +
-				((double) tv_idle_start.tv_usec * 1.0e-6)));
-			dprintf("%s(): CPU%d effective idle time: %dus\n",
-				__func__, cpu, (unsigned int) idle_time_us);
-			dprintf("%s(): CPU%d effective CPU Load: %d%%\n",
-				__func__, cpu,
-				(unsigned int) (100.0 * (active_time_us /
-				(active_time_us + idle_time_us))));
-			#endif
-			gettimeofday(&tv_cpuloadgen, &tz);
-			time_us = ((double) tv_cpuloadgen.tv_sec
-				+ ((double) tv_cpuloadgen.tv_usec * 1.0e-6));
-			dprintf("%s(): CPU%d elapsed time: %fs\n",
-				__func__, cpu,
-				time_us - loadgen_start_time_us);
-			if ((duration != 0) &&
-				(time_us - loadgen_start_time_us) >= duration)
-				break;
-		}
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		thread_loadgen
+ * @BRIEF		pthread wrapper around loadgen() function.
+ * @param[in]		ptr: thread index, passed by value
+ *				(cpu core id * threads_per_cpu + thread number)
+ * @DESCRIPTION		pthread wrapper around loadgen() function.
+ *			Save scheduler statistics delta of the thread.
+ *//*------------------------------------------------------------------------ */
+void *thread_loadgen(void *ptr)
+{
+	unsigned int idx, cpu;
+	unsigned long long iterations;
+
+	idx = (unsigned int) (uintptr_t) ptr;
+	cpu = idx / threads_per_cpu;
+	if (cpu < cpu_count) {
+		loadgen_thread_begin(idx);
+		iterations = loadgen(cpu, cpuloads[cpu], duration);
+		loadgen_thread_end(iterations);
 	} else {
-		while (1) {
-			dhryStone(1000000);
-			gettimeofday(&tv_cpuloadgen, &tz);
-			time_us = ((double) tv_cpuloadgen.tv_sec
-				+ ((double) tv_cpuloadgen.tv_usec * 1.0e-6));
-			dprintf("%s(): CPU%d elapsed time: %fs\n", __func__,
-				cpu, time_us - loadgen_start_time_us);
-			if ((duration != 0) &&
-				(time_us - loadgen_start_time_us) >= duration)
-				break;
-		}
+		fprintf(stderr, "%s: invalid cpu argument!!! (%d)\n",
+			__func__, cpu);
 	}
 
-	dprintf("Load Generation on CPU%d completed.\n", cpu);
+	pthread_exit(NULL);
 }
 
 
-void dhryStone(unsigned int iterations)
-{
-	One_Fifty Int_1_Loc;
-	REG One_Fifty Int_2_Loc;
-	One_Fifty Int_3_Loc;
-	REG char Ch_Index;
-	Enumeration Enum_Loc;
-	Str_30 Str_1_Loc;
-	Str_30 Str_2_Loc;
-	REG int Run_Index;
-	REG int Number_Of_Runs;
-
-	FILE *Ap;
-	unsigned int mrcData;
-
-	Next_Ptr_Glob = (Rec_Pointer) malloc(sizeof(Rec_Type));
-	Ptr_Glob = (Rec_Pointer) malloc(sizeof (Rec_Type));
-
-	Ptr_Glob->Ptr_Comp = Next_Ptr_Glob;
-	Ptr_Glob->Discr = Ident_1;
-	Ptr_Glob->variant.var_1.Enum_Comp = Ident_3;
-	Ptr_Glob->variant.var_1.Int_Comp = 40;
-	strcpy (Ptr_Glob->variant.var_1.Str_Comp,
-	"DHRYSTONE PROGRAM, SOME STRING");
-	strcpy (Str_1_Loc, "DHRYSTONE PROGRAM, 1'ST STRING");
-
-	Arr_2_Glob [8][7] = 10;
-    /* Was missing in published program. Without this statement,
-    Arr_2_Glob [8][7] would have an undefined value.
-    Warning: With 16-Bit processors and Number_Of_Runs > 32000,
-    overflow may occur for this array element. */
-
-    Number_Of_Runs = iterations;
-	for (Run_Index = 1; Run_Index <= Number_Of_Runs; ++Run_Index) {
-		Proc_5();
-		Proc_4();
-		/* Ch_1_Glob == 'A', Ch_2_Glob == 'B', Bool_Glob == true */
-		Int_1_Loc = 2;
-		Int_2_Loc = 3;
-		strcpy (Str_2_Loc, "DHRYSTONE PROGRAM, 2'ND STRING");
-		Enum_Loc = Ident_2;
-		Bool_Glob = ! Func_2 (Str_1_Loc, Str_2_Loc);
-		/* Bool_Glob == 1 */
-		while (Int_1_Loc < Int_2_Loc) { /* loop body executed once */
-			Int_3_Loc = 5 * Int_1_Loc - Int_2_Loc;
-			/* Int_3_Loc == 7 */
-			Proc_7 (Int_1_Loc, Int_2_Loc, &Int_3_Loc);
-			/* Int_3_Loc == 7 */
-			Int_1_Loc += 1;
-		}
-		/* Int_1_Loc == 3, Int_2_Loc == 3, Int_3_Loc == 7 */
-		Proc_8 (Arr_1_Glob, Arr_2_Glob, Int_1_Loc, Int_3_Loc);
-		/* Int_Glob == 5 */
-		Proc_1 (Ptr_Glob);
-		for (Ch_Index = 'A'; Ch_Index <= Ch_2_Glob; ++Ch_Index) {
-		/* loop body executed twice */
-			if (Enum_Loc == Func_1 (Ch_Index, 'C')) {
-				/* then, not executed */
-				Proc_6 (Ident_1, &Enum_Loc);
-				strcpy (Str_2_Loc,
-					"DHRYSTONE PROGRAM, 3'RD STRING");
-				Int_2_Loc = Run_Index;
-				Int_Glob = Run_Index;
-			}
-		}
-		/* Int_1_Loc == 3, Int_2_Loc == 3, Int_3_Loc == 7 */
-		Int_2_Loc = Int_2_Loc * Int_1_Loc;
-		Int_1_Loc = Int_2_Loc / Int_3_Loc;
-		Int_2_Loc = 7 * (Int_2_Loc - Int_3_Loc) - Int_1_Loc;
-		/* Int_1_Loc == 1, Int_2_Loc == 13, Int_3_Loc == 7 */
-		Proc_2 (&Int_1_Loc);
-		/* Int_1_Loc == 5 */
-	}
-}
-
-
-Proc_1 (Ptr_Val_Par)
-/******************/
-
-REG Rec_Pointer Ptr_Val_Par;
-    /* executed once */
-{
-  REG Rec_Pointer Next_Record = Ptr_Val_Par->Ptr_Comp;
-                                        /* == Ptr_Glob_Next */
-  /* Local variable, initialized with Ptr_Val_Par->Ptr_Comp,    */
-  /* corresponds to "rename" in Ada, "with" in Pascal           */
-
-  structassign (*Ptr_Val_Par->Ptr_Comp, *Ptr_Glob);
-  Ptr_Val_Par->variant.var_1.Int_Comp = 5;
-  Next_Record->variant.var_1.Int_Comp
-        = Ptr_Val_Par->variant.var_1.Int_Comp;
-  Next_Record->Ptr_Comp = Ptr_Val_Par->Ptr_Comp;
-  Proc_3 (&Next_Record->Ptr_Comp);
-    /* Ptr_Val_Par->Ptr_Comp->Ptr_Comp
-                        == Ptr_Glob->Ptr_Comp */
-  if (Next_Record->Discr == Ident_1)
-    /* then, executed */
-  {
-    Next_Record->variant.var_1.Int_Comp = 6;
-    Proc_6 (Ptr_Val_Par->variant.var_1.Enum_Comp,
-           &Next_Record->variant.var_1.Enum_Comp);
-    Next_Record->Ptr_Comp = Ptr_Glob->Ptr_Comp;
-    Proc_7 (Next_Record->variant.var_1.Int_Comp, 10,
-           &Next_Record->variant.var_1.Int_Comp);
-  }
-  else /* not executed */
-    structassign (*Ptr_Val_Par, *Ptr_Val_Par->Ptr_Comp);
-} /* Proc_1 */
-
-Proc_2 (Int_Par_Ref)
-/******************/
-    /* executed once */
-    /* *Int_Par_Ref == 1, becomes 4 */
-
-One_Fifty   *Int_Par_Ref;
-{
-  One_Fifty  Int_Loc;
-  Enumeration   Enum_Loc;
-
-  Int_Loc = *Int_Par_Ref + 10;
-  do /* executed once */
-    if (Ch_1_Glob == 'A')
-      /* then, executed */
-    {
-      Int_Loc -= 1;
-      *Int_Par_Ref = Int_Loc - Int_Glob;
-      Enum_Loc = Ident_1;
-    } /* if */
-  while (Enum_Loc != Ident_1); /* true */
-} /* Proc_2 */
-
-
-Proc_3 (Ptr_Ref_Par)
-/******************/
-    /* executed once */
-    /* Ptr_Ref_Par becomes Ptr_Glob */
-
-Rec_Pointer *Ptr_Ref_Par;
-
-{
-  if (Ptr_Glob != Null)
-    /* then, executed */
-    *Ptr_Ref_Par = Ptr_Glob->Ptr_Comp;
-  Proc_7 (10, Int_Glob, &Ptr_Glob->variant.var_1.Int_Comp);
-} /* Proc_3 */
-
-
-Proc_4 () /* without parameters */
-/*******/
-    /* executed once */
-{
-  Boolean Bool_Loc;
-
-  Bool_Loc = Ch_1_Glob == 'A';
-  Bool_Glob = Bool_Loc | Bool_Glob;
-  Ch_2_Glob = 'B';
-} /* Proc_4 */
-
-
-Proc_5 () /* without parameters */
-/*******/
-    /* executed once */
-{
-  Ch_1_Glob = 'A';
-  Bool_Glob = false;
-} /* Proc_5 */
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_start_hook
+ * @BRIEF		load engine worker start hook.
+ * @param[in]		worker: engine worker index
+ * @param[in]		arg: unused
+ * @DESCRIPTION		load engine worker start hook: account load thread
+ *			run and place it as loadgen() does. When the kernel
+ *			throttles the thread, worker runs flat out.
+ *//*------------------------------------------------------------------------ */
+static void engine_start_hook(int worker, void *arg)
+{
+	unsigned int idx = engine_threads[worker];
+	unsigned int cpu = idx / threads_per_cpu;
+
+	(void) arg;
+	loadgen_thread_begin(idx);
+	thread_load = cpuloads[cpu];
+	thread_iterations = 0;
+	thread_throttled = loadgen_setup(cpu, thread_load);
+	if (thread_throttled)
+		cpuloadgen_set_load(engine, worker, 100);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_iterations
+ * @BRIEF		account iterations of a load engine worker.
+ * @RETURNS		0 on success
+ *			-errno worker failure code
+ * @param[in]		worker: engine worker index
+ * @param[out]		stats: worker statistics
+ * @DESCRIPTION		account iterations performed by a load engine worker
+ *			since last call into live counters.
+ *//*------------------------------------------------------------------------ */
+static int engine_iterations(int worker, cpuloadgen_stats *stats)
+{
+	int ret;
+
+	ret = cpuloadgen_get_stats(engine, worker, stats);
+	if (!tlb_set)
+		metrics_iterations(thread_metrics,
+			stats->iterations - thread_iterations);
+	thread_iterations = stats->iterations;
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_period_hook
+ * @BRIEF		load engine worker period hook.
+ * @RETURNS		1 if load thread was parked, 0 otherwise
+ * @param[in]		worker: engine worker index
+ * @param[in]		start: scheduled period start
+ * @param[in]		arg: unused
+ * @DESCRIPTION		load engine worker period hook: check load thread
+ *			placement, pick up load set from TUI and update live
+ *			counters.
+ *//*------------------------------------------------------------------------ */
+static int engine_period_hook(int worker, const struct timespec *start,
+	void *arg)
+{
+	unsigned int cpu = thread_idx / threads_per_cpu;
+	cpuloadgen_stats stats;
+	int parked;
+
+	(void) arg;
+	if ((thread_load < 100) && (!thread_throttled))
+		metrics_overshoot(thread_metrics, start);
+	parked = hotplug_check(&thread_hotplug);
+	if ((tui_set) && (!thread_throttled)) {
+		thread_load = __atomic_load_n(&cpuloads[cpu],
+			__ATOMIC_RELAXED);
+		metrics_setpoint(thread_metrics, thread_load);
+		cpuloadgen_set_load(engine, worker, thread_load);
+	}
+	if (thread_metrics != NULL)
+		engine_iterations(worker, &stats);
+
+	return parked;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_stop_hook
+ * @BRIEF		load engine worker stop hook.
+ * @param[in]		worker: engine worker index
+ * @param[in]		arg: unused
+ * @DESCRIPTION		load engine worker stop hook: complete load thread
+ *			run accounting. TLB kernel accesses are accounted as
+ *			kernel operations, over worker busy time.
+ *//*------------------------------------------------------------------------ */
+static void engine_stop_hook(int worker, void *arg)
+{
+	worker_stats *st = &thread_stats[thread_idx];
+	cpuloadgen_stats stats;
+
+	(void) arg;
+	if (engine_iterations(worker, &stats) != 0)
+		metrics_error(thread_metrics);
+	if (tlb_set) {
+		st->kernel_ops = stats.iterations;
+		st->kernel_busy_ns = (unsigned long long)
+			(stats.busy_s * 1.0e9);
+		loadgen_thread_end(0);
+	} else {
+		loadgen_thread_end(stats.iterations);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_eligible
+ * @BRIEF		tell whether load engine may run the load.
+ * @RETURNS		1 if load engine may run the load, 0 otherwise
+ * @DESCRIPTION		tell whether load engine may run the load: plain
+ *			Dhrystone or TLB PWM, sleeping while idle. Other
+ *			kernels, jitter, system calls, I/O wait, random
+ *			wakeups and spinning idle modes run in loadgen().
+ *//*------------------------------------------------------------------------ */
+static int engine_eligible(void)
+{
+	return (service_us <= 0.0) && (pool_task_us <= 0.0) && (!lock_set) &&
+		(!coherence_set) && (syscall_pct == 0) && (iowait_pct == 0) &&
+		(jitter.type == DIST_CONSTANT) && (wakeup_max == -1) &&
+		(idle == IDLE_SLEEP);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_start
+ * @BRIEF		start load engine on selected CPU cores.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @DESCRIPTION		start load engine, with a worker per load thread,
+ *			according to cpuloads[].
+ *//*------------------------------------------------------------------------ */
+static int engine_start(void)
+{
+	cpuloadgen_hooks hooks = { engine_start_hook, engine_period_hook,
+		engine_stop_hook, NULL };
+	cpuloadgen_worker_config cfg;
+	int i, ret;
+
+	engine = cpuloadgen_create();
+	if (engine == NULL)
+		return -ENOMEM;
+	cpuloadgen_set_hooks(engine, &hooks);
+	for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+		if (cpuloads[i / threads_per_cpu] == -1)
+			continue;
+		memset(&cfg, 0, sizeof(cfg));
+		/* Placed by start hook, parked while CPU core is not available */
+		cfg.cpu = -1;
+		if (tlb_set)
+			cfg.kernel = CPULOADGEN_KERNEL_TLB;
+		else if (dhrystone_variant == DHRY_POWER)
+			cfg.kernel = CPULOADGEN_KERNEL_DHRYSTONE_POWER;
+		else
+			cfg.kernel = CPULOADGEN_KERNEL_DHRYSTONE;
+		cfg.load = cpuloads[i / threads_per_cpu];
+		cfg.period_us = period;
+		cfg.tlb_footprint = tlb_footprint;
+		/* Same order as tlb_pages */
+		cfg.tlb_pages = (cpuloadgen_tlb_pages) tlb_backing;
+		cfg.seed = seed;
+		ret = cpuloadgen_add_worker(engine, &cfg);
+		if (ret < 0)
+			goto fail;
+		engine_threads[ret] = i;
+	}
+
+	ret = cpuloadgen_start(engine);
+	if (ret == 0)
+		return 0;
+
+fail:
+	fprintf(stderr, "cpuloadgen: could not start load engine (%s)!\n",
+		strerror(-ret));
+	cpuloadgen_destroy(engine);
+	engine = NULL;
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_run
+ * @BRIEF		generate load on selected CPU cores, once.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		step: sweep step (or scenario phase) number,
+ *				-1 if not sweeping
+ * @param[in]		deadline: absolute CLOCK_MONOTONIC time at which load
+ *				threads are stopped, NULL to rely on duration
+ * @DESCRIPTION		generate load on selected CPU cores, according to
+ *			cpuloads[] and duration: create per-thread cgroups,
+ *			start load threads and latency probes, wait for their
+ *			completion and report statistics.
+ *			In sweep mode, also report achieved load and DMIPS
+ *			into CSV file.
+ *//*------------------------------------------------------------------------ */
+static int loadgen_run(int step, const struct timespec *deadline)
+{
+	double achieved, dmips, elapsed_s;
+	struct timespec ts_end;
+	int i, ret;
+
+	memset(thread_stats, 0,
+		cpu_count * threads_per_cpu * sizeof(worker_stats));
+	run_index++;
+	if (pool_deques != NULL) {
+		for (i = 0; i < cpu_count * threads_per_cpu; i++)
+			wsdeque_clear(&pool_deques[i]);
+	}
+
+	/* Create per-thread cgroups, cpu.max throttling the load threads */
+	if (cgroup_parent != NULL) {
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] == -1)
+				continue;
+			ret = cgroup_worker_create(i, cpuloads[i], period);
+			if (ret != 0)
+				return ret;
+		}
+	}
+
+	if (sample_interval != -1) {
+		sampler_window_reset();
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				sampler_mark("start step=%d cpu%d=%d", step, i,
+					cpuloads[i]);
+		}
+	}
+
+	if ((syscall_pct > 0) || (iowait_pct > 0))
+		sysload_stat_start(cpu_count);
+
+	/* Start load generation on cores accordingly */
+	for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+		threads[i] = -1;
+		if ((cpuloads[i / threads_per_cpu] == -1) ||
+			(engine_eligible())) {
+			dprintf("main: no load to be generated on CPU%d\n",
+				i / threads_per_cpu);
+			continue;
+		}
+		/*
+		 * Thread index is passed by value: passing &i would race with
+		 * this loop incrementing i before the thread reads it.
+		 */
+		ret = pthread_create(&threads[i], NULL, thread_loadgen,
+			(void *) (uintptr_t) i);
+		if (ret != 0) {
+			fprintf(stderr, "cpuloadgen: failed to fork %d! (%d)",
+			i, ret);
+			threads[i] = -1;
+			continue;
+		}
+	}
+	if (engine_eligible()) {
+		ret = engine_start();
+		if (ret != 0)
+			return ret;
+	}
+
+	/* Start wakeup latency probes alongside load threads */
+	if (probe_interval != -1) {
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				latency_probe_start(i, probe_interval,
+					probe_prio);
+		}
+	}
+
+	/* Measure energy while load threads run the sweep step */
+	if (energy_set) {
+		ret = energy_step_start(cpu_count * threads_per_cpu,
+			energy_settle, energy_window, energy_windows);
+		if (ret != 0)
+			fprintf(stderr,
+				"cpuloadgen: could not measure energy of step %d (%s)!\n",
+				step, strerror(-ret));
+	}
+
+	/* Load engine runs until deadline or duration, unless interrupted */
+	if ((engine != NULL) && (deadline == NULL) && (duration > 0)) {
+		clock_gettime(CLOCK_MONOTONIC, &ts_end);
+		ts_end.tv_sec += duration;
+		deadline = &ts_end;
+	}
+	if ((engine != NULL) && (deadline == NULL)) {
+		while (!halt)
+			sleep(1);
+	}
+
+	/* Stop load threads at deadline, unless interrupted meanwhile */
+	if (deadline != NULL) {
+		while ((!halt) && (clock_nanosleep(CLOCK_MONOTONIC,
+			TIMER_ABSTIME, deadline, NULL) == EINTR))
+			;
+		halt = 1;
+		for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+			if (threads[i] != -1)
+				pthread_kill(threads[i], SIGUSR1);
+		}
+	}
+
+	for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+		if (threads[i] == -1) {
+			continue;
+		}
+		pthread_join(threads[i], NULL);
+	}
+	if (engine != NULL) {
+		cpuloadgen_destroy(engine);
+		engine = NULL;
+	}
+	if (deadline != NULL)
+		halt = interrupted;
+
+	if (energy_set)
+		energy_step_stop(&step_energy);
+
+	/* Restore terminal before reports */
+	if (tui_set)
+		tui_stop();
+
+	if (probe_interval != -1)
+		latency_probe_stop();
+
+	if (pool_deques != NULL) {
+		for (i = 0; i < cpu_count * threads_per_cpu; i++)
+			thread_stats[i].tasks_left =
+				wsdeque_depth(&pool_deques[i]);
+	}
+
+	if (sample_interval != -1) {
+		sampler_mark("stop step=%d", step);
+		sampler_report();
+		if ((idle_set) || (dma_latency != -1))
+			cstate_report();
+	}
+
+	if (step != -1)
+		sweep_step_report(step);
+	if (results_file != NULL)
+		results_report(step);
+
+	if (probe_interval != -1) {
+		printf("\nWakeup latency (us):\n");
+		printf("%-6s %4s %10s %9s %9s %9s %9s %9s\n", "CPU", "Load",
+			"Samples", "Mean", "p50", "p99", "p99.9", "Max");
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				latency_report(i, cpuloads[i]);
+		}
+	}
+
+	if (service_us > 0.0) {
+		printf("\nRequests (us):\n");
+		printf("%-6s %4s %7s %9s %8s %9s %9s %9s %9s %9s %9s\n", "CPU",
+			"Load", "Util", "Req/s", "Backlog", "Mean", "p50", "p99",
+			"p99.9", "Max", "Wait p99");
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] == -1)
+				continue;
+			if (cpu_achieved(i, &achieved, &dmips, &elapsed_s) != 0)
+				achieved = elapsed_s = 0.0;
+			request_report(i, cpuloads[i], achieved, elapsed_s);
+		}
+	}
+
+	if (pool_task_us > 0.0)
+		pool_report();
+
+	if (lock_set)
+		lock_report();
+
+	if (coherence_set)
+		coherence_report();
+
+	if (tlb_set)
+		tlb_report();
+
+	if ((syscall_pct > 0) || (iowait_pct > 0))
+		sysload_report();
+
+	if ((threads_per_cpu > 1) || (wakeup_max != -1) || (migrate))
+		sched_stats_report();
+
+	placement_report();
+
+	if (perf_enabled)
+		perf_report();
+
+	if (cgroup_parent != NULL) {
+		printf("\n");
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				cgroup_worker_report(i, cpuloads[i]);
+		}
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_report
+ * @BRIEF		display sampled values averaged over last run.
+ * @DESCRIPTION		display sampled values averaged over last run, for
+ *			each loaded CPU core: average frequency, C-state
+ *			residency, maximum temperature and average power.
+ *//*------------------------------------------------------------------------ */
+static void sampler_report(void)
+{
+	sampler_summary sum;
+	int i;
+
+	printf("\n%-6s %4s %10s %9s %11s %9s\n", "CPU", "Load",
+		"Freq (MHz)", "Idle (%)", "Temp (C)", "Power (W)");
+	for (i = 0; i < cpu_count; i++) {
+		if (cpuloads[i] == -1)
+			continue;
+		sampler_window_get(i, &sum);
+		printf("CPU%-3d %3d%%", i, cpuloads[i]);
+		if (sum.freq_mhz >= 0.0)
+			printf(" %10.0f", sum.freq_mhz);
+		else
+			printf(" %10s", "n/a");
+		if (sum.idle_pct >= 0.0)
+			printf(" %9.1f", sum.idle_pct);
+		else
+			printf(" %9s", "n/a");
+		if (sum.temp_max_c >= 0.0)
+			printf(" %11.1f", sum.temp_max_c);
+		else
+			printf(" %11s", "n/a");
+		if (sum.power_w >= 0.0)
+			printf(" %9.2f\n", sum.power_w);
+		else
+			printf(" %9s\n", "n/a");
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cstate_report
+ * @BRIEF		display C-state residency over last run.
+ * @DESCRIPTION		display C-state residency over last run, for each
+ *			loaded CPU core, along with selected idle mode.
+ *//*------------------------------------------------------------------------ */
+static void cstate_report(void)
+{
+	const char *name;
+	double pct;
+	unsigned int state;
+	int i;
+
+	printf("\nC-state residency (idle=%s", idle_mode_name(idle));
+	if (dma_latency != -1)
+		printf(", dmalatency=%dus", dma_latency);
+	printf("):\n");
+	for (i = 0; i < cpu_count; i++) {
+		if (cpuloads[i] == -1)
+			continue;
+		printf("CPU%-3d %3d%%", i, cpuloads[i]);
+		for (state = 0;
+			sampler_cstate_get(i, state, &name, &pct) == 0; state++)
+			printf(" %s %.1f%%", name, pct);
+		if (state == 0)
+			printf(" n/a");
+		printf("\n");
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		pool_report
+ * @BRIEF		display work-stealing pool statistics of last run.
+ * @DESCRIPTION		display work-stealing pool statistics of last run,
+ *			for each loaded CPU core: utilisation, tasks produced,
+ *			run and stolen, queue depth (sampled at each period
+ *			start) and tasks left in queues at the end.
+ *//*------------------------------------------------------------------------ */
+static void pool_report(void)
+{
+	unsigned long long produced, run, stolen, depth_sum, samples;
+	unsigned long long depth_max, left;
+	double achieved, dmips, elapsed_s;
+	worker_stats *st;
+	int i, cpu;
+
+	printf("\nWork-stealing pool (%.0fus tasks, %d%% imbalance):\n",
+		pool_task_us, pool_imbalance);
+	printf("%-6s %4s %7s %10s %10s %10s %7s %9s %9s %8s\n", "CPU", "Load",
+		"Util", "Produced", "Run", "Stolen", "Stolen", "Depth avg",
+		"Depth max", "Left");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		produced = run = stolen = depth_sum = samples = 0;
+		depth_max = left = 0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			produced += st->tasks_produced;
+			run += st->tasks_run;
+			stolen += st->tasks_stolen;
+			depth_sum += st->depth_sum;
+			samples += st->depth_samples;
+			if (st->depth_max > depth_max)
+				depth_max = st->depth_max;
+			left += st->tasks_left;
+		}
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			achieved = 0.0;
+		printf("CPU%-3d %3d%% %6.1f%% %10llu %10llu %10llu %6.1f%% %9.1f %9llu %8llu\n",
+			cpu, cpuloads[cpu], achieved, produced, run, stolen,
+			(run != 0) ? 100.0 * (double) stolen / (double) run : 0.0,
+			(samples != 0) ?
+			(double) depth_sum / (double) samples : 0.0,
+			depth_max, left);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_report
+ * @BRIEF		display lock contention statistics of last run.
+ * @DESCRIPTION		display lock contention statistics of last run:
+ *			acquisitions per second of each loaded CPU core, and
+ *			overall throughput and fairness (Jain index and
+ *			min/max ratio of per-thread acquisitions).
+ *//*------------------------------------------------------------------------ */
+static void lock_report(void)
+{
+	double acq, sum = 0.0, sum2 = 0.0, min = -1.0, max = 0.0;
+	double achieved, dmips, elapsed_s, total_s = 0.0, cpu_acq;
+	worker_stats *st;
+	int i, cpu, n = 0;
+
+	printf("\nLock contention (%s", lock_name(lock_kind));
+	if (lock_kind == LOCK_RWLOCK)
+		printf(" %d%% writes", lock_write_pct);
+	printf(", cs=%.1fus, ncs=%.1fus):\n", cs_us, ncs_us);
+	printf("%-6s %4s %7s %12s\n", "CPU", "Load", "Util", "Acq/s");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			continue;
+		cpu_acq = 0.0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			acq = (double) st->kernel_ops;
+			cpu_acq += acq;
+			sum += acq;
+			sum2 += acq * acq;
+			if ((min < 0.0) || (acq < min))
+				min = acq;
+			if (acq > max)
+				max = acq;
+			n++;
+		}
+		if (elapsed_s > total_s)
+			total_s = elapsed_s;
+		printf("CPU%-3d %3d%% %6.1f%% %12.0f\n", cpu, cpuloads[cpu],
+			achieved, cpu_acq / elapsed_s);
+	}
+	if ((n == 0) || (total_s <= 0.0) || (sum2 == 0.0))
+		return;
+	printf("Total: %.0f acquisitions/s, %d threads, fairness %.3f (Jain), min/max %.3f\n",
+		sum / total_s, n, sum * sum / ((double) n * sum2),
+		min / max);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_report
+ * @BRIEF		display cache line ping-pong statistics of last run.
+ * @DESCRIPTION		display cache line ping-pong statistics of last run,
+ *			for each loaded CPU core: increments per second and
+ *			average increment latency over active time.
+ *//*------------------------------------------------------------------------ */
+static void coherence_report(void)
+{
+	unsigned long long ops, busy_ns;
+	double achieved, dmips, elapsed_s;
+	worker_stats *st;
+	int i, cpu;
+
+	printf("\nCache line ping-pong (%s sharing):\n",
+		coherence_name(coherence));
+	printf("%-6s %4s %7s %14s %10s\n", "CPU", "Load", "Util", "Ops/s",
+		"ns/op");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			continue;
+		ops = busy_ns = 0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			ops += st->kernel_ops;
+			busy_ns += st->kernel_busy_ns;
+		}
+		printf("CPU%-3d %3d%% %6.1f%% %14.0f %10.1f\n", cpu,
+			cpuloads[cpu], achieved, (double) ops / elapsed_s,
+			(ops != 0) ? (double) busy_ns / (double) ops : 0.0);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_cpu_counts
+ * @BRIEF		accumulate performance counters of a CPU core threads.
+ * @param[in]		cpu: CPU core ID
+ * @param[out]		counts: accumulated counters
+ * @DESCRIPTION		accumulate performance counters of a CPU core threads.
+ *//*------------------------------------------------------------------------ */
+static void perf_cpu_counts(int cpu, perf_counts *counts)
+{
+	int i;
+
+	memset(counts, 0, sizeof(perf_counts));
+	for (i = 0; i < threads_per_cpu; i++)
+		perf_add(counts, &thread_stats[cpu * threads_per_cpu + i].perf);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_report
+ * @BRIEF		display performance counters of last run.
+ * @DESCRIPTION		display performance counters of last run, for each
+ *			loaded CPU core: cycles, instructions, IPC, cache and
+ *			branch misses per 1000 instructions.
+ *//*------------------------------------------------------------------------ */
+static void perf_report(void)
+{
+	perf_counts c;
+	double kinst;
+	int cpu;
+
+	printf("\n%-6s %4s %16s %16s %6s %12s %12s %12s\n", "CPU", "Load",
+		"Cycles", "Instructions", "IPC", "Cache MPKI", "Branch MPKI",
+		"dTLB MPKI");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		perf_cpu_counts(cpu, &c);
+		printf("CPU%-3d %3d%%", cpu, cpuloads[cpu]);
+		if (c.valid[PERF_CYCLES])
+			printf(" %16llu", c.val[PERF_CYCLES]);
+		else
+			printf(" %16s", "n/a");
+		if (c.valid[PERF_INSTRUCTIONS])
+			printf(" %16llu", c.val[PERF_INSTRUCTIONS]);
+		else
+			printf(" %16s", "n/a");
+		if ((c.valid[PERF_CYCLES]) && (c.valid[PERF_INSTRUCTIONS]) &&
+			(c.val[PERF_CYCLES] != 0))
+			printf(" %6.2f", (double) c.val[PERF_INSTRUCTIONS] /
+				(double) c.val[PERF_CYCLES]);
+		else
+			printf(" %6s", "n/a");
+		kinst = (double) c.val[PERF_INSTRUCTIONS] / 1000.0;
+		if ((c.valid[PERF_CACHE_MISSES]) && (kinst > 0.0))
+			printf(" %12.3f",
+				(double) c.val[PERF_CACHE_MISSES] / kinst);
+		else
+			printf(" %12s", "n/a");
+		if ((c.valid[PERF_BRANCH_MISSES]) && (kinst > 0.0))
+			printf(" %12.3f",
+				(double) c.val[PERF_BRANCH_MISSES] / kinst);
+		else
+			printf(" %12s", "n/a");
+		if ((c.valid[PERF_DTLB_MISSES]) && (kinst > 0.0))
+			printf(" %12.3f\n",
+				(double) c.val[PERF_DTLB_MISSES] / kinst);
+		else
+			printf(" %12s\n", "n/a");
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_report
+ * @BRIEF		display TLB pressure statistics of last run.
+ * @DESCRIPTION		display TLB pressure statistics of last run, for each
+ *			loaded CPU core: accesses per second, average access
+ *			latency over active time and, if performance counters
+ *			are available, dTLB load misses per access.
+ *//*------------------------------------------------------------------------ */
+static void tlb_report(void)
+{
+	unsigned long long ops, busy_ns;
+	double achieved, dmips, elapsed_s;
+	worker_stats *st;
+	perf_counts c;
+	int i, cpu;
+
+	printf("\nTLB pressure (%zuMB per thread, %s pages):\n",
+		tlb_footprint / (1024 * 1024), tlb_pages_name(tlb_backing));
+	printf("%-6s %4s %7s %14s %10s %12s\n", "CPU", "Load", "Util",
+		"Accesses/s", "ns/access", "dTLB/access");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			continue;
+		ops = busy_ns = 0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			ops += st->kernel_ops;
+			busy_ns += st->kernel_busy_ns;
+		}
+		perf_cpu_counts(cpu, &c);
+		printf("CPU%-3d %3d%% %6.1f%% %14.0f %10.1f", cpu,
+			cpuloads[cpu], achieved, (double) ops / elapsed_s,
+			(ops != 0) ? (double) busy_ns / (double) ops : 0.0);
+		if ((c.valid[PERF_DTLB_MISSES]) && (ops != 0))
+			printf(" %12.3f\n",
+				(double) c.val[PERF_DTLB_MISSES] / (double) ops);
+		else
+			printf(" %12s\n", "n/a");
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_report
+ * @BRIEF		display system call and I/O wait statistics of last run.
+ * @DESCRIPTION		display system call and I/O wait statistics of last
+ *			run, for each loaded CPU core: achieved user, system,
+ *			iowait and idle split (CPU-wide, from /proc/stat),
+ *			system calls and reads per second.
+ *//*------------------------------------------------------------------------ */
+static void sysload_report(void)
+{
+	unsigned long long calls, reads;
+	double achieved, dmips, elapsed_s;
+	sysload_split split;
+	worker_stats *st;
+	int i, cpu;
+
+	printf("\nSystem load (syscall=%d%% %s, iowait=%d%%):\n", syscall_pct,
+		sysload_mix_name(syscall_mix), iowait_pct);
+	printf("%-6s %4s %7s %7s %7s %7s %12s %10s\n", "CPU", "Load", "User",
+		"System", "Iowait", "Idle", "Syscalls/s", "Reads/s");
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			continue;
+		calls = reads = 0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			calls += st->syscalls;
+			reads += st->io_reads;
+		}
+		printf("CPU%-3d %3d%%", cpu, cpuloads[cpu]);
+		if (sysload_stat_split(cpu, &split) == 0)
+			printf(" %6.1f%% %6.1f%% %6.1f%% %6.1f%%",
+				split.user_pct, split.sys_pct,
+				split.iowait_pct, split.idle_pct);
+		else
+			printf(" %7s %7s %7s %7s", "n/a", "n/a", "n/a", "n/a");
+		printf(" %12.0f %10.0f\n", (double) calls / elapsed_s,
+			(double) reads / elapsed_s);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		csv_value
+ * @BRIEF		append a value to sweep CSV line.
+ * @param[in]		val: value (< 0 if not available)
+ * @param[in]		fmt: value format
+ * @DESCRIPTION		append a value to sweep CSV line, leaving field empty
+ *			if value is not available.
+ *//*------------------------------------------------------------------------ */
+static void csv_value(double val, const char *fmt)
+{
+	fprintf(sweep_csv, ",");
+	if (val >= 0.0)
+		fprintf(sweep_csv, fmt, val);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpu_achieved
+ * @BRIEF		compute achieved load and DMIPS of a CPU core.
+ * @RETURNS		0 on success
+ *			-EAGAIN if CPU core was not loaded during last run
+ * @param[in]		cpu: CPU core ID
+ * @param[out]		achieved: achieved load (in %)
+ * @param[out]		dmips: Dhrystone MIPS
+ * @param[out]		elapsed_s: run duration (in seconds)
+ * @DESCRIPTION		compute achieved load (threads on-cpu time over
+ *			elapsed time) and DMIPS of a CPU core over last run.
+ *//*------------------------------------------------------------------------ */
+static int cpu_achieved(int cpu, double *achieved, double *dmips,
+	double *elapsed_s)
+{
+	double run_ns = 0.0, iterations = 0.0;
+	worker_stats *st;
+	int i;
+
+	*elapsed_s = 0.0;
+	for (i = 0; i < threads_per_cpu; i++) {
+		st = &thread_stats[cpu * threads_per_cpu + i];
+		run_ns += (double) st->run_ns;
+		iterations += (double) st->iterations;
+		if (st->elapsed_s > *elapsed_s)
+			*elapsed_s = st->elapsed_s;
+	}
+	if (*elapsed_s <= 0.0)
+		return -EAGAIN;
+	*achieved = 100.0 * run_ns / (*elapsed_s * 1.0e9);
+	*dmips = iterations / *elapsed_s / DHRYSTONE_VAX_MIPS;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_report
+ * @BRIEF		display energy measured over a load level.
+ * @param[in]		label: line label
+ * @param[in]		n: sweep step number or load level
+ * @param[in]		e: energy measured over load level
+ * @DESCRIPTION		display average power and energy per Dhrystone
+ *			iteration measured over a load level, with their 95%
+ *			confidence interval (if at least 2 windows completed).
+ *//*------------------------------------------------------------------------ */
+static void energy_report(const char *label, int n, const energy_step *e)
+{
+	if (e->windows == 0) {
+		printf("%s %d: energy not measured (no complete window).\n",
+			label, n);
+		return;
+	}
+	printf("%s %d: %.3f W", label, n, e->watts);
+	if (e->watts_ci >= 0.0)
+		printf(" +/- %.3f", e->watts_ci);
+	if (e->nj_per_iteration >= 0.0)
+		printf(", %.3f nJ/iteration", e->nj_per_iteration);
+	if (e->nj_per_iteration_ci >= 0.0)
+		printf(" +/- %.3f", e->nj_per_iteration_ci);
+	printf(" (%u windows)\n", e->windows);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sweep_step_report
+ * @BRIEF		report achieved load and DMIPS of a sweep step.
+ * @param[in]		step: sweep step number
+ * @DESCRIPTION		report achieved load (thread on-cpu time over
+ *			elapsed time) and DMIPS of each swept CPU core, and
+ *			wakeup latency and request response time percentiles,
+ *			and energy if enabled.
+ *			Display it and append it to CSV file (if any).
+ *//*------------------------------------------------------------------------ */
+static void sweep_step_report(int step)
+{
+	double elapsed_s, achieved, dmips;
+	const hist *h;
+	sampler_summary sum;
+	perf_counts pc;
+	int i, cpu, energy;
+
+	energy = (energy_set) && (step_energy.windows != 0);
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		if (cpu_achieved(cpu, &achieved, &dmips, &elapsed_s) != 0)
+			continue;
+		printf("Step %d: CPU%d requested %3d%%, achieved %5.1f%%, %.1f DMIPS\n",
+			step, cpu, cpuloads[cpu], achieved, dmips);
+		coord_agent_report("STEP %d %d %d %.2f %.1f", step, cpu,
+			cpuloads[cpu], achieved, dmips);
+
+		if (sweep_csv == NULL)
+			continue;
+		fprintf(sweep_csv, "%d,%d,%d,%.2f,%.1f,%.3f", step, cpu,
+			cpuloads[cpu], achieved, dmips, elapsed_s);
+		h = latency_probe_hist(cpu);
+		if ((h != NULL) && (h->count != 0))
+			fprintf(sweep_csv, ",%.1f,%.1f,%.1f,%.1f",
+				(double) hist_percentile(h, 50.0) / 1000.0,
+				(double) hist_percentile(h, 99.0) / 1000.0,
+				(double) hist_percentile(h, 99.9) / 1000.0,
+				(double) h->max / 1000.0);
+		else
+			fprintf(sweep_csv, ",,,,");
+		sampler_window_get(cpu, &sum);
+		csv_value(sum.freq_mhz, "%.0f");
+		csv_value(sum.idle_pct, "%.2f");
+		csv_value(sum.temp_max_c, "%.1f");
+		csv_value(sum.power_w, "%.3f");
+		perf_cpu_counts(cpu, &pc);
+		for (i = PERF_CYCLES; i <= PERF_INSTRUCTIONS; i++)
+			csv_value(pc.valid[i] ? (double) pc.val[i] : -1.0,
+				"%.0f");
+		csv_value(((pc.valid[PERF_CYCLES]) &&
+			(pc.valid[PERF_INSTRUCTIONS]) &&
+			(pc.val[PERF_CYCLES] != 0)) ?
+			(double) pc.val[PERF_INSTRUCTIONS] /
+			(double) pc.val[PERF_CYCLES] : -1.0, "%.3f");
+		for (i = PERF_CACHE_MISSES; i <= PERF_BRANCH_MISSES; i++)
+			csv_value(pc.valid[i] ? (double) pc.val[i] : -1.0,
+				"%.0f");
+		h = request_hist(cpu);
+		if ((h != NULL) && (h->count != 0))
+			fprintf(sweep_csv, ",%.1f,%.1f,%.1f,%.1f",
+				(double) hist_percentile(h, 50.0) / 1000.0,
+				(double) hist_percentile(h, 99.0) / 1000.0,
+				(double) hist_percentile(h, 99.9) / 1000.0,
+				(double) h->max / 1000.0);
+		else
+			fprintf(sweep_csv, ",,,,");
+		csv_value(pc.valid[PERF_DTLB_MISSES] ?
+			(double) pc.val[PERF_DTLB_MISSES] : -1.0, "%.0f");
+		csv_value(energy ? step_energy.watts : -1.0, "%.3f");
+		csv_value(energy ? step_energy.watts_ci : -1.0, "%.3f");
+		csv_value(energy ? step_energy.nj_per_iteration : -1.0, "%.4f");
+		csv_value(energy ? step_energy.nj_per_iteration_ci : -1.0,
+			"%.4f");
+		fprintf(sweep_csv, "\n");
+	}
+	if (sweep_csv != NULL)
+		fflush(sweep_csv);
+	if (energy_set)
+		energy_report("Step", step, &step_energy);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_report
+ * @BRIEF		save results of a run or sweep step.
+ * @param[in]		step: sweep step number (-1 if single run)
+ * @DESCRIPTION		save results of each loaded CPU core into results
+ *			file: achieved load, iterations, counters, sampled
+ *			values and histograms.
+ *//*------------------------------------------------------------------------ */
+static void results_report(int step)
+{
+	results_core rc;
+	worker_stats *st;
+	int i, cpu;
+
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		if (cpuloads[cpu] == -1)
+			continue;
+		memset(&rc, 0, sizeof(rc));
+		rc.step = step;
+		rc.cpu = cpu;
+		rc.requested = cpuloads[cpu];
+		if (cpu_achieved(cpu, &rc.achieved, &rc.dmips,
+			&rc.elapsed_s) != 0)
+			rc.achieved = rc.dmips = -1.0;
+		for (i = 0; i < threads_per_cpu; i++) {
+			st = &thread_stats[cpu * threads_per_cpu + i];
+			rc.iterations += st->iterations;
+			rc.kernel_ops += st->kernel_ops;
+			rc.syscalls += st->syscalls;
+			rc.io_reads += st->io_reads;
+			rc.repins += st->repins;
+			rc.parks += st->parks;
+			rc.parked_s += (double) st->parked_ns * 1.0e-9;
+		}
+		perf_cpu_counts(cpu, &rc.perf);
+		sampler_window_get(cpu, &rc.sampler);
+		rc.latency = latency_probe_hist(cpu);
+		rc.response = request_hist(cpu);
+		results_add(&rc);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_config
+ * @BRIEF		save run configuration.
+ * @DESCRIPTION		save run configuration into results file (options
+ *			that are set, after defaults are applied).
+ *//*------------------------------------------------------------------------ */
+static void results_config(void)
+{
+	const char *kernel = "dhrystone";
+
+	if (service_us > 0.0)
+		kernel = "service";
+	else if (pool_task_us > 0.0)
+		kernel = "pool";
+	else if (lock_set)
+		kernel = "lock";
+	else if (coherence_set)
+		kernel = "pingpong";
+	else if (tlb_set)
+		kernel = "tlb";
+	else if (scenario_file != NULL)
+		kernel = "scenario";
+
+	results_config_str("kernel", kernel);
+	results_config_str("dhrystone", dhry_variant_name(dhrystone_variant));
+	if (duration != -1)
+		results_config_num("duration_s", duration);
+	if (period != -1)
+		results_config_num("period_us", period);
+	if (policy != -1)
+		results_config_str("policy", policy_name(policy));
+	if (priority != -1)
+		results_config_num("priority", priority);
+	if (nice_level != NICE_UNSET)
+		results_config_num("nice", nice_level);
+	results_config_num("threads_per_cpu", threads_per_cpu);
+	results_config_num("migrate", migrate);
+	results_config_str("idle", idle_mode_name(idle));
+	if ((seed_set) || (seed != 0))
+		results_config_num("seed", seed);
+	if (wakeup_max != -1)
+		results_config_num("wakeup_us", wakeup_max);
+	if (probe_interval != -1)
+		results_config_num("probe_us", probe_interval);
+	if (sample_interval != -1)
+		results_config_num("sample_ms", sample_interval);
+	if (sweep_step != -1) {
+		results_config_num("sweep_start_pct", sweep_start);
+		results_config_num("sweep_stop_pct", sweep_stop);
+		results_config_num("sweep_step_pct", sweep_step);
+		results_config_num("sweep_dwell_s", sweep_dwell);
+		results_config_num("sweep_cooldown_s", sweep_cooldown);
+	}
+	if (energy_set) {
+		results_config_num("energy_settle_s", energy_settle);
+		results_config_num("energy_window_s", energy_window);
+		results_config_num("energy_windows", energy_windows);
+	}
+	if (service_us > 0.0)
+		results_config_num("service_us", service_us);
+	if (pool_task_us > 0.0)
+		results_config_num("pool_task_us", pool_task_us);
+	if (tlb_set)
+		results_config_num("tlb_bytes", tlb_footprint);
+	if (syscall_pct > 0)
+		results_config_num("syscall_pct", syscall_pct);
+	if (iowait_pct > 0)
+		results_config_num("iowait_pct", iowait_pct);
+	if (scenario_file != NULL)
+		results_config_str("scenario", scenario_file);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sweep_csv_header
+ * @BRIEF		write sweep CSV file header.
+ * @DESCRIPTION		write sweep CSV file header (if any).
+ *//*------------------------------------------------------------------------ */
+static void sweep_csv_header(void)
+{
+	if (sweep_csv == NULL)
+		return;
+
+	fprintf(sweep_csv, "step,cpu,load,achieved_load,dmips,duration_s,"
+		"latency_p50_us,latency_p99_us,latency_p999_us,latency_max_us,"
+		"freq_mhz,idle_pct,temp_max_c,power_w,"
+		"cycles,instructions,ipc,cache_misses,branch_misses,"
+		"request_p50_us,request_p99_us,request_p999_us,"
+		"request_max_us,dtlb_misses,"
+		"energy_w,energy_w_ci,nj_per_iteration,nj_per_iteration_ci\n");
+	fflush(sweep_csv);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_sweep
+ * @BRIEF		sweep load setpoint on selected CPU cores.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @DESCRIPTION		sweep load setpoint on selected CPU cores, from
+ *			sweep_start to sweep_stop by sweep_step, each step
+ *			lasting sweep_dwell seconds, optionally followed by
+ *			sweep_cooldown seconds without load. Energy measured
+ *			over each step (if enabled) is summarised at the end.
+ *//*------------------------------------------------------------------------ */
+static int loadgen_sweep(void)
+{
+	energy_step *energy_steps = NULL;
+	int *selected;
+	int i, load, step, ret = 0;
+	long int t;
+
+	selected = malloc(cpu_count * sizeof(int));
+	if (selected == NULL)
+		return -ENOMEM;
+	if (energy_set) {
+		energy_steps = calloc((sweep_stop - sweep_start) / sweep_step + 1,
+			sizeof(energy_step));
+		if (energy_steps == NULL) {
+			free(selected);
+			return -ENOMEM;
+		}
+	}
+	for (i = 0; i < cpu_count; i++)
+		selected[i] = (cpuloads[i] != -1);
+
+	sweep_csv_header();
+
+	duration = sweep_dwell;
+	step = 0;
+	for (load = sweep_start; (load <= sweep_stop) && (!halt);
+		load += sweep_step) {
+		printf("Step %d: generating %d%% load for %lds...\n",
+			step, load, sweep_dwell);
+		for (i = 0; i < cpu_count; i++)
+			cpuloads[i] = selected[i] ? load : -1;
+		ret = loadgen_run(step, NULL);
+		if (ret != 0)
+			break;
+		if (energy_steps != NULL)
+			energy_steps[step] = step_energy;
+		step++;
+
+		if ((sweep_cooldown > 0) && (load + sweep_step <= sweep_stop)) {
+			printf("Cooling down for %lds...\n", sweep_cooldown);
+			if (sample_interval != -1)
+				sampler_mark("cooldown step=%d", step - 1);
+			for (t = 0; (t < sweep_cooldown) && (!halt); t++)
+				sleep(1);
+		}
+	}
+
+	if (energy_steps != NULL) {
+		printf("\nEnergy per load level (mean +/- 95%% confidence interval):\n");
+		for (i = 0; i < step; i++)
+			energy_report("Load", sweep_start + i * sweep_step,
+				&energy_steps[i]);
+		free(energy_steps);
+	}
+
+	for (i = 0; i < cpu_count; i++)
+		cpuloads[i] = selected[i] ? sweep_stop : -1;
+	free(selected);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_prepare
+ * @BRIEF		check scenario against global options, prepare phases.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @DESCRIPTION		check each scenario phase against global options,
+ *			following command line compatibility rules, before
+ *			anything runs. Then prepare resources shared by
+ *			phases: performance counters for tlb, reserved huge
+ *			pages, I/O wait file.
+ *//*------------------------------------------------------------------------ */
+static int scenario_prepare(void)
+{
+	const scenario_phase *ph;
+	const char *io_file = NULL;
+	unsigned int k, n;
+	int io = 0, ret, cpu;
+
+	for (k = 0; k < scenario_len(); k++) {
+		ph = scenario_get(k);
+		if (((ph->tlb_mb != 0) || (ph->pingpong != -1) ||
+			(ph->jitter_set)) && (wakeup_max != -1)) {
+			fprintf(stderr,
+				"cpuloadgen: phase %s: tlb, pingpong and jitter are not compatible with wakeup!\n",
+				ph->name);
+			return -EINVAL;
+		}
+		if (((ph->syscall_pct > 0) || (ph->iowait_pct > 0)) &&
+			((policy == SCHED_DEADLINE) || (cgroup_parent != NULL))) {
+			fprintf(stderr,
+				"cpuloadgen: phase %s: syscall and iowait are not compatible with deadline and cgroup!\n",
+				ph->name);
+			return -EINVAL;
+		}
+		if (ph->iowait_pct > 0) {
+			if ((io) && (((io_file == NULL) !=
+				(ph->iowait_file == NULL)) ||
+				((io_file != NULL) &&
+				(strcmp(io_file, ph->iowait_file) != 0)))) {
+				fprintf(stderr,
+					"cpuloadgen: phase %s: all phases must use the same iowait file!\n",
+					ph->name);
+				return -EINVAL;
+			}
+			io = 1;
+			io_file = ph->iowait_file;
+		}
+		if (ph->tlb_mb == 0)
+			continue;
+		/* dTLB misses are the point of this kernel */
+		perf_enabled = 1;
+		for (cpu = 0, n = 0; cpu < cpu_count; cpu++)
+			n += (ph->loads[cpu] != -1);
+		ret = tlb_check(ph->tlb_backing, (size_t) ph->tlb_mb * 1024 * 1024,
+			n * threads_per_cpu);
+		if (ret != 0)
+			return ret;
+	}
+
+	if (io)
+		return sysload_io_init(io_file);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_scenario
+ * @BRIEF		run scenario phases.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @DESCRIPTION		run scenario phases in a row. Phase boundaries are
+ *			absolute times on a single timeline starting with the
+ *			first phase, so that time spent in between (reports,
+ *			hooks) does not accumulate: it is taken from the next
+ *			phase. Each phase sets loads, period (period-based
+ *			PWM is always used, even at 100%), jitter and kernel
+ *			of the run, runs its hooks, and is reported as a
+ *			sweep step (and to coordinator, if any). In agent
+ *			mode, first phase starts at the time agreed with
+ *			coordinator.
+ *//*------------------------------------------------------------------------ */
+static int loadgen_scenario(void)
+{
+	const scenario_phase *ph;
+	struct timespec start, deadline, now;
+	long int base_period = period;
+	double late_ms;
+	unsigned int k;
+	int cpu, ret = 0;
+
+	sweep_csv_header();
+
+	duration = 0;
+	if (scenario_start_set) {
+		/* Common start time agreed with coordinator */
+		while ((!halt) && (clock_nanosleep(CLOCK_MONOTONIC,
+			TIMER_ABSTIME, &scenario_start, NULL) == EINTR))
+			;
+		deadline = scenario_start;
+	} else {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+	}
+	for (k = 0; (k < scenario_len()) && (!halt); k++) {
+		ph = scenario_get(k);
+		for (cpu = 0; cpu < cpu_count; cpu++)
+			cpuloads[cpu] = ph->loads[cpu];
+		jitter.type = DIST_CONSTANT;
+		if (ph->jitter_set)
+			jitter = ph->jitter;
+		tlb_set = (ph->tlb_mb != 0);
+		tlb_footprint = (size_t) ph->tlb_mb * 1024 * 1024;
+		tlb_backing = ph->tlb_backing;
+		coherence_set = (ph->pingpong != -1);
+		syscall_pct = ph->syscall_pct;
+		syscall_mix = ph->syscall_mix;
+		iowait_pct = ph->iowait_pct;
+		/* Period-based PWM checks for phase end every chunk */
+		period = (ph->period != -1) ? ph->period : base_period;
+		if (period == -1)
+			period = DEFAULT_PERIOD_US;
+		if (coherence_set) {
+			coherence = (coherence_mode) ph->pingpong;
+			ret = coherence_init(coherence,
+				cpu_count * threads_per_cpu);
+			if (ret != 0)
+				break;
+		}
+
+		start = deadline;
+		timespec_add_us(&deadline, ph->duration_s * 1.0e6);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		late_ms = timespec_diff_us(&now, &start) / 1000.0;
+		printf("\nPhase %u (%s): %.3fs", k, ph->name, ph->duration_s);
+		if (late_ms >= 1.0)
+			printf(", started %.1fms late", late_ms);
+		printf("\n");
+		if (sample_interval != -1) {
+			if (ph->sample == 0)
+				sampler_enable(0);
+			sampler_mark("phase %u %s", k, ph->name);
+			if (ph->sample == 1)
+				sampler_enable(1);
+		}
+		if (ph->onstart != NULL)
+			scenario_hook(ph->onstart);
+		coord_agent_report("PHASE %u %lld", k, coord_agent_time_ns());
+		ret = loadgen_run(k, &deadline);
+		if (ph->onstop != NULL)
+			scenario_hook(ph->onstop);
+		coherence_deinit();
+		if (ret != 0)
+			break;
+	}
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		main
+ * @BRIEF		main entry point
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ *			-ECHILD in case of failure to fork
+ * @param[in, out]	argc: shell input argument number
+ * @param[in, out]	argv: shell input argument(s)
+ * @DESCRIPTION		main entry point
+ *//*------------------------------------------------------------------------ */
+int main(int argc, char *argv[])
+{
+	unsigned int tlb_mb;
+	int i, ret, n, load;
+	long int duration2;
+	char *coord_buf;
+	size_t coord_len;
+
+	/*
+	 * Register signal handler in order to be able to
+	 * stop load threads if user kills process
+	 */
+	signal(SIGTERM, (sighandler_t) sigterm_handler);
+	signal(SIGINT, (sighandler_t) sigterm_handler);
+	signal(SIGUSR1, (sighandler_t) wakeup_handler);
+	main_thread = pthread_self();
+
+	printf("CPULOADGEN (REV %s built %s)\n\n",
+		CPULOADGEN_REVISION, builddate);
+
+	/*
+	 * Sized for all configured CPU cores, not only online ones: CPU core
+	 * numbering has holes when some are offline, and they may come back
+	 * online during the run.
+	 */
+	cpu_count = (int) sysconf(_SC_NPROCESSORS_CONF);
+	if (cpu_count < 1) {
+		fprintf(stderr, "cpuloadgen: could not determine CPU cores count!!! (%d)\n",
+			cpu_count);
+		return cpu_count;
+	}
+	dprintf("main: found %d CPU cores.\n", cpu_count);
+	ret = hotplug_init(cpu_count);
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+		return ret;
+	}
+
+	/* Allocate buffers */
+	cpuloads = malloc(cpu_count * sizeof(int));
+	if (cpuloads == NULL) {
+		fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+		return -ENOMEM;
+	}
+	/* Initialize variables */
+	if (argc == 1) {
+		/* No user arguments, use default */
+		for (i = 0; i < cpu_count; i++)
+			cpuloads[i] = hotplug_cpu_available(i) ? 100 : -1;
+		duration = -1;
+	} else {
+		for (i = 0; i < cpu_count; i++)
+			cpuloads[i] = -1;
+		duration = -1;
+
+		/* Parse arguments */
+		for (i = 1; i < argc; i++) {
+			dprintf("main: argv[i]=%s\n", argv[i]);
+			if (strncmp(argv[i], "cpu", 3) == 0) {
+				ret = sscanf(argv[i], "cpu%d=%d", &n, &load);
+				if ((ret != 2) ||
+					((n < 0) || (n >= cpu_count)) ||
+					((load < 1) || (load > 100)))
+					return einval(argv[i]);
+				if (cpuloads[n] != -1) {
+					fprintf(stderr,
+						"cpuloadgen: CPU%d was already assigned a load of %d!\n\n",
+						n, cpuloads[n]);
+					free_buffers();
+					return -EINVAL;
+				}
+				cpuloads[n] = load;
+				dprintf("Load assigned to CPU%d: %d%%\n",
+					n, cpuloads[n]);
+			} else if (strncmp(argv[i], "duration=", 9) == 0) {
+				ret = sscanf(argv[i], "duration=%ld",
+					&duration2);
+				if ((ret != 1) || (duration2 < 1)) {
+					return einval(argv[i]);
+				}
+				if (duration != -1) {
+					fprintf(stderr,
+						"cpuloadgen: duration was already set to %ld!\n\n",
+						duration);
+					free_buffers();
+					return -EINVAL;
+				}
+				duration = duration2;
+				dprintf("Duration of the load generation: %lds\n",
+					duration);
+			} else if (strncmp(argv[i], "period=", 7) == 0) {
+				ret = sscanf(argv[i], "period=%ld",
+					&duration2);
+				if ((ret != 1) || (duration2 < 1) ||
+					(duration2 > PERIOD_MAX_US))
+					return einval(argv[i]);
+				if (period != -1) {
+					fprintf(stderr,
+						"cpuloadgen: period was already set to %ld!\n\n",
+						period);
+					free_buffers();
+					return -EINVAL;
+				}
+				period = duration2;
+				dprintf("PWM period: %ldus\n", period);
+			} else if (strncmp(argv[i], "policy=", 7) == 0) {
+				ret = policy_parse(argv[i] + 7);
+				if (ret < 0)
+					return einval(argv[i]);
+				if (policy != -1) {
+					fprintf(stderr,
+						"cpuloadgen: policy was already set to %s!\n\n",
+						policy_name(policy));
+					free_buffers();
+					return -EINVAL;
+				}
+				policy = ret;
+				dprintf("Scheduling policy: %s\n",
+					policy_name(policy));
+			} else if (strncmp(argv[i], "prio=", 5) == 0) {
+				ret = sscanf(argv[i], "prio=%d", &n);
+				if ((ret != 1) || (n < 1) || (n > 99))
+					return einval(argv[i]);
+				if (priority != -1) {
+					fprintf(stderr,
+						"cpuloadgen: priority was already set to %d!\n\n",
+						priority);
+					free_buffers();
+					return -EINVAL;
+				}
+				priority = n;
+				dprintf("Real-time priority: %d\n", priority);
+			} else if (strncmp(argv[i], "nice=", 5) == 0) {
+				ret = sscanf(argv[i], "nice=%d", &n);
+				if ((ret != 1) || (n < -20) || (n > 19))
+					return einval(argv[i]);
+				if (nice_level != NICE_UNSET) {
+					fprintf(stderr,
+						"cpuloadgen: nice level was already set to %d!\n\n",
+						nice_level);
+					free_buffers();
+					return -EINVAL;
+				}
+				nice_level = n;
+				dprintf("Nice level: %d\n", nice_level);
+			} else if (strncmp(argv[i], "cgroup=", 7) == 0) {
+				if (argv[i][7] == '\0')
+					return einval(argv[i]);
+				if (cgroup_parent != NULL) {
+					fprintf(stderr,
+						"cpuloadgen: cgroup was already set to %s!\n\n",
+						cgroup_parent);
+					free_buffers();
+					return -EINVAL;
+				}
+				cgroup_parent = argv[i] + 7;
+				dprintf("Parent cgroup: %s\n", cgroup_parent);
+			} else if (strncmp(argv[i], "threads=", 8) == 0) {
+				ret = sscanf(argv[i], "threads=%d", &n);
+				if ((ret != 1) || (n < 1) ||
+					(n > THREADS_PER_CPU_MAX))
+					return einval(argv[i]);
+				if (threads_per_cpu != 1) {
+					fprintf(stderr,
+						"cpuloadgen: threads was already set to %d!\n\n",
+						threads_per_cpu);
+					free_buffers();
+					return -EINVAL;
+				}
+				threads_per_cpu = n;
+				dprintf("Threads per CPU: %d\n", threads_per_cpu);
+			} else if (strncmp(argv[i], "wakeup=", 7) == 0) {
+				ret = sscanf(argv[i], "wakeup=%ld",
+					&duration2);
+				if ((ret != 1) || (duration2 < 1))
+					return einval(argv[i]);
+				if (wakeup_max != -1) {
+					fprintf(stderr,
+						"cpuloadgen: wakeup was already set to %ld!\n\n",
+						wakeup_max);
+					free_buffers();
+					return -EINVAL;
+				}
+				wakeup_max = duration2;
+				dprintf("Max idle sleep: %ldus\n", wakeup_max);
+			} else if (strncmp(argv[i], "probe=", 6) == 0) {
+				ret = sscanf(argv[i], "probe=%ld",
+					&duration2);
+				if ((ret != 1) || (duration2 < 1))
+					return einval(argv[i]);
+				if (probe_interval != -1) {
+					fprintf(stderr,
+						"cpuloadgen: probe was already set to %ld!\n\n",
+						probe_interval);
+					free_buffers();
+					return -EINVAL;
+				}
+				probe_interval = duration2;
+				dprintf("Latency probe interval: %ldus\n",
+					probe_interval);
+			} else if (strncmp(argv[i], "probeprio=", 10) == 0) {
+				ret = sscanf(argv[i], "probeprio=%d", &n);
+				if ((ret != 1) || (n < 1) || (n > 99))
+					return einval(argv[i]);
+				if (probe_prio != 0) {
+					fprintf(stderr,
+						"cpuloadgen: probeprio was already set to %d!\n\n",
+						probe_prio);
+					free_buffers();
+					return -EINVAL;
+				}
+				probe_prio = n;
+				dprintf("Latency probe priority: %d\n",
+					probe_prio);
+			} else if (strncmp(argv[i], "sweep=", 6) == 0) {
+				if (sweep_step != -1) {
+					fprintf(stderr,
+						"cpuloadgen: sweep was already set!\n\n");
+					free_buffers();
+					return -EINVAL;
+				}
+				if (sweep_parse(argv[i] + 6) != 0)
+					return einval(argv[i]);
+			} else if ((strcmp(argv[i], "energy") == 0) ||
+				(strncmp(argv[i], "energy=", 7) == 0)) {
+				if (energy_set)
+					return einval(argv[i]);
+				if ((argv[i][6] == '=') &&
+					(energy_parse(argv[i] + 7) != 0))
+					return einval(argv[i]);
+				energy_set = 1;
+			} else if (strncmp(argv[i], "csv=", 4) == 0) {
+				if ((argv[i][4] == '\0') || (sweep_csv != NULL))
+					return einval(argv[i]);
+				sweep_csv = fopen(argv[i] + 4, "w");
+				if (sweep_csv == NULL) {
+					fprintf(stderr,
+						"cpuloadgen: could not create %s (%s)!\n\n",
+						argv[i] + 4, strerror(errno));
+					free_buffers();
+					return -errno;
+				}
+			} else if (strncmp(argv[i], "sample=", 7) == 0) {
+				ret = sscanf(argv[i], "sample=%ld",
+					&duration2);
+				if ((ret != 1) || (duration2 < 1))
+					return einval(argv[i]);
+				if (sample_interval != -1) {
+					fprintf(stderr,
+						"cpuloadgen: sample was already set to %ld!\n\n",
+						sample_interval);
+					free_buffers();
+					return -EINVAL;
+				}
+				sample_interval = duration2;
+				dprintf("Sampling interval: %ldms\n",
+					sample_interval);
+			} else if (strncmp(argv[i], "samples=", 8) == 0) {
+				if ((argv[i][8] == '\0') || (samples_file != NULL))
+					return einval(argv[i]);
+				samples_file = argv[i] + 8;
+			} else if (strcmp(argv[i], "perf") == 0) {
+				if (perf_set)
+					return einval(argv[i]);
+				perf_set = 1;
+				perf_enabled = 1;
+				dprintf("Performance counters enabled\n");
+			} else if (strncmp(argv[i], "idle=", 5) == 0) {
+				ret = idle_mode_parse(argv[i] + 5);
+				if ((ret < 0) || (idle_set))
+					return einval(argv[i]);
+				idle = (idle_mode) ret;
+				idle_set = 1;
+				dprintf("Idle mode: %s\n", idle_mode_name(idle));
+			} else if (strncmp(argv[i], "dmalatency=", 11) == 0) {
+				ret = sscanf(argv[i], "dmalatency=%d", &n);
+				if ((ret != 1) || (n < 0) || (dma_latency != -1))
+					return einval(argv[i]);
+				dma_latency = n;
+				dprintf("Max CPU wakeup latency: %dus\n",
+					dma_latency);
+			} else if (strncmp(argv[i], "jitter=", 7) == 0) {
+				if ((jitter.type != DIST_CONSTANT) ||
+					(dist_parse(argv[i] + 7, &jitter) != 0))
+					return einval(argv[i]);
+				dprintf("Jitter: %s (%f)\n",
+					dist_name(jitter.type), jitter.shape);
+			} else if (strncmp(argv[i], "seed=", 5) == 0) {
+				ret = sscanf(argv[i], "seed=%llu", &seed);
+				if ((ret != 1) || (seed_set))
+					return einval(argv[i]);
+				seed_set = 1;
+				dprintf("Seed: %llu\n", seed);
+			} else if (strncmp(argv[i], "service=", 8) == 0) {
+				if (service_us > 0.0)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "service=%lf%n",
+					&service_us, &n);
+				if ((ret != 1) || (service_us <= 0.0))
+					return einval(argv[i]);
+				if ((argv[i][n] != '\0') &&
+					((strncmp(argv[i] + n, ",dist=", 6) != 0) ||
+					(dist_parse(argv[i] + n + 6,
+					&service_dist) != 0)))
+					return einval(argv[i]);
+				dprintf("Service time: %fus (%s)\n", service_us,
+					dist_name(service_dist.type));
+			} else if (strncmp(argv[i], "rate=", 5) == 0) {
+				if (request_rate > 0.0)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "rate=%lf", &request_rate);
+				if ((ret != 1) || (request_rate <= 0.0))
+					return einval(argv[i]);
+				dprintf("Request rate: %f/s\n", request_rate);
+			} else if (strncmp(argv[i], "trace=", 6) == 0) {
+				if ((argv[i][6] == '\0') || (trace_file != NULL))
+					return einval(argv[i]);
+				trace_file = argv[i] + 6;
+			} else if (strncmp(argv[i], "pool=", 5) == 0) {
+				if (pool_task_us > 0.0)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "pool=%lf", &pool_task_us);
+				if ((ret != 1) || (pool_task_us <= 0.0))
+					return einval(argv[i]);
+				dprintf("Pool task duration: %fus\n",
+					pool_task_us);
+			} else if (strncmp(argv[i], "imbalance=", 10) == 0) {
+				ret = sscanf(argv[i], "imbalance=%d",
+					&pool_imbalance);
+				if ((ret != 1) || (pool_imbalance < 0) ||
+					(pool_imbalance > 100) || (pool_imbalance_set))
+					return einval(argv[i]);
+				pool_imbalance_set = 1;
+				dprintf("Pool imbalance: %d%%\n", pool_imbalance);
+			} else if (strncmp(argv[i], "lock=", 5) == 0) {
+				if ((lock_set) || (lock_parse(argv[i] + 5,
+					&lock_kind, &lock_write_pct) != 0))
+					return einval(argv[i]);
+				lock_set = 1;
+				dprintf("Lock: %s\n", lock_name(lock_kind));
+			} else if (strncmp(argv[i], "cs=", 3) == 0) {
+				if (cs_us >= 0.0)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "cs=%lf", &cs_us);
+				if ((ret != 1) || (cs_us < 0.0))
+					return einval(argv[i]);
+			} else if (strncmp(argv[i], "ncs=", 4) == 0) {
+				if (ncs_us >= 0.0)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "ncs=%lf", &ncs_us);
+				if ((ret != 1) || (ncs_us < 0.0))
+					return einval(argv[i]);
+			} else if (strncmp(argv[i], "pingpong=", 9) == 0) {
+				ret = coherence_parse(argv[i] + 9);
+				if ((ret < 0) || (coherence_set))
+					return einval(argv[i]);
+				coherence = (coherence_mode) ret;
+				coherence_set = 1;
+			} else if (strcmp(argv[i], "c2c") == 0) {
+				if (c2c_roundtrips != -1)
+					return einval(argv[i]);
+				c2c_roundtrips = DEFAULT_C2C_ROUNDTRIPS;
+			} else if (strncmp(argv[i], "c2c=", 4) == 0) {
+				if (c2c_roundtrips != -1)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "c2c=%ld", &c2c_roundtrips);
+				if ((ret != 1) || (c2c_roundtrips < 1))
+					return einval(argv[i]);
+			} else if (strcmp(argv[i], "chunkbench") == 0) {
+				if (chunkbench_s != -1)
+					return einval(argv[i]);
+				chunkbench_s = DEFAULT_CHUNKBENCH_S;
+			} else if (strncmp(argv[i], "chunkbench=", 11) == 0) {
+				if (chunkbench_s != -1)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "chunkbench=%d",
+					&chunkbench_s);
+				if ((ret != 1) || (chunkbench_s < 1))
+					return einval(argv[i]);
+			} else if (strncmp(argv[i], "dhrystone=", 10) == 0) {
+				ret = dhry_variant_parse(argv[i] + 10);
+				if ((ret < 0) || (dhrystone_set))
+					return einval(argv[i]);
+				dhrystone_variant = (dhry_variant) ret;
+				dhrystone_set = 1;
+			} else if (strcmp(argv[i], "dhrybench") == 0) {
+				if (dhrybench_s != -1)
+					return einval(argv[i]);
+				dhrybench_s = DEFAULT_DHRYBENCH_S;
+			} else if (strncmp(argv[i], "dhrybench=", 10) == 0) {
+				if (dhrybench_s != -1)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "dhrybench=%d",
+					&dhrybench_s);
+				if ((ret != 1) || (dhrybench_s < 1))
+					return einval(argv[i]);
+			} else if (strncmp(argv[i], "tlb=", 4) == 0) {
+				ret = sscanf(argv[i], "tlb=%u%n", &tlb_mb, &n);
+				if ((ret != 1) || (tlb_mb < 1) || (tlb_set))
+					return einval(argv[i]);
+				if (argv[i][n] != '\0') {
+					if (strncmp(argv[i] + n, ",pages=", 7) != 0)
+						return einval(argv[i]);
+					ret = tlb_pages_parse(argv[i] + n + 7);
+					if (ret < 0)
+						return einval(argv[i]);
+					tlb_backing = (tlb_pages) ret;
+				}
+				tlb_footprint = (size_t) tlb_mb * 1024 * 1024;
+				tlb_set = 1;
+				/* dTLB misses are the point of this kernel */
+				perf_enabled = 1;
+				dprintf("TLB: %uMB (%s)\n", tlb_mb,
+					tlb_pages_name(tlb_backing));
+			} else if (strncmp(argv[i], "syscall=", 8) == 0) {
+				ret = sscanf(argv[i], "syscall=%d%n",
+					&syscall_pct, &n);
+				if ((ret != 1) || (syscall_pct < 1) ||
+					(syscall_pct > 100))
+					return einval(argv[i]);
+				if (argv[i][n] != '\0') {
+					if (strncmp(argv[i] + n, ",mix=", 5) != 0)
+						return einval(argv[i]);
+					ret = sysload_mix_parse(argv[i] + n + 5);
+					if (ret < 0)
+						return einval(argv[i]);
+					syscall_mix = (sysload_mix) ret;
+				}
+				dprintf("Syscall: %d%% (%s)\n", syscall_pct,
+					sysload_mix_name(syscall_mix));
+			} else if (strncmp(argv[i], "iowait=", 7) == 0) {
+				ret = sscanf(argv[i], "iowait=%d%n",
+					&iowait_pct, &n);
+				if ((ret != 1) || (iowait_pct < 1) ||
+					(iowait_pct > 100))
+					return einval(argv[i]);
+				if (argv[i][n] != '\0') {
+					if ((strncmp(argv[i] + n, ",file=", 6) != 0) ||
+						(argv[i][n + 6] == '\0'))
+						return einval(argv[i]);
+					iowait_file = argv[i] + n + 6;
+				}
+				dprintf("Iowait: %d%%\n", iowait_pct);
+			} else if (strncmp(argv[i], "scenario=", 9) == 0) {
+				if ((argv[i][9] == '\0') || (scenario_file != NULL))
+					return einval(argv[i]);
+				scenario_file = argv[i] + 9;
+			} else if (strncmp(argv[i], "coordinator=", 12) == 0) {
+				if ((argv[i][12] == '\0') || (coord_bind != NULL))
+					return einval(argv[i]);
+				coord_bind = argv[i] + 12;
+			} else if (strncmp(argv[i], "agents=", 7) == 0) {
+				if (coord_agents != -1)
+					return einval(argv[i]);
+				ret = sscanf(argv[i], "agents=%d%n",
+					&coord_agents, &n);
+				if ((ret != 1) || (argv[i][n] != '\0') ||
+					(coord_agents < 1) ||
+					(coord_agents > COORD_AGENTS_MAX))
+					return einval(argv[i]);
+			} else if (strncmp(argv[i], "agent=", 6) == 0) {
+				if ((argv[i][6] == '\0') || (coord_addr != NULL))
+					return einval(argv[i]);
+				coord_addr = argv[i] + 6;
+			} else if (strcmp(argv[i], "hooks") == 0) {
+				if (coord_hooks)
+					return einval(argv[i]);
+				coord_hooks = 1;
+			} else if (strncmp(argv[i], "results=", 8) == 0) {
+				if ((argv[i][8] == '\0') || (results_file != NULL))
+					return einval(argv[i]);
+				results_file = argv[i] + 8;
+			} else if (strncmp(argv[i], "metrics=", 8) == 0) {
+				if ((argv[i][8] == '\0') || (metrics_addr != NULL))
+					return einval(argv[i]);
+				metrics_addr = argv[i] + 8;
+			} else if (strcmp(argv[i], "tui") == 0) {
+				if (tui_set)
+					return einval(argv[i]);
+				tui_set = 1;
+			} else if (strcmp(argv[i], "migrate") == 0) {
+				if (migrate)
+					return einval(argv[i]);
+				migrate = 1;
+				dprintf("Threads not pinned\n");
+			} else {
+				return einval(argv[i]);
+			}
+		}
+	}
+
+	if ((coord_bind != NULL) && ((scenario_file == NULL) ||
+		(coord_agents == -1) || (coord_addr != NULL))) {
+		fprintf(stderr,
+			"cpuloadgen: coordinator requires scenario and agents, and is not compatible with agent!\n\n");
+		free_buffers();
+		return -EINVAL;
+	} else if ((coord_agents != -1) && (coord_bind == NULL)) {
+		fprintf(stderr, "cpuloadgen: agents requires coordinator!\n\n");
+		free_buffers();
+		return -EINVAL;
+	} else if ((coord_hooks) && (coord_addr == NULL)) {
+		fprintf(stderr, "cpuloadgen: hooks requires agent!\n\n");
+		free_buffers();
+		return -EINVAL;
+	} else if ((coord_addr != NULL) && (scenario_file != NULL)) {
+		fprintf(stderr,
+			"cpuloadgen: agent and scenario are mutually exclusive (scenario is sent by coordinator)!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if (coord_addr != NULL)
+		scenario_file = coord_addr;
+
+	if (scenario_file != NULL) {
+		for (i = 0; (i < cpu_count) && (cpuloads[i] == -1); i++)
+			;
+		if ((i != cpu_count) || (duration != -1) ||
+			(sweep_step != -1) || (service_us > 0.0) ||
+			(pool_task_us > 0.0) || (lock_set) || (coherence_set) ||
+			(tlb_set) || (syscall_pct > 0) || (iowait_pct > 0) ||
+			(jitter.type != DIST_CONSTANT) ||
+			(c2c_roundtrips != -1)) {
+			fprintf(stderr,
+				"cpuloadgen: scenario is not compatible with cpu loads, duration, sweep, service, pool,\nlock, pingpong, tlb, syscall, iowait, jitter and c2c (set by phases)!\n\n");
+			free_buffers();
+			return -EINVAL;
+		}
+		if (coord_addr != NULL) {
+			ret = coord_agent_connect(coord_addr, &coord_buf,
+				&coord_len);
+			if (ret == 0) {
+				ret = scenario_load_buf(coord_addr, coord_buf,
+					coord_len, cpu_count, coord_hooks);
+				free(coord_buf);
+			}
+		} else {
+			/* Coordinator validates phases for any agent */
+			ret = scenario_load(scenario_file, (coord_bind != NULL) ?
+				CPU_SETSIZE : cpu_count);
+		}
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+
+	if (coord_bind != NULL) {
+		ret = coord_serve(coord_bind, coord_agents, scenario_file,
+			&halt);
+		free_buffers();
+		printf("\ndone.\n\n");
+		return ret;
+	}
+
+	if (sweep_step != -1) {
+		if (duration != -1) {
+			fprintf(stderr,
+				"cpuloadgen: sweep and duration are mutually exclusive!\n\n");
+			free_buffers();
+			return -EINVAL;
+		}
+		/* Sweep all online CPU cores if none selected */
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				break;
+		}
+		if (i == cpu_count) {
+			for (i = 0; i < cpu_count; i++)
+				cpuloads[i] = hotplug_cpu_available(i) ?
+					100 : -1;
+		}
+	} else if ((sweep_csv != NULL) && (scenario_file == NULL)) {
+		fprintf(stderr, "cpuloadgen: csv requires sweep or scenario!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+
+	if (energy_set) {
+		if (sweep_step == -1) {
+			fprintf(stderr, "cpuloadgen: energy requires sweep!\n\n");
+			free_buffers();
+			return -EINVAL;
+		}
+		/* Fail before loading anything if there is nothing to measure */
+		ret = energy_open();
+		if (ret == -EACCES) {
+			fprintf(stderr,
+				"cpuloadgen: RAPL (powercap) energy counters are not readable, run as root!\n\n");
+			free_buffers();
+			return ret;
+		} else if (ret != 0) {
+			fprintf(stderr,
+				"cpuloadgen: energy requires RAPL (powercap) energy counters, none found!\n\n");
+			free_buffers();
+			return ret;
+		}
+		sweep_dwell = energy_settle + energy_window * energy_windows +
+			ENERGY_TAIL;
+	}
+
+	if ((idle != IDLE_SLEEP) && (wakeup_max != -1)) {
+		fprintf(stderr,
+			"cpuloadgen: wakeup requires idle=sleep!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	idle = idle_mode_check(idle);
+
+	if ((service_us <= 0.0) &&
+		((request_rate > 0.0) || (trace_file != NULL))) {
+		fprintf(stderr, "cpuloadgen: rate and trace require service!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((service_us > 0.0) && ((policy == SCHED_DEADLINE) ||
+		(cgroup_parent != NULL) || (wakeup_max != -1) ||
+		(jitter.type != DIST_CONSTANT))) {
+		fprintf(stderr,
+			"cpuloadgen: service is not compatible with policy=deadline, cgroup, wakeup and jitter!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((pool_imbalance != 0) && (pool_task_us <= 0.0)) {
+		fprintf(stderr, "cpuloadgen: imbalance requires pool!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((pool_task_us > 0.0) && ((service_us > 0.0) ||
+		(policy == SCHED_DEADLINE) || (cgroup_parent != NULL) ||
+		(wakeup_max != -1) || (jitter.type != DIST_CONSTANT))) {
+		fprintf(stderr,
+			"cpuloadgen: pool is not compatible with service, policy=deadline, cgroup, wakeup and jitter!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((!lock_set) && ((cs_us >= 0.0) || (ncs_us >= 0.0))) {
+		fprintf(stderr, "cpuloadgen: cs and ncs require lock!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((lock_set) && ((service_us > 0.0) || (pool_task_us > 0.0) ||
+		(wakeup_max != -1) || (jitter.type != DIST_CONSTANT))) {
+		fprintf(stderr,
+			"cpuloadgen: lock is not compatible with service, pool, wakeup and jitter!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((coherence_set) && ((service_us > 0.0) || (pool_task_us > 0.0) ||
+		(lock_set) || (wakeup_max != -1) ||
+		(jitter.type != DIST_CONSTANT))) {
+		fprintf(stderr,
+			"cpuloadgen: pingpong is not compatible with service, pool, lock, wakeup and jitter!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((tlb_set) && ((service_us > 0.0) || (pool_task_us > 0.0) ||
+		(lock_set) || (coherence_set) || (wakeup_max != -1) ||
+		(jitter.type != DIST_CONSTANT))) {
+		fprintf(stderr,
+			"cpuloadgen: tlb is not compatible with service, pool, lock, pingpong, wakeup and jitter!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if (((syscall_pct > 0) || (iowait_pct > 0)) && ((service_us > 0.0) ||
+		(pool_task_us > 0.0) || (lock_set) || (coherence_set) ||
+		(tlb_set) || (policy == SCHED_DEADLINE) ||
+		(cgroup_parent != NULL))) {
+		fprintf(stderr,
+			"cpuloadgen: syscall and iowait are not compatible with service, pool, lock, pingpong, tlb, deadline and cgroup!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+
+	if ((tui_set) && ((scenario_file != NULL) || (sweep_step != -1) ||
+		(service_us > 0.0) || (pool_task_us > 0.0) || (lock_set) ||
+		(coherence_set) || (tlb_set) || (policy == SCHED_DEADLINE) ||
+		(cgroup_parent != NULL) || (c2c_roundtrips != -1) ||
+		(chunkbench_s != -1) || (dhrybench_s != -1))) {
+		fprintf(stderr,
+			"cpuloadgen: tui is not compatible with scenario, sweep, service, pool, lock, pingpong,\ntlb, deadline, cgroup, c2c, chunkbench and dhrybench!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+
+	if (c2c_roundtrips != -1) {
+		/* Measure selected CPU cores (all online if none) */
+		n = 0;
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				cpuloads[n++] = i;
+		}
+		if (n == 0) {
+			for (i = 0; i < cpu_count; i++) {
+				if (hotplug_cpu_available(i))
+					cpuloads[n++] = i;
+			}
+		}
+		if (n < 2) {
+			fprintf(stderr,
+				"cpuloadgen: c2c requires at least 2 CPUs (selected or online)!\n\n");
+			free_buffers();
+			return -EINVAL;
+		}
+		ret = coherence_c2c(cpuloads, n, c2c_roundtrips);
+		free_buffers();
+		printf("\ndone.\n\n");
+		return ret;
+	}
+	if ((chunkbench_s != -1) || (dhrybench_s != -1)) {
+		/* Run on first selected CPU core (CPU0 if none) */
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				break;
+		}
+		if (chunkbench_s != -1)
+			ret = chunk_bench((i < cpu_count) ? i : 0,
+				(unsigned int) chunkbench_s);
+		else
+			ret = dhry_bench((i < cpu_count) ? i : 0,
+				(unsigned int) dhrybench_s);
+		free_buffers();
+		printf("\ndone.\n\n");
+		return ret;
+	}
+	if (lock_set) {
+		if (cs_us < 0.0)
+			cs_us = DEFAULT_CS_US;
+		if (ncs_us < 0.0)
+			ncs_us = 0.0;
+	}
+	if ((request_rate > 0.0) && (trace_file != NULL)) {
+		fprintf(stderr,
+			"cpuloadgen: rate and trace are mutually exclusive!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if (trace_file != NULL) {
+		ret = request_trace_load(trace_file);
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+
+	if ((jitter.type != DIST_CONSTANT) || (wakeup_max != -1) ||
+		(service_us > 0.0) || (pool_task_us > 0.0) || (tlb_set) ||
+		(scenario_file != NULL)) {
+		if (!seed_set)
+			seed = (unsigned long long) time(NULL) ^
+				((unsigned long long) getpid() << 32);
+		printf("Random seed: %llu\n", seed);
+	}
+
+	if (results_file != NULL) {
+		ret = results_open(results_file, CPULOADGEN_REVISION, builddate,
+			cpu_count, argc, argv);
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+		results_config();
+	}
+
+	/*
+	 * Tui and energy read live counters, even without OpenMetrics
+	 * endpoint
+	 */
+	if ((metrics_addr != NULL) || (tui_set) || (energy_set)) {
+		ret = metrics_start(metrics_addr, cpu_count * threads_per_cpu);
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+
+	/* C-state residency is retrieved from sampled cpuidle statistics */
+	if (((samples_file != NULL) || (idle_set) || (dma_latency != -1)) &&
+		(sample_interval == -1))
+		sample_interval = DEFAULT_SAMPLE_INTERVAL_MS;
+	/* Scenario sample=on|off phases drive the sampler */
+	if ((scenario_file != NULL) && (sample_interval == -1)) {
+		for (i = 0; i < (int) scenario_len(); i++)
+			if (scenario_get(i)->sample != -1)
+				sample_interval = DEFAULT_SAMPLE_INTERVAL_MS;
+	}
+
+	if ((probe_prio != 0) && (probe_interval == -1)) {
+		fprintf(stderr,
+			"cpuloadgen: probeprio requires probe!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+
+	/* Check scheduling options consistency */
+	if ((priority != -1) &&
+		(policy != SCHED_FIFO) && (policy != SCHED_RR)) {
+		fprintf(stderr,
+			"cpuloadgen: prio requires policy=fifo or policy=rr!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((nice_level != NICE_UNSET) && (policy != -1) &&
+		(policy != SCHED_OTHER) && (policy != SCHED_BATCH)) {
+		fprintf(stderr,
+			"cpuloadgen: nice requires policy=other or policy=batch!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	if ((cgroup_parent != NULL) && (policy == SCHED_DEADLINE)) {
+		fprintf(stderr,
+			"cpuloadgen: cgroup and policy=deadline are mutually exclusive!\n\n");
+		free_buffers();
+		return -EINVAL;
+	}
+	/* All PWM loads and kernel-throttled modes are period-based */
+	if (period == -1)
+		period = DEFAULT_PERIOD_US;
+
+	threads = malloc(cpu_count * threads_per_cpu * sizeof(pthread_t));
+	thread_stats = calloc(cpu_count * threads_per_cpu, sizeof(worker_stats));
+	engine_threads = malloc(cpu_count * threads_per_cpu *
+		sizeof(unsigned int));
+	if ((threads == NULL) || (thread_stats == NULL) ||
+		(engine_threads == NULL)) {
+		fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+		free_buffers();
+		return -ENOMEM;
+	}
+
+	if (pool_task_us > 0.0) {
+		/* Cache line aligned, so that deques do not share lines */
+		ret = posix_memalign((void **) &pool_deques, WSDEQUE_CACHE_LINE,
+			cpu_count * threads_per_cpu * sizeof(wsdeque));
+		if (ret != 0) {
+			pool_deques = NULL;
+			fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+			free_buffers();
+			return -ret;
+		}
+		memset(pool_deques, 0,
+			cpu_count * threads_per_cpu * sizeof(wsdeque));
+		for (i = 0; i < cpu_count * threads_per_cpu; i++) {
+			ret = wsdeque_init(&pool_deques[i], POOL_DEQUE_SIZE);
+			if (ret != 0) {
+				fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+				free_buffers();
+				return ret;
+			}
+		}
+	}
+
+	if (lock_set) {
+		ret = lock_init(lock_kind);
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+	if (coherence_set) {
+		ret = coherence_init(coherence, cpu_count * threads_per_cpu);
+		if (ret != 0) {
+			fprintf(stderr, "cpuloadgen: could not allocate buffers!!!\n");
+			free_buffers();
+			return ret;
+		}
+	}
+	if (tlb_set) {
+		n = 0;
+		for (i = 0; i < cpu_count; i++) {
+			if (cpuloads[i] != -1)
+				n++;
+		}
+		ret = tlb_check(tlb_backing, tlb_footprint,
+			n * threads_per_cpu);
+		if (ret != 0) {
+			if (lock_set)
+				lock_deinit();
+			free_buffers();
+			return ret;
+		}
+	}
+	if (iowait_pct > 0) {
+		ret = sysload_io_init(iowait_file);
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+	if (scenario_file != NULL) {
+		ret = scenario_prepare();
+		if (ret != 0) {
+			free_buffers();
+			return ret;
+		}
+	}
+
+	/* Load threads of unavailable CPU cores park until they are back */
+	ret = hotplug_start(&halt);
+	if (ret != 0) {
+		if (lock_set)
+			lock_deinit();
+		free_buffers();
+		return ret;
+	}
+	for (i = 0; i < cpu_count; i++) {
+		if ((cpuloads[i] != -1) && (!hotplug_cpu_available(i)))
+			printf("CPU%d is offline or out of cpuset, its load threads are parked until it is back.\n",
+				i);
+	}
+
+	if (cgroup_parent != NULL) {
+		ret = cgroup_init(cgroup_parent, cpu_count);
+		if (ret != 0) {
+			if (lock_set)
+				lock_deinit();
+			free_buffers();
+			return ret;
+		}
+	}
+
+	if (sample_interval != -1) {
+		ret = sampler_start(cpu_count, sample_interval, samples_file);
+		if (ret != 0) {
+			if (cgroup_parent != NULL)
+				cgroup_deinit();
+			if (lock_set)
+				lock_deinit();
+			free_buffers();
+			return ret;
+		}
+	}
+
+	if (dma_latency != -1) {
+		ret = idle_dma_latency_hold(dma_latency);
+		if (ret != 0) {
+			if (sample_interval != -1)
+				sampler_stop();
+			if (cgroup_parent != NULL)
+				cgroup_deinit();
+			if (lock_set)
+				lock_deinit();
+			free_buffers();
+			return ret;
+		}
+	}
+
+	printf("Press CTRL+C to stop load generation at any time.\n\n");
+
+	ret = 0;
+	if (coord_addr != NULL) {
+		ret = coord_agent_start(&scenario_start, coord_stop);
+		if (ret != 0)
+			fprintf(stderr,
+				"cpuloadgen: could not synchronise with coordinator (%d)!\n",
+				ret);
+		scenario_start_set = (ret == 0);
+	}
+	if ((ret == 0) && (tui_set))
+		ret = tui_start(cpu_count, threads_per_cpu, cpuloads,
+			coord_stop);
+
+	if (ret != 0)
+		;
+	else if (scenario_file != NULL)
+		ret = loadgen_scenario();
+	else if (sweep_step != -1)
+		ret = loadgen_sweep();
+	else
+		ret = loadgen_run(-1, NULL);
+
+	if (dma_latency != -1)
+		idle_dma_latency_release();
+
+	if (sample_interval != -1)
+		sampler_stop();
+
+	if (cgroup_parent != NULL)
+		cgroup_deinit();
+
+	if (lock_set)
+		lock_deinit();
+
+	free_buffers();
+
+	printf("\ndone.\n\n");
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		timespec_add_us
+ * @BRIEF		add a number of microseconds to a timespec.
+ * @param[in, out]	ts: timespec to be updated
+ * @param[in]		us: number of microseconds to add
+ * @DESCRIPTION		add a number of microseconds to a timespec.
+ *//*------------------------------------------------------------------------ */
+static void timespec_add_us(struct timespec *ts, double us)
+{
+	long long ns;
+
+	ns = ts->tv_nsec + (long long) (us * 1000.0);
+	ts->tv_sec += ns / 1000000000LL;
+	ts->tv_nsec = ns % 1000000000LL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		timespec_diff_us
+ * @BRIEF		compute difference between two timespecs.
+ * @RETURNS		(a - b), in microseconds
+ * @param[in]		a: first timespec
+ * @param[in]		b: second timespec
+ * @DESCRIPTION		compute difference between two timespecs.
+ *//*------------------------------------------------------------------------ */
+static double timespec_diff_us(const struct timespec *a,
+	const struct timespec *b)
+{
+	return ((double) (a->tv_sec - b->tv_sec)) * 1.0e6 +
+		((double) (a->tv_nsec - b->tv_nsec)) * 1.0e-3;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_setup
+ * @BRIEF		place and schedule calling load thread.
+ * @RETURNS		1 if the kernel throttles the load thread, 0 otherwise
+ * @param[in]		cpu: target CPU core ID (loaded CPU core)
+ * @param[in]		load: load to generate on that CPU ([1-100])
+ * @DESCRIPTION		place calling load thread on its CPU core, apply
+ *			scheduling policy and attach it to its cgroup.
+ *			With SCHED_DEADLINE or cgroup cpu.max, the kernel
+ *			throttles the thread according to its runtime (quota)
+ *			and period.
+ *//*------------------------------------------------------------------------ */
+static int loadgen_setup(unsigned int cpu, unsigned int load)
+{
+	int throttled;
+
+	/* Pinned (unless migrate), parked while CPU core is not available */
+	hotplug_worker_init(&thread_hotplug, cpu, !migrate, thread_metrics);
+	if (sched_setup(cpu, load) != 0) {
+		throttled = 0;
+		metrics_error(thread_metrics);
+	} else {
+		throttled = (policy == SCHED_DEADLINE);
+	}
+	/* SCHED_DEADLINE task affinity is up to admission control */
+	if (policy == SCHED_DEADLINE)
+		thread_hotplug.pin = thread_hotplug.pinned = 0;
+	if (cgroup_parent != NULL) {
+		if (cgroup_worker_attach(cpu) == 0)
+			throttled = 1;
+		else
+			metrics_error(thread_metrics);
+	}
+	printf("Generating %3d%% load on CPU%d...\n", load, cpu);
+
+	return throttled;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen
+ * @BRIEF		Programmable CPU load generator
+ * @RETURNS		number of Dhrystone iterations performed
+ * @param[in]		cpu: target CPU core ID (loaded CPU core)
+ * @param[in]		load: load to generate on that CPU ([1-100])
+ * @param[in]		duration: how long this CPU core shall be loaded
+ *				(in seconds)
+ * @DESCRIPTION		Programmable CPU load generator, for loads the load
+ *			engine does not run (see engine_eligible()): requests,
+ *			pool and kernels, or Dhrystone loops with PWM (Pulse
+ *			Width Modulation) extended with jitter, system calls,
+ *			I/O wait, random wakeups or spinning idle modes.
+ *//*------------------------------------------------------------------------ */
+unsigned long long loadgen(unsigned int cpu, unsigned int load,
+	unsigned int duration)
+{
+	unsigned long long iterations = 0;
+	double idle_time_us, active_time_us, busy_time_us;
+	double time_us;
+	struct timespec ts_start, ts_period, ts_busy_end, ts_now, ts_chunk;
+	double sys_us = 0.0, user_us = 0.0;
+	worker_stats *st = &thread_stats[thread_idx];
+	int throttled;
+	chunk_sizer chunk;
+	uint64_t start_ns, now_ns;
+	unsigned int n;
+
+	throttled = loadgen_setup(cpu, load);
+	if (service_us > 0.0) {
+		iterations = loadgen_requests(cpu, load, duration);
+	} else if (pool_task_us > 0.0) {
+		iterations = loadgen_pool(cpu, load, duration);
+	} else if (lock_set) {
+		iterations = loadgen_kernel(cpu, load, duration, throttled,
+			lock_batch, 1);
+	} else if (coherence_set) {
+		iterations = loadgen_kernel(cpu, load, duration, throttled,
+			coherence_batch, 0);
+	} else if (tlb_set) {
+		/* Buffer first touched by its thread, on its CPU core */
+		if (tlb_thread_init(tlb_footprint, tlb_backing,
+			&thread_rng) != 0) {
+			metrics_error(thread_metrics);
+			return 0;
+		}
+		iterations = loadgen_kernel(cpu, load, duration, throttled,
+			tlb_batch, 0);
+		tlb_thread_deinit();
+	} else if (((load != 100) || (syscall_pct > 0) ||
+		(scenario_file != NULL) || (tui_set)) && (!throttled)) {
+		/*
+		 * Period-based PWM: busy-loop in short Dhrystone chunks for
+		 * the active share of the period, then sleep until the
+		 * absolute start of the next period so that timing errors do
+		 * not accumulate. With jitter, busy and idle times of each
+		 * period are drawn independently, keeping the mean load.
+		 * With syscall, system call batches replace Dhrystone chunks
+		 * whenever system time falls behind its share of busy time.
+		 * With iowait, idle time starts with blocking reads.
+		 * With tui, load is read again at each period start.
+		 */
+		if (((syscall_pct > 0) || (iowait_pct > 0)) &&
+			(sysload_thread_init(syscall_mix, iowait_pct > 0) != 0)) {
+			metrics_error(thread_metrics);
+			return 0;
+		}
+		active_time_us = ((double) period * (double) load) / 100.0;
+		clock_gettime(CLOCK_MONOTONIC, &ts_start);
+		ts_period = ts_start;
+		ts_now = ts_start;
+		while (1) {
+			if (hotplug_check(&thread_hotplug)) {
+				clock_gettime(CLOCK_MONOTONIC, &ts_period);
+				ts_now = ts_period;
+			}
+			if (tui_set) {
+				load = __atomic_load_n(&cpuloads[cpu],
+					__ATOMIC_RELAXED);
+				metrics_setpoint(thread_metrics, load);
+				active_time_us = ((double) period *
+					(double) load) / 100.0;
+			}
+			busy_time_us = dist_sample(&jitter, &thread_rng,
+				active_time_us);
+			idle_time_us = dist_sample(&jitter, &thread_rng,
+				(double) period - active_time_us);
+			ts_busy_end = ts_period;
+			timespec_add_us(&ts_busy_end, busy_time_us);
+			do {
+				ts_chunk = ts_now;
+				if ((syscall_pct > 0) && (sys_us * 100.0 <=
+					(sys_us + user_us) * (double) syscall_pct)) {
+					st->syscalls += sysload_call(syscall_mix,
+						KERNEL_BATCH);
+					clock_gettime(CLOCK_MONOTONIC, &ts_now);
+					sys_us += timespec_diff_us(&ts_now,
+						&ts_chunk);
+					continue;
+				}
+				dhryStone(PWM_CHUNK_ITERATIONS);
+				iterations += PWM_CHUNK_ITERATIONS;
+				metrics_iterations(thread_metrics,
+					PWM_CHUNK_ITERATIONS);
+				clock_gettime(CLOCK_MONOTONIC, &ts_now);
+				user_us += timespec_diff_us(&ts_now, &ts_chunk);
+			} while ((!halt) &&
+				(timespec_diff_us(&ts_busy_end, &ts_now) > 0.0));
+			if (halt)
+				break;
+
+			timespec_add_us(&ts_period, busy_time_us + idle_time_us);
+			if (iowait_pct > 0) {
+				ts_chunk = ts_now;
+				timespec_add_us(&ts_chunk, idle_time_us *
+					(double) iowait_pct / 100.0);
+				st->io_reads += sysload_io_until(&ts_chunk,
+					&thread_rng);
+			}
+			if (wakeup_max != -1) {
+				/* Split idle time into short random sleeps */
+				while (1) {
+					clock_gettime(CLOCK_MONOTONIC, &ts_now);
+					idle_time_us = timespec_diff_us(
+						&ts_period, &ts_now);
+					if (idle_time_us <= 0.0)
+						break;
+					time_us = (double) (1 + rng_next(
+						&thread_rng) % wakeup_max);
+					if (time_us > idle_time_us)
+						time_us = idle_time_us;
+					usleep((unsigned int) time_us);
+				}
+			} else {
+				idle_until(idle, &ts_period);
+			}
+			metrics_overshoot(thread_metrics, &ts_period);
+
+			clock_gettime(CLOCK_MONOTONIC, &ts_now);
+			time_us = timespec_diff_us(&ts_now, &ts_start) * 1.0e-6;
+			dprintf("%s(): CPU%d elapsed time: %fs\n",
+				__func__, cpu, time_us);
+			if ((halt) || ((duration != 0) && (time_us >= duration)))
+				break;
+		}
+		sysload_thread_deinit();
+	} else {
+		/*
+		 * 100% load, or SCHED_DEADLINE / cgroup cpu.max, in which case
+		 * the kernel throttles the thread according to its runtime
+		 * (quota) and period.
+		 * Chunks are sized to check time about every CHUNK_TARGET_US,
+		 * so that stop latency does not depend on core speed, while
+		 * timing calls stay negligible.
+		 */
+		chunk_init(&chunk, CHUNK_TARGET_US);
+		start_ns = chunk.last_ns;
+		while (1) {
+			n = chunk.size;
+			dhryStone(n);
+			iterations += n;
+			metrics_iterations(thread_metrics, n);
+			now_ns = chunk_update(&chunk);
+			if ((halt) || ((duration != 0) &&
+				(now_ns - start_ns >= duration * 1000000000ULL)))
+				break;
+			/* Parked time must not shrink chunks */
+			if (hotplug_check(&thread_hotplug))
+				chunk.last_ns = chunk_clock_ns();
+		}
+		dprintf("%s(): CPU%d final chunk: %u iterations\n", __func__,
+			cpu, chunk.size);
+	}
+
+	dprintf("Load Generation on CPU%d completed.\n", cpu);
+
+	return iterations;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhrystone_calibrate
+ * @BRIEF		measure Dhrystone loop rate of calling thread.
+ * @RETURNS		Dhrystone iterations per microsecond
+ * @DESCRIPTION		measure Dhrystone loop rate of calling thread, over
+ *			CALIBRATION_US of thread CPU time (so that preemption
+ *			does not bias it).
+ *//*------------------------------------------------------------------------ */
+static double dhrystone_calibrate(void)
+{
+	struct timespec ts_start, ts_now;
+	unsigned long long iterations = 0;
+	double elapsed_us;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_start);
+	do {
+		dhryStone(PWM_CHUNK_ITERATIONS);
+		iterations += PWM_CHUNK_ITERATIONS;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_now);
+		elapsed_us = timespec_diff_us(&ts_now, &ts_start);
+	} while (elapsed_us < CALIBRATION_US);
+
+	return (double) iterations / elapsed_us;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		chunk_bench
+ * @BRIEF		compare fixed chunks with load engine at 100% load.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core to run on
+ * @param[in]		duration: benchmark duration (in seconds)
+ * @DESCRIPTION		compare 100% load loops: fixed chunks of
+ *			FIXED_CHUNK_ITERATIONS Dhrystone loops followed by
+ *			gettimeofday() (legacy loop), and a load engine
+ *			worker at 100% load, as run by load threads (adaptive
+ *			chunks sized from period, period hook, sizer reset
+ *			every period).
+ *			Both loops alternate over CHUNKBENCH_ROUNDS rounds (in
+ *			swapped order every other round, cancelling frequency
+ *			drifts). Throughput is measured over thread CPU time,
+ *			so that preemption does not bias it. Throughput loss
+ *			of load engine, time check intervals of fixed chunks
+ *			and stop latency of load engine are reported.
+ *//*------------------------------------------------------------------------ */
+static int chunk_bench(int cpu, unsigned int duration)
+{
+	struct timespec ts_cpu_start, ts_cpu_end, ts_end, ts_stop;
+	struct timeval tv;
+	cpu_set_t set;
+	cpuloadgen_engine *e;
+	cpuloadgen_worker_config cfg;
+	cpuloadgen_stats stats;
+	uint64_t round_ns, start_ns, last_ns, now_ns, interval_ns;
+	uint64_t max_ns[2] = {0, 0}, checks[2] = {0, 0}, stop_ns = 0;
+	unsigned long long iterations[2] = {0, 0}, periods = 0, n;
+	double cpu_us[2] = {0.0, 0.0}, rate[2], tmp;
+	double round_rate[2], losses[CHUNKBENCH_ROUNDS];
+	unsigned int r, k, mode, i, j;
+	int ret;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		fprintf(stderr, "cpuloadgen: could not run on CPU%d (%s)!\n",
+			cpu, strerror(errno));
+		return -errno;
+	}
+	e = cpuloadgen_create();
+	if (e == NULL)
+		return -ENOMEM;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.cpu = cpu;
+	cfg.kernel = CPULOADGEN_KERNEL_DHRYSTONE;
+	cfg.load = 100;
+	cfg.period_us = (period != -1) ? period : DEFAULT_PERIOD_US;
+	ret = cpuloadgen_add_worker(e, &cfg);
+	if (ret < 0)
+		goto fail;
+	printf("Comparing fixed chunks (%u iterations) and load engine (%uus period) on CPU%d for %us...\n",
+		FIXED_CHUNK_ITERATIONS, cfg.period_us, cpu, duration);
+
+	/* Warm-up */
+	ret = cpuloadgen_start(e);
+	if (ret != 0)
+		goto fail;
+	usleep(100000);
+	ret = cpuloadgen_stop(e);
+	if (ret != 0)
+		goto fail;
+
+	round_ns = ((uint64_t) duration * 1000000000ULL) /
+		(2 * CHUNKBENCH_ROUNDS);
+	for (r = 0; (r < CHUNKBENCH_ROUNDS) && (!halt); r++) {
+		for (k = 0; k < 2; k++) {
+			mode = (r % 2) ? 1 - k : k;
+			n = 0;
+			if (mode == 0) {
+				/* Legacy loop checks time with gettimeofday() */
+				clock_gettime(CLOCK_THREAD_CPUTIME_ID,
+					&ts_cpu_start);
+				gettimeofday(&tv, NULL);
+				start_ns = (uint64_t) tv.tv_sec * 1000000000ULL +
+					(uint64_t) tv.tv_usec * 1000ULL;
+				last_ns = start_ns;
+				do {
+					dhryStone(FIXED_CHUNK_ITERATIONS);
+					n += FIXED_CHUNK_ITERATIONS;
+					gettimeofday(&tv, NULL);
+					now_ns = (uint64_t) tv.tv_sec *
+						1000000000ULL +
+						(uint64_t) tv.tv_usec * 1000ULL;
+					interval_ns = now_ns - last_ns;
+					last_ns = now_ns;
+					if (interval_ns > max_ns[mode])
+						max_ns[mode] = interval_ns;
+					checks[mode]++;
+				} while ((!halt) &&
+					(now_ns - start_ns < round_ns));
+				clock_gettime(CLOCK_THREAD_CPUTIME_ID,
+					&ts_cpu_end);
+				tmp = timespec_diff_us(&ts_cpu_end,
+					&ts_cpu_start);
+			} else {
+				/* Sleep while worker runs, then time its stop */
+				ret = cpuloadgen_start(e);
+				if (ret != 0)
+					goto fail;
+				clock_gettime(CLOCK_MONOTONIC, &ts_end);
+				timespec_add_us(&ts_end,
+					(double) round_ns * 1.0e-3);
+				while ((!halt) && (clock_nanosleep(
+					CLOCK_MONOTONIC, TIMER_ABSTIME,
+					&ts_end, NULL) == EINTR))
+					;
+				clock_gettime(CLOCK_MONOTONIC, &ts_stop);
+				ret = cpuloadgen_stop(e);
+				clock_gettime(CLOCK_MONOTONIC, &ts_end);
+				if (ret == 0)
+					ret = cpuloadgen_get_stats(e, 0, &stats);
+				if (ret != 0)
+					goto fail;
+				interval_ns = (uint64_t) (timespec_diff_us(
+					&ts_end, &ts_stop) * 1.0e3);
+				if (interval_ns > max_ns[mode])
+					max_ns[mode] = interval_ns;
+				stop_ns += interval_ns;
+				checks[mode]++;
+				n = stats.iterations;
+				periods += stats.periods;
+				tmp = stats.busy_s * 1.0e6;
+			}
+			iterations[mode] += n;
+			cpu_us[mode] += tmp;
+			round_rate[mode] = (tmp > 0.0) ? (double) n / tmp : 0.0;
+		}
+		losses[r] = (round_rate[0] > 0.0) ? 100.0 *
+			(round_rate[0] - round_rate[1]) / round_rate[0] : 0.0;
+	}
+	cpuloadgen_destroy(e);
+	if ((r < CHUNKBENCH_ROUNDS) || (cpu_us[0] <= 0.0) ||
+		(cpu_us[1] <= 0.0) || (checks[0] == 0) || (checks[1] == 0)) {
+		fprintf(stderr, "cpuloadgen: chunk benchmark interrupted!\n");
+		return -EINTR;
+	}
+
+	for (mode = 0; mode < 2; mode++)
+		rate[mode] = (double) iterations[mode] / cpu_us[mode];
+	/* Median of per-round losses, robust to other tasks' noise */
+	for (i = 1; i < CHUNKBENCH_ROUNDS; i++) {
+		tmp = losses[i];
+		for (j = i; (j > 0) && (losses[j - 1] > tmp); j--)
+			losses[j] = losses[j - 1];
+		losses[j] = tmp;
+	}
+	printf("\n%-10s %14s %12s\n", "Loop", "Iterations/us", "DMIPS");
+	for (mode = 0; mode < 2; mode++)
+		printf("%-10s %14.3f %12.1f\n",
+			(mode == 0) ? "fixed" : "engine", rate[mode],
+			rate[mode] * 1.0e6 / DHRYSTONE_VAX_MIPS);
+	printf("\nFixed chunks: time checked every %.1fus (max %.1fus)\n",
+		cpu_us[0] / (double) checks[0], (double) max_ns[0] / 1000.0);
+	printf("Load engine: stopped in %.1fus on average (max %.1fus), over %llu periods\n",
+		(double) stop_ns / (double) checks[1] / 1000.0,
+		(double) max_ns[1] / 1000.0, periods);
+	printf("Load engine throughput loss: %.3f%% (overall), %.3f%% (median of %d rounds)\n",
+		100.0 * (rate[0] - rate[1]) / rate[0],
+		(losses[CHUNKBENCH_ROUNDS / 2 - 1] +
+		losses[CHUNKBENCH_ROUNDS / 2]) / 2.0, CHUNKBENCH_ROUNDS);
+
+	return 0;
+
+fail:
+	fprintf(stderr, "cpuloadgen: could not run load engine (%s)!\n",
+		strerror(-ret));
+	cpuloadgen_destroy(e);
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhry_bench
+ * @BRIEF		compare Dhrystone variants.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core to run on
+ * @param[in]		duration: benchmark duration (in seconds)
+ * @DESCRIPTION		compare Dhrystone variants at 100% load, with
+ *			adaptive chunks. Variants alternate over
+ *			CHUNKBENCH_ROUNDS rounds (in rotated order every round,
+ *			cancelling frequency drifts). Throughput is measured
+ *			over thread CPU time, and reported along with DMIPS and
+ *			speedup versus faithful variant.
+ *//*------------------------------------------------------------------------ */
+static int dhry_bench(int cpu, unsigned int duration)
+{
+	struct timespec ts_cpu_start, ts_cpu_end;
+	cpu_set_t set;
+	chunk_sizer chunk[DHRY_VARIANTS_COUNT];
+	uint64_t round_ns, start_ns, now_ns;
+	unsigned long long iterations[DHRY_VARIANTS_COUNT], n;
+	double cpu_us[DHRY_VARIANTS_COUNT], rate;
+	unsigned int r, k, v, i;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		fprintf(stderr, "cpuloadgen: could not run on CPU%d (%s)!\n",
+			cpu, strerror(errno));
+		return -errno;
+	}
+	printf("Comparing Dhrystone variants on CPU%d for %us...\n", cpu,
+		duration);
+
+	/* Warm-up, also letting chunk sizes converge */
+	for (v = 0; v < DHRY_VARIANTS_COUNT; v++) {
+		iterations[v] = 0;
+		cpu_us[v] = 0.0;
+		dhry_variant_set((dhry_variant) v);
+		chunk_init(&chunk[v], CHUNK_TARGET_US);
+		start_ns = chunk[v].last_ns;
+		do {
+			dhryStone(chunk[v].size);
+			now_ns = chunk_update(&chunk[v]);
+		} while (now_ns - start_ns < 50000000ULL);
+	}
+
+	round_ns = ((uint64_t) duration * 1000000000ULL) /
+		(DHRY_VARIANTS_COUNT * CHUNKBENCH_ROUNDS);
+	for (r = 0; (r < CHUNKBENCH_ROUNDS) && (!halt); r++) {
+		for (k = 0; k < DHRY_VARIANTS_COUNT; k++) {
+			v = (r + k) % DHRY_VARIANTS_COUNT;
+			dhry_variant_set((dhry_variant) v);
+			n = 0;
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_cpu_start);
+			start_ns = chunk_clock_ns();
+			chunk[v].last_ns = start_ns;
+			do {
+				i = chunk[v].size;
+				dhryStone(i);
+				n += i;
+				now_ns = chunk_update(&chunk[v]);
+			} while ((!halt) && (now_ns - start_ns < round_ns));
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_cpu_end);
+			iterations[v] += n;
+			cpu_us[v] += timespec_diff_us(&ts_cpu_end,
+				&ts_cpu_start);
+		}
+	}
+	dhry_variant_set(dhrystone_variant);
+	dhryStone_release();
+	for (v = 0; v < DHRY_VARIANTS_COUNT; v++) {
+		if ((r < CHUNKBENCH_ROUNDS) || (cpu_us[v] <= 0.0)) {
+			fprintf(stderr,
+				"cpuloadgen: Dhrystone benchmark interrupted!\n");
+			return -EINTR;
+		}
+	}
+
+	printf("\n%-10s %14s %12s %10s\n", "Variant", "Iterations/us",
+		"DMIPS", "Speedup");
+	for (v = 0; v < DHRY_VARIANTS_COUNT; v++) {
+		rate = (double) iterations[v] / cpu_us[v];
+		printf("%-10s %14.3f %12.1f %9.2fx\n",
+			dhry_variant_name((dhry_variant) v), rate,
+			rate * 1.0e6 / DHRYSTONE_VAX_MIPS, rate * cpu_us[0] /
+			(double) iterations[0]);
+	}
+	printf("\nPower variant runs %u interleaved Dhrystone states.\n",
+		dhry_power_lanes);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_requests
+ * @BRIEF		open-loop request-driven CPU load generator.
+ * @RETURNS		number of Dhrystone iterations performed
+ * @param[in]		cpu: target CPU core ID (loaded CPU core)
+ * @param[in]		load: target utilisation of that CPU ([1-100]),
+ *				unless request rate is set
+ * @param[in]		duration: how long this CPU core shall be loaded
+ *				(in seconds)
+ * @DESCRIPTION		open-loop request-driven CPU load generator. Requests
+ *			arrive as a Poisson process (or replayed trace),
+ *			independently of their completion, and are served in
+ *			FIFO order, each running a calibrated number of
+ *			Dhrystone loops for a service time drawn from
+ *			service_dist. Response time (completion - arrival) and
+ *			queueing delay (service start - arrival) are recorded.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long loadgen_requests(unsigned int cpu,
+	unsigned int load, unsigned int duration)
+{
+	static const dist arrival_dist = { DIST_EXPONENTIAL, 0.0 };
+	unsigned long long iterations = 0, completed = 0, backlog = 0;
+	unsigned long long n;
+	struct timespec ts_start, ts_arrival, ts_now;
+	double ipus, interarrival_us, delay_us;
+	unsigned int trace_pos;
+	hist *response, *wait;
+
+	response = malloc(sizeof(hist));
+	wait = malloc(sizeof(hist));
+	if ((response == NULL) || (wait == NULL)) {
+		fprintf(stderr, "cpuloadgen: CPU%u: could not allocate request histograms!\n",
+			cpu);
+		free(response);
+		free(wait);
+		return 0;
+	}
+	hist_init(response);
+	hist_init(wait);
+
+	ipus = dhrystone_calibrate();
+	if (request_rate > 0.0)
+		interarrival_us = 1.0e6 / request_rate;
+	else
+		interarrival_us = service_us * 100.0 / (double) load;
+	trace_pos = (request_trace_len() != 0) ?
+		(unsigned int) (rng_next(&thread_rng) % request_trace_len()) : 0;
+	dprintf("%s(): CPU%u %.1f iterations/us, mean inter-arrival %.1fus\n",
+		__func__, cpu, ipus, interarrival_us);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	ts_arrival = ts_start;
+	while (1) {
+		/* Requests do not queue up while parked */
+		if (hotplug_check(&thread_hotplug))
+			clock_gettime(CLOCK_MONOTONIC, &ts_arrival);
+		if (request_trace_len() != 0)
+			timespec_add_us(&ts_arrival,
+				request_trace_get(trace_pos++));
+		else
+			timespec_add_us(&ts_arrival, dist_sample(&arrival_dist,
+				&thread_rng, interarrival_us));
+
+		/* Wait for next arrival, unless it is already queued */
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		if (timespec_diff_us(&ts_arrival, &ts_now) > 0.0) {
+			if ((duration != 0) && (timespec_diff_us(&ts_arrival,
+				&ts_start) >= duration * 1.0e6))
+				break;
+			idle_until(idle, &ts_arrival);
+			metrics_overshoot(thread_metrics, &ts_arrival);
+			clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		}
+		delay_us = timespec_diff_us(&ts_now, &ts_arrival);
+		hist_record(wait, (delay_us > 0.0) ?
+			(unsigned long long) (delay_us * 1000.0) : 0);
+
+		n = (unsigned long long) (dist_sample(&service_dist,
+			&thread_rng, service_us) * ipus + 0.5);
+		if (n == 0)
+			n = 1;
+		dhryStone((unsigned int) n);
+		iterations += n;
+		metrics_iterations(thread_metrics, n);
+		completed++;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		delay_us = timespec_diff_us(&ts_now, &ts_arrival);
+		hist_record(response, (delay_us > 0.0) ?
+			(unsigned long long) (delay_us * 1000.0) : 0);
+		if ((halt) || ((duration != 0) && (timespec_diff_us(&ts_now,
+			&ts_start) >= duration * 1.0e6)))
+			break;
+	}
+
+	/* Count requests arrived but not served (overload) */
+	while ((!halt) && (timespec_diff_us(&ts_now, &ts_arrival) > 0.0)) {
+		backlog++;
+		if (request_trace_len() != 0)
+			timespec_add_us(&ts_arrival,
+				request_trace_get(trace_pos++));
+		else
+			timespec_add_us(&ts_arrival, dist_sample(&arrival_dist,
+				&thread_rng, interarrival_us));
+	}
+
+	request_record(cpu, response, wait, completed, backlog);
+	free(response);
+	free(wait);
+
+	return iterations;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		pool_steal
+ * @BRIEF		steal a task from another load thread.
+ * @RETURNS		0 on success
+ *			-EAGAIN if no task could be stolen
+ * @param[out]		task: stolen task (Dhrystone iterations)
+ * @DESCRIPTION		steal a task from another load thread, trying all
+ *			of them once, starting from a random one.
+ *//*------------------------------------------------------------------------ */
+static int pool_steal(unsigned int *task)
+{
+	unsigned int workers, victim, i;
+
+	workers = cpu_count * threads_per_cpu;
+	victim = (unsigned int) (rng_next(&thread_rng) % workers);
+	for (i = 0; i < workers; i++, victim = (victim + 1) % workers) {
+		if ((victim == thread_idx) ||
+			(cpuloads[victim / threads_per_cpu] == -1))
+			continue;
+		if (wsdeque_steal(&pool_deques[victim], task) == 0)
+			return 0;
+	}
+
+	return -EAGAIN;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_pool
+ * @BRIEF		work-stealing thread pool CPU load generator.
+ * @RETURNS		number of Dhrystone iterations performed
+ * @param[in]		cpu: target CPU core ID (loaded CPU core)
+ * @param[in]		load: load to generate on that CPU ([1-100])
+ * @param[in]		duration: how long this CPU core shall be loaded
+ *				(in seconds)
+ * @DESCRIPTION		work-stealing thread pool CPU load generator. At the
+ *			start of each period, push the tasks produced by this
+ *			thread into its deque, then run tasks from its deque,
+ *			or stolen from other threads, until the end of the
+ *			period. With imbalance, the first load thread produces
+ *			this share of every thread's tasks.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long loadgen_pool(unsigned int cpu, unsigned int load,
+	unsigned int duration)
+{
+	worker_stats *st = &thread_stats[thread_idx];
+	wsdeque *q = &pool_deques[thread_idx];
+	unsigned long long iterations = 0;
+	struct timespec ts_start, ts_period, ts_now, ts_backoff;
+	double ipus, own, total, produce, credit = 0.0;
+	unsigned int task, first, i;
+	long depth;
+
+	ipus = dhrystone_calibrate();
+	task = (unsigned int) (pool_task_us * ipus + 0.5);
+	if (task == 0)
+		task = 1;
+
+	/* Tasks produced per period */
+	own = (double) period * (double) load / 100.0 / pool_task_us;
+	total = 0.0;
+	first = cpu_count * threads_per_cpu;
+	for (i = 0; i < (unsigned int) (cpu_count * threads_per_cpu); i++) {
+		if (cpuloads[i / threads_per_cpu] == -1)
+			continue;
+		if (first > i)
+			first = i;
+		total += (double) period *
+			(double) cpuloads[i / threads_per_cpu] / 100.0 /
+			pool_task_us;
+	}
+	produce = own * (1.0 - (double) pool_imbalance / 100.0);
+	if (thread_idx == first)
+		produce += total * (double) pool_imbalance / 100.0;
+	dprintf("%s(): CPU%u %u iterations/task, %.1f tasks/period\n",
+		__func__, cpu, task, produce);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	ts_period = ts_start;
+	while (1) {
+		if (hotplug_check(&thread_hotplug))
+			clock_gettime(CLOCK_MONOTONIC, &ts_period);
+		depth = wsdeque_depth(q);
+		st->depth_sum += depth;
+		st->depth_samples++;
+		if ((unsigned long long) depth > st->depth_max)
+			st->depth_max = depth;
+
+		credit += produce;
+		for (; credit >= 1.0; credit -= 1.0) {
+			st->tasks_produced++;
+			if (wsdeque_push(q, task) != 0) {
+				/* Deque full: run task inline */
+				dhryStone(task);
+				iterations += task;
+				metrics_iterations(thread_metrics, task);
+				st->tasks_run++;
+			}
+		}
+
+		timespec_add_us(&ts_period, (double) period);
+		while (!halt) {
+			clock_gettime(CLOCK_MONOTONIC, &ts_now);
+			if (timespec_diff_us(&ts_period, &ts_now) <= 0.0)
+				break;
+			if (wsdeque_take(q, &task) == 0) {
+				st->tasks_run++;
+			} else if (pool_steal(&task) == 0) {
+				st->tasks_run++;
+				st->tasks_stolen++;
+			} else {
+				/* No work anywhere: back off, then retry */
+				ts_backoff = ts_now;
+				timespec_add_us(&ts_backoff, POOL_BACKOFF_US);
+				if (timespec_diff_us(&ts_period, &ts_backoff) < 0.0)
+					ts_backoff = ts_period;
+				idle_until(idle, &ts_backoff);
+				continue;
+			}
+			dhryStone(task);
+			iterations += task;
+			metrics_iterations(thread_metrics, task);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		if ((halt) || ((duration != 0) && (timespec_diff_us(&ts_now,
+			&ts_start) >= duration * 1.0e6)))
+			break;
+	}
+
+	return iterations;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_batch
+ * @BRIEF		lock contention kernel.
+ * @RETURNS		number of Dhrystone iterations performed
+ * @param[in, out]	st: load thread statistics
+ * @param[in]		ipus: Dhrystone iterations per microsecond
+ * @DESCRIPTION		lock contention kernel: acquire the shared lock, hold
+ *			it for cs_us, release it, then work ncs_us outside of
+ *			it, KERNEL_BATCH times.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long lock_batch(worker_stats *st, double ipus)
+{
+	unsigned int cs, ncs, i;
+	lock_node node;
+	int write;
+
+	cs = (unsigned int) (cs_us * ipus + 0.5);
+	ncs = (unsigned int) (ncs_us * ipus + 0.5);
+	for (i = 0; i < KERNEL_BATCH; i++) {
+		write = (lock_write_pct == 100) ||
+			((int) (rng_next(&thread_rng) % 100) < lock_write_pct);
+		lock_enter(&node, write);
+		if (cs != 0)
+			dhryStone(cs);
+		lock_exit(&node, write);
+		if (ncs != 0)
+			dhryStone(ncs);
+	}
+	st->kernel_ops += KERNEL_BATCH;
+
+	return KERNEL_BATCH * (unsigned long long) (cs + ncs);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		coherence_batch
+ * @BRIEF		cache line ping-pong kernel.
+ * @RETURNS		number of Dhrystone iterations performed (0)
+ * @param[in, out]	st: load thread statistics
+ * @param[in]		ipus: Dhrystone iterations per microsecond (unused)
+ * @DESCRIPTION		cache line ping-pong kernel: atomically increment
+ *			the counter of the load thread KERNEL_BATCH times.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long coherence_batch(worker_stats *st, double ipus)
+{
+	(void) ipus;
+	coherence_touch(thread_idx, KERNEL_BATCH);
+	st->kernel_ops += KERNEL_BATCH;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_batch
+ * @BRIEF		TLB pressure kernel.
+ * @RETURNS		number of Dhrystone iterations performed (0)
+ * @param[in, out]	st: load thread statistics
+ * @param[in]		ipus: Dhrystone iterations per microsecond (unused)
+ * @DESCRIPTION		TLB pressure kernel: follow the pointer chain of the
+ *			load thread buffer KERNEL_BATCH times.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long tlb_batch(worker_stats *st, double ipus)
+{
+	(void) ipus;
+	tlb_chase(KERNEL_BATCH);
+	st->kernel_ops += KERNEL_BATCH;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		loadgen_kernel
+ * @BRIEF		PWM CPU load generator running a given kernel.
+ * @RETURNS		number of Dhrystone iterations performed
+ * @param[in]		cpu: target CPU core ID (loaded CPU core)
+ * @param[in]		load: load to generate on that CPU ([1-100])
+ * @param[in]		duration: how long this CPU core shall be loaded
+ *				(in seconds)
+ * @param[in]		throttled: load is enforced by the kernel
+ * @param[in]		batch: kernel, running a short batch of operations
+ * @param[in]		calibrate: kernel needs Dhrystone loop rate
+ * @DESCRIPTION		PWM CPU load generator running a given kernel instead
+ *			of Dhrystone loops during active time of each period.
+ *			When throttled (deadline policy, cgroup), run the
+ *			kernel during the whole period, letting the kernel
+ *			preempt the thread (e.g. while holding a lock).
+ *//*------------------------------------------------------------------------ */
+static unsigned long long loadgen_kernel(unsigned int cpu, unsigned int load,
+	unsigned int duration, int throttled, kernel_batch batch,
+	int calibrate)
+{
+	worker_stats *st = &thread_stats[thread_idx];
+	unsigned long long iterations = 0, n;
+	struct timespec ts_start, ts_period, ts_busy_end, ts_now;
+	double ipus = 0.0, active_time_us;
+
+	if (calibrate)
+		ipus = dhrystone_calibrate();
+	if (throttled)
+		active_time_us = (double) period;
+	else
+		active_time_us = ((double) period * (double) load) / 100.0;
+	dprintf("%s(): CPU%u %.1f iterations/us\n", __func__, cpu, ipus);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	ts_period = ts_start;
+	while (1) {
+		if (hotplug_check(&thread_hotplug))
+			clock_gettime(CLOCK_MONOTONIC, &ts_period);
+		ts_busy_end = ts_period;
+		timespec_add_us(&ts_busy_end, active_time_us);
+		do {
+			n = batch(st, ipus);
+			iterations += n;
+			metrics_iterations(thread_metrics, n);
+			clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		} while ((!halt) &&
+			(timespec_diff_us(&ts_busy_end, &ts_now) > 0.0));
+		st->kernel_busy_ns += (unsigned long long)
+			(timespec_diff_us(&ts_now, &ts_period) * 1000.0);
+
+		timespec_add_us(&ts_period, (double) period);
+		if (active_time_us < (double) period) {
+			idle_until(idle, &ts_period);
+			metrics_overshoot(thread_metrics, &ts_period);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		if ((halt) || ((duration != 0) && (timespec_diff_us(&ts_now,
+			&ts_start) >= duration * 1.0e6)))
+			break;
+	}
+
+	return iterations;
+}
+
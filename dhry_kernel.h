@@ -0,0 +1,429 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			dhry_kernel.h
+ * @Description			Prototyped Dhrystone 2.1 kernel template
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * Dhrystone 2.1 (Reinhold P. Weicker, 1988) procedures, prototyped and
+ * operating on per-thread state instead of globals.
+ * This file is a template, included by one C file per variant, which
+ * defines before inclusion:
+ * - DHRY_PROC: storage and inlining attributes of procedures,
+ * - DHRY_LANES: number of independent Dhrystone states run interleaved,
+ * - DHRY_RUN, DHRY_RELEASE: names of the variant entry points.
+ * Statements and their order follow dhry_1.c and dhry_2.c, so that the
+ * work done per iteration is the same in all variants.
+ */
+
+
+#ifndef DHRY_PROC
+#error "DHRY_PROC must be defined before including dhry_kernel.h"
+#endif
+#ifndef DHRY_LANES
+#define DHRY_LANES	1
+#endif
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "dhry.h"
+
+
+typedef struct {
+	Rec_Pointer Ptr_Glob;
+	Rec_Pointer Next_Ptr_Glob;
+	int Int_Glob;
+	Boolean Bool_Glob;
+	char Ch_1_Glob;
+	char Ch_2_Glob;
+	Arr_1_Dim Arr_1_Glob;
+	Arr_2_Dim Arr_2_Glob;
+	Str_30 Str_1_Loc;
+	Rec_Type Glob;
+	Rec_Type Next_Glob;
+} dhry_state;
+
+
+/*
+ * A single state is held in thread-local globals, accessed as classic
+ * Dhrystone globals (shared library code excepted, where each
+ * thread-local access would be a function call). Otherwise, procedures
+ * are passed their state. DHRY_G() accesses a state field.
+ */
+#if (DHRY_LANES == 1) && (!defined(__PIC__) || defined(__PIE__))
+#define DHRY_TLS
+static __thread Rec_Pointer dhry_Ptr_Glob;
+static __thread Rec_Pointer dhry_Next_Ptr_Glob;
+static __thread int dhry_Int_Glob;
+static __thread Boolean dhry_Bool_Glob;
+static __thread char dhry_Ch_1_Glob;
+static __thread char dhry_Ch_2_Glob;
+static __thread Arr_1_Dim dhry_Arr_1_Glob;
+static __thread Arr_2_Dim dhry_Arr_2_Glob;
+static __thread Str_30 dhry_Str_1_Loc;
+static __thread Rec_Type dhry_Glob;
+static __thread Rec_Type dhry_Next_Glob;
+#define DHRY_G(field)		dhry_##field
+#define DHRY_STATE_VOID		void
+#define DHRY_STATE_PARAM
+#define DHRY_STATE_ONLY
+#define DHRY_STATE_ARG
+#else
+static __thread dhry_state *dhry_states = NULL;
+#define DHRY_G(field)		s->field
+#define DHRY_STATE_VOID		dhry_state *s
+#define DHRY_STATE_PARAM	dhry_state *s,
+#define DHRY_STATE_ONLY		s
+#define DHRY_STATE_ARG		s,
+#endif
+
+
+DHRY_PROC void Proc_7(One_Fifty Int_1_Par_Val, One_Fifty Int_2_Par_Val,
+	One_Fifty *Int_Par_Ref)
+{
+	One_Fifty Int_Loc;
+
+	Int_Loc = Int_1_Par_Val + 2;
+	*Int_Par_Ref = Int_2_Par_Val + Int_Loc;
+}
+
+
+DHRY_PROC Boolean Func_3(Enumeration Enum_Par_Val)
+{
+	Enumeration Enum_Loc;
+
+	Enum_Loc = Enum_Par_Val;
+	if (Enum_Loc == Ident_3)
+		return true;
+	else
+		return false;
+}
+
+
+DHRY_PROC void Proc_6(DHRY_STATE_PARAM Enumeration Enum_Val_Par,
+	Enumeration *Enum_Ref_Par)
+{
+	*Enum_Ref_Par = Enum_Val_Par;
+	if (!Func_3(Enum_Val_Par))
+		*Enum_Ref_Par = Ident_4;
+	switch (Enum_Val_Par) {
+	case Ident_1:
+		*Enum_Ref_Par = Ident_1;
+		break;
+	case Ident_2:
+		if (DHRY_G(Int_Glob) > 100)
+			*Enum_Ref_Par = Ident_1;
+		else
+			*Enum_Ref_Par = Ident_4;
+		break;
+	case Ident_3:
+		*Enum_Ref_Par = Ident_2;
+		break;
+	case Ident_4:
+		break;
+	case Ident_5:
+		*Enum_Ref_Par = Ident_3;
+		break;
+	}
+}
+
+
+DHRY_PROC void Proc_8(DHRY_STATE_PARAM Arr_1_Dim Arr_1_Par_Ref,
+	Arr_2_Dim Arr_2_Par_Ref, int Int_1_Par_Val, int Int_2_Par_Val)
+{
+	One_Fifty Int_Index;
+	One_Fifty Int_Loc;
+
+	Int_Loc = Int_1_Par_Val + 5;
+	Arr_1_Par_Ref[Int_Loc] = Int_2_Par_Val;
+	Arr_1_Par_Ref[Int_Loc + 1] = Arr_1_Par_Ref[Int_Loc];
+	Arr_1_Par_Ref[Int_Loc + 30] = Int_Loc;
+	for (Int_Index = Int_Loc; Int_Index <= Int_Loc + 1; ++Int_Index)
+		Arr_2_Par_Ref[Int_Loc][Int_Index] = Int_Loc;
+	Arr_2_Par_Ref[Int_Loc][Int_Loc - 1] += 1;
+	Arr_2_Par_Ref[Int_Loc + 20][Int_Loc] = Arr_1_Par_Ref[Int_Loc];
+	DHRY_G(Int_Glob) = 5;
+}
+
+
+DHRY_PROC Enumeration Func_1(DHRY_STATE_PARAM Capital_Letter Ch_1_Par_Val,
+	Capital_Letter Ch_2_Par_Val)
+{
+	Capital_Letter Ch_1_Loc;
+	Capital_Letter Ch_2_Loc;
+
+	Ch_1_Loc = Ch_1_Par_Val;
+	Ch_2_Loc = Ch_1_Loc;
+	if (Ch_2_Loc != Ch_2_Par_Val) {
+		return Ident_1;
+	} else {
+		DHRY_G(Ch_1_Glob) = Ch_1_Loc;
+		return Ident_2;
+	}
+}
+
+
+DHRY_PROC Boolean Func_2(DHRY_STATE_PARAM Str_30 Str_1_Par_Ref,
+	Str_30 Str_2_Par_Ref)
+{
+	One_Thirty Int_Loc;
+	Capital_Letter Ch_Loc = 'A';
+
+	Int_Loc = 2;
+	while (Int_Loc <= 2) {
+		if (Func_1(DHRY_STATE_ARG Str_1_Par_Ref[Int_Loc],
+			Str_2_Par_Ref[Int_Loc + 1]) == Ident_1) {
+			Ch_Loc = 'A';
+			Int_Loc += 1;
+		}
+	}
+	if ((Ch_Loc >= 'W') && (Ch_Loc < 'Z'))
+		Int_Loc = 7;
+	if (Ch_Loc == 'R') {
+		return true;
+	} else {
+		if (strcmp(Str_1_Par_Ref, Str_2_Par_Ref) > 0) {
+			Int_Loc += 7;
+			DHRY_G(Int_Glob) = Int_Loc;
+			return true;
+		} else {
+			return false;
+		}
+	}
+}
+
+
+DHRY_PROC void Proc_3(DHRY_STATE_PARAM Rec_Pointer *Ptr_Ref_Par)
+{
+	if (DHRY_G(Ptr_Glob) != Null)
+		*Ptr_Ref_Par = DHRY_G(Ptr_Glob)->Ptr_Comp;
+	Proc_7(10, DHRY_G(Int_Glob),
+		&DHRY_G(Ptr_Glob)->variant.var_1.Int_Comp);
+}
+
+
+DHRY_PROC void Proc_1(DHRY_STATE_PARAM Rec_Pointer Ptr_Val_Par)
+{
+	Rec_Pointer Next_Record = Ptr_Val_Par->Ptr_Comp;
+
+	structassign(*Ptr_Val_Par->Ptr_Comp, *DHRY_G(Ptr_Glob));
+	Ptr_Val_Par->variant.var_1.Int_Comp = 5;
+	Next_Record->variant.var_1.Int_Comp =
+		Ptr_Val_Par->variant.var_1.Int_Comp;
+	Next_Record->Ptr_Comp = Ptr_Val_Par->Ptr_Comp;
+	Proc_3(DHRY_STATE_ARG &Next_Record->Ptr_Comp);
+	if (Next_Record->Discr == Ident_1) {
+		Next_Record->variant.var_1.Int_Comp = 6;
+		Proc_6(DHRY_STATE_ARG Ptr_Val_Par->variant.var_1.Enum_Comp,
+			&Next_Record->variant.var_1.Enum_Comp);
+		Next_Record->Ptr_Comp = DHRY_G(Ptr_Glob)->Ptr_Comp;
+		Proc_7(Next_Record->variant.var_1.Int_Comp, 10,
+			&Next_Record->variant.var_1.Int_Comp);
+	} else {
+		structassign(*Ptr_Val_Par, *Ptr_Val_Par->Ptr_Comp);
+	}
+}
+
+
+DHRY_PROC void Proc_2(DHRY_STATE_PARAM One_Fifty *Int_Par_Ref)
+{
+	One_Fifty Int_Loc;
+	Enumeration Enum_Loc = Ident_2;
+
+	Int_Loc = *Int_Par_Ref + 10;
+	do {
+		if (DHRY_G(Ch_1_Glob) == 'A') {
+			Int_Loc -= 1;
+			*Int_Par_Ref = Int_Loc - DHRY_G(Int_Glob);
+			Enum_Loc = Ident_1;
+		}
+	} while (Enum_Loc != Ident_1);
+}
+
+
+DHRY_PROC void Proc_4(DHRY_STATE_VOID)
+{
+	Boolean Bool_Loc;
+
+	Bool_Loc = DHRY_G(Ch_1_Glob) == 'A';
+	DHRY_G(Bool_Glob) = Bool_Loc | DHRY_G(Bool_Glob);
+	DHRY_G(Ch_2_Glob) = 'B';
+}
+
+
+DHRY_PROC void Proc_5(DHRY_STATE_VOID)
+{
+	DHRY_G(Ch_1_Glob) = 'A';
+	DHRY_G(Bool_Glob) = false;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhry_iteration
+ * @BRIEF		run one Dhrystone iteration.
+ * @param[in, out]	s: Dhrystone state
+ * @param[in]		Run_Index: iteration index
+ * @DESCRIPTION		run one Dhrystone iteration (main loop body of
+ *			dhry_1.c). Always inlined into the run loop, so that
+ *			iterations of independent lanes may overlap.
+ *//*------------------------------------------------------------------------ */
+static inline __attribute__((always_inline)) void dhry_iteration(
+	dhry_state *s, int Run_Index)
+{
+	One_Fifty Int_1_Loc;
+	One_Fifty Int_2_Loc;
+	One_Fifty Int_3_Loc = 0;
+	char Ch_Index;
+	Enumeration Enum_Loc;
+	Str_30 Str_2_Loc;
+
+	Proc_5(DHRY_STATE_ONLY);
+	Proc_4(DHRY_STATE_ONLY);
+	/* Ch_1_Glob == 'A', Ch_2_Glob == 'B', Bool_Glob == true */
+	Int_1_Loc = 2;
+	Int_2_Loc = 3;
+	strcpy(Str_2_Loc, "DHRYSTONE PROGRAM, 2'ND STRING");
+	Enum_Loc = Ident_2;
+	DHRY_G(Bool_Glob) = !Func_2(DHRY_STATE_ARG DHRY_G(Str_1_Loc), Str_2_Loc);
+	/* Bool_Glob == 1 */
+	while (Int_1_Loc < Int_2_Loc) {
+		Int_3_Loc = 5 * Int_1_Loc - Int_2_Loc;
+		/* Int_3_Loc == 7 */
+		Proc_7(Int_1_Loc, Int_2_Loc, &Int_3_Loc);
+		/* Int_3_Loc == 7 */
+		Int_1_Loc += 1;
+	}
+	/* Int_1_Loc == 3, Int_2_Loc == 3, Int_3_Loc == 7 */
+	Proc_8(DHRY_STATE_ARG DHRY_G(Arr_1_Glob), DHRY_G(Arr_2_Glob), Int_1_Loc, Int_3_Loc);
+	/* Int_Glob == 5 */
+	Proc_1(DHRY_STATE_ARG DHRY_G(Ptr_Glob));
+	for (Ch_Index = 'A'; Ch_Index <= DHRY_G(Ch_2_Glob); ++Ch_Index) {
+		if (Enum_Loc == Func_1(DHRY_STATE_ARG Ch_Index, 'C')) {
+			/* not executed */
+			Proc_6(DHRY_STATE_ARG Ident_1, &Enum_Loc);
+			strcpy(Str_2_Loc, "DHRYSTONE PROGRAM, 3'RD STRING");
+			Int_2_Loc = Run_Index;
+			DHRY_G(Int_Glob) = Run_Index;
+		}
+	}
+	/* Int_1_Loc == 3, Int_2_Loc == 3, Int_3_Loc == 7 */
+	Int_2_Loc = Int_2_Loc * Int_1_Loc;
+	Int_1_Loc = Int_2_Loc / Int_3_Loc;
+	Int_2_Loc = 7 * (Int_2_Loc - Int_3_Loc) - Int_1_Loc;
+	/* Int_1_Loc == 1, Int_2_Loc == 13, Int_3_Loc == 7 */
+	Proc_2(DHRY_STATE_ARG &Int_1_Loc);
+	/* Int_1_Loc == 5 */
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		DHRY_RUN
+ * @BRIEF		run Dhrystone iterations.
+ * @param[in]		iterations: number of iterations
+ * @DESCRIPTION		run Dhrystone iterations on calling thread state,
+ *			allocated on first call. Iterations are spread over
+ *			DHRY_LANES independent states, run in lockstep.
+ *			State is (re)initialized at each call, as was done by
+ *			dhry_1.c before the main loop.
+ *//*------------------------------------------------------------------------ */
+void DHRY_RUN(unsigned int iterations)
+{
+	unsigned int l, runs, Run_Index;
+#ifdef DHRY_TLS
+	/* State fields are thread-local globals */
+	dhry_state *states = NULL;
+#else
+	dhry_state *s, *states;
+
+	if (dhry_states == NULL) {
+		dhry_states = calloc(DHRY_LANES, sizeof(dhry_state));
+		if (dhry_states == NULL)
+			return;
+	}
+	states = dhry_states;
+#endif
+
+	for (l = 0; l < DHRY_LANES; l++) {
+#ifndef DHRY_TLS
+		s = &states[l];
+#endif
+		DHRY_G(Ptr_Glob) = &DHRY_G(Glob);
+		DHRY_G(Next_Ptr_Glob) = &DHRY_G(Next_Glob);
+		DHRY_G(Ptr_Glob)->Ptr_Comp = DHRY_G(Next_Ptr_Glob);
+		DHRY_G(Ptr_Glob)->Discr = Ident_1;
+		DHRY_G(Ptr_Glob)->variant.var_1.Enum_Comp = Ident_3;
+		DHRY_G(Ptr_Glob)->variant.var_1.Int_Comp = 40;
+		strcpy(DHRY_G(Ptr_Glob)->variant.var_1.Str_Comp,
+			"DHRYSTONE PROGRAM, SOME STRING");
+		strcpy(DHRY_G(Str_1_Loc), "DHRYSTONE PROGRAM, 1'ST STRING");
+		DHRY_G(Arr_2_Glob)[8][7] = 10;
+	}
+
+#if DHRY_LANES == 1
+	runs = iterations;
+	for (Run_Index = 1; Run_Index <= runs; ++Run_Index)
+		dhry_iteration(states, Run_Index);
+#else
+	runs = iterations / DHRY_LANES;
+	for (Run_Index = 1; Run_Index <= runs; ++Run_Index) {
+		for (l = 0; l < DHRY_LANES; l++)
+			dhry_iteration(&states[l], Run_Index);
+	}
+	for (l = 0; l < iterations % DHRY_LANES; l++)
+		dhry_iteration(&states[l], runs + 1);
+#endif
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		DHRY_RELEASE
+ * @BRIEF		release calling thread state.
+ * @DESCRIPTION		release calling thread state, for threads not running
+ *			until process exit (e.g. load engine workers).
+ *//*------------------------------------------------------------------------ */
+void DHRY_RELEASE(void)
+{
+#ifndef DHRY_TLS
+	free(dhry_states);
+	dhry_states = NULL;
+#endif
+}
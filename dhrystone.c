@@ -0,0 +1,132 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			dhrystone.c
+ * @Description			Dhrystone kernel variants
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <string.h>
+#include <errno.h>
+#include "dhrystone.h"
+
+
+static const char *dhry_names[DHRY_VARIANTS_COUNT] = {
+	"faithful",
+	"power"
+};
+
+static __thread dhry_variant thread_variant = DHRY_FAITHFUL;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhry_variant_parse
+ * @BRIEF		convert Dhrystone variant name into variant.
+ * @RETURNS		Dhrystone variant
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: Dhrystone variant name
+ * @DESCRIPTION		convert Dhrystone variant name into variant.
+ *//*------------------------------------------------------------------------ */
+int dhry_variant_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < DHRY_VARIANTS_COUNT; i++) {
+		if (strcmp(name, dhry_names[i]) == 0)
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhry_variant_name
+ * @BRIEF		return Dhrystone variant name.
+ * @RETURNS		Dhrystone variant name
+ * @param[in]		variant: Dhrystone variant
+ * @DESCRIPTION		return Dhrystone variant name.
+ *//*------------------------------------------------------------------------ */
+const char *dhry_variant_name(dhry_variant variant)
+{
+	if ((variant < 0) || (variant >= DHRY_VARIANTS_COUNT))
+		return "unknown";
+	return dhry_names[variant];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhry_variant_set
+ * @BRIEF		select Dhrystone variant of calling thread.
+ * @param[in]		variant: Dhrystone variant
+ * @DESCRIPTION		select Dhrystone variant run by dhryStone() on
+ *			calling thread (faithful by default).
+ *//*------------------------------------------------------------------------ */
+void dhry_variant_set(dhry_variant variant)
+{
+	thread_variant = variant;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhryStone
+ * @BRIEF		run Dhrystone iterations.
+ * @param[in]		iterations: number of iterations
+ * @DESCRIPTION		run Dhrystone iterations with calling thread variant.
+ *//*------------------------------------------------------------------------ */
+void dhryStone(unsigned int iterations)
+{
+	if (thread_variant == DHRY_POWER)
+		dhry_power_run(iterations);
+	else
+		dhry_faithful_run(iterations);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dhryStone_release
+ * @BRIEF		release calling thread Dhrystone states.
+ * @DESCRIPTION		release calling thread Dhrystone states (of all
+ *			variants), for threads not running until process exit.
+ *//*------------------------------------------------------------------------ */
+void dhryStone_release(void)
+{
+	dhry_faithful_release();
+	dhry_power_release();
+}
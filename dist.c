@@ -0,0 +1,281 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			dist.c
+ * @Description			Pseudo-random number generator and distributions
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "dist.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define DIST_NAME_MAX		16
+
+
+static const char *dist_names[DIST_TYPES_COUNT] = {
+	"constant",
+	"uniform",
+	"exponential",
+	"lognormal",
+	"pareto"
+};
+
+/* Default shape parameter of each distribution (see dist_sample()) */
+static const double dist_shapes[DIST_TYPES_COUNT] = {
+	0.0,
+	1.0,
+	0.0,
+	1.0,
+	2.5
+};
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		splitmix64
+ * @BRIEF		SplitMix64 generator step.
+ * @RETURNS		next SplitMix64 output
+ * @param[in, out]	x: generator state
+ * @DESCRIPTION		SplitMix64 generator step, used to expand a seed into
+ *			xoshiro256** state.
+ *//*------------------------------------------------------------------------ */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z;
+
+	*x += 0x9e3779b97f4a7c15ULL;
+	z = *x;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		rng_seed
+ * @BRIEF		seed a pseudo-random number generator.
+ * @param[out]		rng: generator state
+ * @param[in]		seed: global seed
+ * @param[in]		stream: stream ID (e.g. thread index)
+ * @DESCRIPTION		seed a pseudo-random number generator, so that each
+ *			(seed, stream) pair yields an independent and
+ *			reproducible sequence.
+ *//*------------------------------------------------------------------------ */
+void rng_seed(rng_state *rng, uint64_t seed, uint64_t stream)
+{
+	uint64_t x;
+	int i;
+
+	x = seed ^ splitmix64(&stream);
+	for (i = 0; i < 4; i++)
+		rng->s[i] = splitmix64(&x);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		rng_next
+ * @BRIEF		generate a 64-bit pseudo-random number.
+ * @RETURNS		64-bit pseudo-random number
+ * @param[in, out]	rng: generator state
+ * @DESCRIPTION		generate a 64-bit pseudo-random number
+ *			(xoshiro256**).
+ *//*------------------------------------------------------------------------ */
+uint64_t rng_next(rng_state *rng)
+{
+	uint64_t *s = rng->s;
+	uint64_t result, t;
+
+	result = s[1] * 5;
+	result = ((result << 7) | (result >> 57)) * 9;
+	t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+
+	return result;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		rng_double
+ * @BRIEF		generate a pseudo-random number in (0, 1].
+ * @RETURNS		pseudo-random number in (0, 1]
+ * @param[in, out]	rng: generator state
+ * @DESCRIPTION		generate a pseudo-random number in (0, 1] (never 0,
+ *			so that it may be passed to log()).
+ *//*------------------------------------------------------------------------ */
+double rng_double(rng_state *rng)
+{
+	return ((double) ((rng_next(rng) >> 11) + 1)) * 0x1.0p-53;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dist_parse
+ * @BRIEF		parse distribution argument.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ * @param[in]		arg: "name[:shape]" string
+ * @param[out]		d: distribution
+ * @DESCRIPTION		parse distribution argument. Shape is the half-width
+ *			relative to the mean for uniform ((0-1], default 1),
+ *			sigma for lognormal (default 1) and alpha for Pareto
+ *			(> 1, default 2.5). Exponential has no shape.
+ *//*------------------------------------------------------------------------ */
+int dist_parse(const char *arg, dist *d)
+{
+	char name[DIST_NAME_MAX];
+	const char *sep;
+	size_t len;
+	int i;
+
+	sep = strchr(arg, ':');
+	len = (sep != NULL) ? (size_t) (sep - arg) : strlen(arg);
+	if ((len == 0) || (len >= DIST_NAME_MAX))
+		return -EINVAL;
+	memcpy(name, arg, len);
+	name[len] = '\0';
+
+	for (i = 0; i < DIST_TYPES_COUNT; i++) {
+		if (strcmp(name, dist_names[i]) == 0)
+			break;
+	}
+	if (i == DIST_TYPES_COUNT)
+		return -EINVAL;
+	d->type = (dist_type) i;
+	d->shape = dist_shapes[i];
+
+	if (sep != NULL) {
+		if ((d->type == DIST_CONSTANT) ||
+			(d->type == DIST_EXPONENTIAL))
+			return -EINVAL;
+		if (sscanf(sep + 1, "%lf", &d->shape) != 1)
+			return -EINVAL;
+	}
+
+	switch (d->type) {
+	case DIST_UNIFORM:
+		if ((d->shape <= 0.0) || (d->shape > 1.0))
+			return -EINVAL;
+		break;
+	case DIST_LOGNORMAL:
+		if (d->shape <= 0.0)
+			return -EINVAL;
+		break;
+	case DIST_PARETO:
+		if (d->shape <= 1.0)
+			return -EINVAL;
+		break;
+	default:
+		break;
+	}
+	dprintf("%s(): %s shape=%f\n", __func__, dist_names[d->type], d->shape);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dist_name
+ * @BRIEF		return distribution name.
+ * @RETURNS		distribution name
+ * @param[in]		type: distribution type
+ * @DESCRIPTION		return distribution name.
+ *//*------------------------------------------------------------------------ */
+const char *dist_name(dist_type type)
+{
+	if ((type < 0) || (type >= DIST_TYPES_COUNT))
+		return "unknown";
+	return dist_names[type];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		dist_sample
+ * @BRIEF		draw a sample from a distribution.
+ * @RETURNS		sample (>= 0)
+ * @param[in]		d: distribution
+ * @param[in, out]	rng: generator state
+ * @param[in]		mean: distribution mean
+ * @DESCRIPTION		draw a sample from a distribution, scaled so that its
+ *			mean is the given one.
+ *//*------------------------------------------------------------------------ */
+double dist_sample(const dist *d, rng_state *rng, double mean)
+{
+	double u, v, sigma, alpha;
+
+	switch (d->type) {
+	case DIST_UNIFORM:
+		u = rng_double(rng);
+		return mean * (1.0 + d->shape * (2.0 * u - 1.0));
+	case DIST_EXPONENTIAL:
+		return -mean * log(rng_double(rng));
+	case DIST_LOGNORMAL:
+		/* Box-Muller transform, E[X] = exp(mu + sigma^2 / 2) */
+		sigma = d->shape;
+		u = rng_double(rng);
+		v = rng_double(rng);
+		return mean * exp(sigma * sqrt(-2.0 * log(u)) *
+			cos(2.0 * M_PI * v) - sigma * sigma / 2.0);
+	case DIST_PARETO:
+		/* E[X] = alpha * xm / (alpha - 1) */
+		alpha = d->shape;
+		u = rng_double(rng);
+		return mean * ((alpha - 1.0) / alpha) * pow(u, -1.0 / alpha);
+	case DIST_CONSTANT:
+	default:
+		return mean;
+	}
+}
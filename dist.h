@@ -0,0 +1,79 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			dist.h
+ * @Description			Pseudo-random number generator and distributions
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_DIST_H__
+#define __CPULOADGEN_DIST_H__
+
+
+#include <stdint.h>
+
+
+typedef enum {
+	DIST_CONSTANT,
+	DIST_UNIFORM,
+	DIST_EXPONENTIAL,
+	DIST_LOGNORMAL,
+	DIST_PARETO,
+	DIST_TYPES_COUNT
+} dist_type;
+
+typedef struct {
+	dist_type type;
+	double shape;
+} dist;
+
+typedef struct {
+	uint64_t s[4];
+} rng_state;
+
+
+void rng_seed(rng_state *rng, uint64_t seed, uint64_t stream);
+uint64_t rng_next(rng_state *rng);
+double rng_double(rng_state *rng);
+int dist_parse(const char *arg, dist *d);
+const char *dist_name(dist_type type);
+double dist_sample(const dist *d, rng_state *rng, double mean);
+
+
+#endif
@@ -0,0 +1,446 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			energy.c
+ * @Description			Energy per load level characterisation
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <pthread.h>
+#include "energy.h"
+#include "metrics.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define ENERGY_PATH_MAX		320
+#define ENERGY_ZONES_MAX	16
+
+
+typedef struct {
+	char path[ENERGY_PATH_MAX];
+	unsigned long long range;	/* counter wrap-around value */
+	unsigned long long last;
+} energy_zone;
+
+
+/* Student's t 97.5% quantiles, for 1 to 30 degrees of freedom */
+static const double student_t975[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+static energy_zone zones[ENERGY_ZONES_MAX];
+static unsigned int zone_count = 0;
+static double energy_uj;
+
+static unsigned int step_workers, step_settle, step_window, step_windows;
+static unsigned int step_done;
+static double *step_watts = NULL;
+static double *step_nj = NULL;
+static pthread_t meter;
+static int meter_running = 0;
+static int meter_stop = 0;
+static pthread_mutex_t meter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t meter_cond;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		read_ull
+ * @BRIEF		read unsigned integer value from a sysfs file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: sysfs file path
+ * @param[out]		val: value read
+ * @DESCRIPTION		read unsigned integer value from a sysfs file.
+ *//*------------------------------------------------------------------------ */
+static int read_ull(const char *path, unsigned long long *val)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	ret = (fscanf(fp, "%llu", val) == 1) ? 0 : -EIO;
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_open
+ * @BRIEF		discover RAPL (powercap) energy counters.
+ * @RETURNS		0 on success
+ *			-ENOENT if no energy counter is present
+ *			-EACCES if energy counters are not readable
+ * @DESCRIPTION		discover RAPL (powercap) energy counters: top-level
+ *			(package) zones only, as sub-zones (core, uncore,
+ *			dram) are included in them, or not comparable. Zones
+ *			whose wrap-around value is not readable are skipped.
+ *//*------------------------------------------------------------------------ */
+int energy_open(void)
+{
+	char path[ENERGY_PATH_MAX];
+	struct dirent *d;
+	energy_zone *z;
+	char *p;
+	DIR *dir;
+	int ret = -ENOENT, err;
+
+	zone_count = 0;
+	dir = opendir("/sys/class/powercap");
+	if (dir == NULL)
+		return -ENOENT;
+	while (((d = readdir(dir)) != NULL) &&
+		(zone_count < ENERGY_ZONES_MAX)) {
+		p = strchr(d->d_name, ':');
+		if ((p == NULL) || (strchr(p + 1, ':') != NULL))
+			continue;
+		z = &zones[zone_count];
+		snprintf(z->path, sizeof(z->path),
+			"/sys/class/powercap/%s/energy_uj", d->d_name);
+		err = read_ull(z->path, &z->last);
+		if (err != 0) {
+			if ((err == -EACCES) || (err == -EPERM))
+				ret = -EACCES;
+			continue;
+		}
+		snprintf(path, sizeof(path),
+			"/sys/class/powercap/%s/max_energy_range_uj",
+			d->d_name);
+		/* Without wrap-around value, a wrap would count garbage */
+		if ((read_ull(path, &z->range) != 0) || (z->range == 0)) {
+			dprintf("Energy: zone %s skipped (no range)\n",
+				d->d_name);
+			continue;
+		}
+		dprintf("Energy: zone %s (range %lluuJ)\n", d->d_name,
+			z->range);
+		zone_count++;
+	}
+	closedir(dir);
+	if (zone_count == 0)
+		return ret;
+	energy_uj = 0.0;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_read
+ * @BRIEF		read energy consumed by all packages.
+ * @RETURNS		energy consumed since energy_open() (J)
+ * @DESCRIPTION		read energy consumed by all packages, handling
+ *			counters wrap-around (at most once between two reads).
+ *			A zone becoming unreadable no longer contributes.
+ *//*------------------------------------------------------------------------ */
+static double energy_read(void)
+{
+	unsigned long long val;
+	energy_zone *z;
+	unsigned int i;
+
+	for (i = 0; i < zone_count; i++) {
+		z = &zones[i];
+		if (read_ull(z->path, &val) != 0)
+			continue;
+		if (val >= z->last)
+			energy_uj += (double) (val - z->last);
+		else
+			energy_uj += (double) (z->range - z->last + val);
+		z->last = val;
+	}
+
+	return energy_uj / 1.0e6;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_iterations
+ * @BRIEF		return Dhrystone iterations of all load threads.
+ * @RETURNS		Dhrystone iterations of all load threads so far
+ * @DESCRIPTION		return Dhrystone iterations of all load threads so
+ *			far, from their live counters.
+ *//*------------------------------------------------------------------------ */
+static unsigned long long energy_iterations(void)
+{
+	unsigned long long iterations = 0;
+	metrics_worker *w;
+	unsigned int i;
+
+	for (i = 0; i < step_workers; i++) {
+		w = metrics_worker_get(i);
+		if (w != NULL)
+			iterations += __atomic_load_n(&w->iterations,
+				__ATOMIC_RELAXED);
+	}
+
+	return iterations;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_wait
+ * @BRIEF		wait until a given time.
+ * @RETURNS		1 if measurement was stopped, 0 otherwise
+ * @param[in]		ts: absolute time (CLOCK_MONOTONIC)
+ * @DESCRIPTION		wait until a given time, or until measurement is
+ *			stopped.
+ *//*------------------------------------------------------------------------ */
+static int energy_wait(const struct timespec *ts)
+{
+	int stop;
+
+	pthread_mutex_lock(&meter_mutex);
+	while ((!meter_stop) &&
+		(pthread_cond_timedwait(&meter_cond, &meter_mutex, ts) !=
+		ETIMEDOUT))
+		;
+	stop = meter_stop;
+	pthread_mutex_unlock(&meter_mutex);
+
+	return stop;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_measure
+ * @BRIEF		energy measurement thread.
+ * @RETURNS		NULL
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		energy measurement thread: wait for settling period,
+ *			then measure average power and energy per Dhrystone
+ *			iteration over each window. Windows are scheduled on
+ *			absolute time, so that they do not drift.
+ *//*------------------------------------------------------------------------ */
+static void *energy_measure(void *ptr)
+{
+	unsigned long long it, it_last;
+	struct timespec ts, now;
+	double e, e_last, t, t_last;
+	sigset_t set;
+
+	(void) ptr;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts.tv_sec += step_settle;
+	if (energy_wait(&ts))
+		return NULL;
+	e_last = energy_read();
+	it_last = energy_iterations();
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	t_last = now.tv_sec + now.tv_nsec / 1.0e9;
+
+	while (step_done < step_windows) {
+		ts.tv_sec += step_window;
+		if (energy_wait(&ts))
+			break;
+		e = energy_read();
+		it = energy_iterations();
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		t = now.tv_sec + now.tv_nsec / 1.0e9;
+		step_watts[step_done] = (e - e_last) / (t - t_last);
+		step_nj[step_done] = (it > it_last) ?
+			(e - e_last) * 1.0e9 / (double) (it - it_last) : -1.0;
+		dprintf("Energy: window %u: %.3fW, %.3fnJ/iteration\n",
+			step_done, step_watts[step_done], step_nj[step_done]);
+		step_done++;
+		e_last = e;
+		it_last = it;
+		t_last = t;
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_step_start
+ * @BRIEF		start measuring a load level.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		workers: number of load threads (metrics workers)
+ * @param[in]		settle: settling period (s)
+ * @param[in]		window: measurement window (s)
+ * @param[in]		windows: number of measurement windows
+ * @DESCRIPTION		start measuring a load level, from now on. Load
+ *			threads shall be running, and last for at least
+ *			settle + window * windows seconds.
+ *//*------------------------------------------------------------------------ */
+int energy_step_start(unsigned int workers, unsigned int settle,
+	unsigned int window, unsigned int windows)
+{
+	pthread_condattr_t attr;
+	int ret;
+
+	step_watts = calloc(windows, sizeof(double));
+	step_nj = calloc(windows, sizeof(double));
+	if ((step_watts == NULL) || (step_nj == NULL)) {
+		free(step_watts);
+		free(step_nj);
+		step_watts = step_nj = NULL;
+		return -ENOMEM;
+	}
+	step_workers = workers;
+	step_settle = settle;
+	step_window = window;
+	step_windows = windows;
+	step_done = 0;
+	meter_stop = 0;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&meter_cond, &attr);
+	pthread_condattr_destroy(&attr);
+	ret = pthread_create(&meter, NULL, energy_measure, NULL);
+	if (ret != 0) {
+		pthread_cond_destroy(&meter_cond);
+		return -ret;
+	}
+	meter_running = 1;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_interval
+ * @BRIEF		compute mean and confidence interval of samples.
+ * @param[in]		x: samples (negative ones are skipped)
+ * @param[in]		n: number of samples
+ * @param[out]		mean: samples mean (< 0 if no sample)
+ * @param[out]		ci: 95% confidence interval half-width of the mean
+ *			(Student's t), < 0 if less than 2 samples
+ * @DESCRIPTION		compute mean and confidence interval of samples.
+ *//*------------------------------------------------------------------------ */
+static void energy_interval(const double *x, unsigned int n, double *mean,
+	double *ci)
+{
+	double sum = 0.0, var = 0.0, t;
+	unsigned int i, count = 0;
+
+	*mean = *ci = -1.0;
+	for (i = 0; i < n; i++) {
+		if (x[i] < 0.0)
+			continue;
+		sum += x[i];
+		count++;
+	}
+	if (count == 0)
+		return;
+	*mean = sum / count;
+	if (count < 2)
+		return;
+
+	for (i = 0; i < n; i++) {
+		if (x[i] >= 0.0)
+			var += (x[i] - *mean) * (x[i] - *mean);
+	}
+	var /= count - 1;
+	t = (count - 1 <= 30) ? student_t975[count - 2] : 1.96;
+	*ci = t * sqrt(var / count);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_step_stop
+ * @BRIEF		stop measuring a load level.
+ * @param[out]		res: energy measured over completed windows
+ * @DESCRIPTION		stop measuring a load level (ending any window in
+ *			progress, which is discarded), and compute average
+ *			power and energy per Dhrystone iteration, with their
+ *			confidence interval across windows.
+ *//*------------------------------------------------------------------------ */
+void energy_step_stop(energy_step *res)
+{
+	memset(res, 0, sizeof(*res));
+	if (!meter_running)
+		return;
+
+	pthread_mutex_lock(&meter_mutex);
+	meter_stop = 1;
+	pthread_cond_signal(&meter_cond);
+	pthread_mutex_unlock(&meter_mutex);
+	pthread_join(meter, NULL);
+	pthread_cond_destroy(&meter_cond);
+	meter_running = 0;
+
+	res->windows = step_done;
+	energy_interval(step_watts, step_done, &res->watts, &res->watts_ci);
+	energy_interval(step_nj, step_done, &res->nj_per_iteration,
+		&res->nj_per_iteration_ci);
+	free(step_watts);
+	free(step_nj);
+	step_watts = step_nj = NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		energy_close
+ * @BRIEF		release energy counters.
+ * @DESCRIPTION		stop any measurement and release energy counters.
+ *//*------------------------------------------------------------------------ */
+void energy_close(void)
+{
+	energy_step res;
+
+	energy_step_stop(&res);
+	zone_count = 0;
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			energy.h
+ * @Description			Energy per load level characterisation
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_ENERGY_H__
+#define __CPULOADGEN_ENERGY_H__
+
+
+/* Default settling period before measuring a load level (s) */
+#define DEFAULT_ENERGY_SETTLE	5
+/* Default measurement window (s) */
+#define DEFAULT_ENERGY_WINDOW	2
+/* Default number of measurement windows per load level */
+#define DEFAULT_ENERGY_WINDOWS	5
+/* Maximum number of measurement windows per load level */
+#define ENERGY_WINDOWS_MAX	1000
+/*
+ * Load kept running after last window (s), so that no window includes
+ * load threads start-up or termination.
+ */
+#define ENERGY_TAIL		1
+
+
+/* Energy measured over one load level. Confidence interval < 0 if n/a. */
+typedef struct {
+	unsigned int windows;		/* completed measurement windows */
+	double watts;			/* average power */
+	double watts_ci;		/* 95% confidence interval half-width */
+	double nj_per_iteration;	/* energy per Dhrystone iteration */
+	double nj_per_iteration_ci;
+} energy_step;
+
+
+int energy_open(void);
+int energy_step_start(unsigned int workers, unsigned int settle,
+	unsigned int window, unsigned int windows);
+void energy_step_stop(energy_step *res);
+void energy_close(void);
+
+
+#endif
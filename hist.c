@@ -0,0 +1,197 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			hist.c
+ * @Description			HDR-style log-linear histogram
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <string.h>
+#include "hist.h"
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_index
+ * @BRIEF		compute bucket index of a given value.
+ * @RETURNS		bucket index
+ * @param[in]		val: value
+ * @DESCRIPTION		compute bucket index of a given value.
+ *//*------------------------------------------------------------------------ */
+static unsigned int hist_index(unsigned long long val)
+{
+	unsigned int shift;
+
+	if (val < HIST_SUB_COUNT)
+		return (unsigned int) val;
+
+	shift = (63 - __builtin_clzll(val)) - (HIST_SUB_BITS - 1);
+	if (shift > HIST_SHIFT_MAX)
+		return HIST_BUCKETS - 1;
+
+	return HIST_SUB_COUNT + (shift - 1) * HIST_HALF_COUNT +
+		(unsigned int) ((val >> shift) - HIST_HALF_COUNT);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_value
+ * @BRIEF		compute highest value recorded in a given bucket.
+ * @RETURNS		highest value of bucket
+ * @param[in]		idx: bucket index
+ * @DESCRIPTION		compute highest value recorded in a given bucket.
+ *//*------------------------------------------------------------------------ */
+unsigned long long hist_value(unsigned int idx)
+{
+	unsigned int shift;
+	unsigned long long sub;
+
+	if (idx < HIST_SUB_COUNT)
+		return idx;
+
+	shift = 1 + (idx - HIST_SUB_COUNT) / HIST_HALF_COUNT;
+	sub = HIST_HALF_COUNT + (idx - HIST_SUB_COUNT) % HIST_HALF_COUNT;
+
+	return ((sub + 1) << shift) - 1;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_init
+ * @BRIEF		initialize histogram.
+ * @param[in, out]	h: histogram
+ * @DESCRIPTION		initialize histogram.
+ *//*------------------------------------------------------------------------ */
+void hist_init(hist *h)
+{
+	memset(h, 0, sizeof(hist));
+	h->min = ~0ULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_record
+ * @BRIEF		record a value into histogram.
+ * @param[in, out]	h: histogram
+ * @param[in]		val: value to be recorded
+ * @DESCRIPTION		record a value into histogram.
+ *//*------------------------------------------------------------------------ */
+void hist_record(hist *h, unsigned long long val)
+{
+	h->counts[hist_index(val)]++;
+	h->count++;
+	h->sum += (double) val;
+	if (val < h->min)
+		h->min = val;
+	if (val > h->max)
+		h->max = val;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_merge
+ * @BRIEF		add histogram samples to another histogram.
+ * @param[in, out]	dst: destination histogram
+ * @param[in]		src: source histogram
+ * @DESCRIPTION		add histogram samples to another histogram.
+ *//*------------------------------------------------------------------------ */
+void hist_merge(hist *dst, const hist *src)
+{
+	unsigned int i;
+
+	for (i = 0; i < HIST_BUCKETS; i++)
+		dst->counts[i] += src->counts[i];
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_percentile
+ * @BRIEF		compute a given percentile of histogram samples.
+ * @RETURNS		percentile value (0 if histogram is empty)
+ * @param[in]		h: histogram
+ * @param[in]		pct: percentile ([0.0-100.0])
+ * @DESCRIPTION		compute a given percentile of histogram samples.
+ *			Returned value is the upper bound of the bucket the
+ *			percentile falls into, capped by the maximum value.
+ *//*------------------------------------------------------------------------ */
+unsigned long long hist_percentile(const hist *h, double pct)
+{
+	unsigned long long rank, seen = 0, val;
+	unsigned int i;
+
+	if (h->count == 0)
+		return 0;
+
+	rank = (unsigned long long) ((pct / 100.0) * (double) h->count + 0.5);
+	if (rank < 1)
+		rank = 1;
+	else if (rank > h->count)
+		rank = h->count;
+
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		seen += h->counts[i];
+		if (seen >= rank) {
+			val = hist_value(i);
+			return (val > h->max) ? h->max : val;
+		}
+	}
+
+	return h->max;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hist_mean
+ * @BRIEF		compute mean of histogram samples.
+ * @RETURNS		mean value (0.0 if histogram is empty)
+ * @param[in]		h: histogram
+ * @DESCRIPTION		compute mean of histogram samples.
+ *//*------------------------------------------------------------------------ */
+double hist_mean(const hist *h)
+{
+	if (h->count == 0)
+		return 0.0;
+
+	return h->sum / (double) h->count;
+}
@@ -0,0 +1,77 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			hist.h
+ * @Description			HDR-style log-linear histogram
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_HIST_H__
+#define __CPULOADGEN_HIST_H__
+
+
+/*
+ * Log-linear histogram: values below 2^HIST_SUB_BITS are recorded exactly,
+ * larger values with HIST_SUB_BITS - 1 significant bits (< 1% error).
+ */
+#define HIST_SUB_BITS		7
+#define HIST_SUB_COUNT		(1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT		(1 << (HIST_SUB_BITS - 1))
+#define HIST_SHIFT_MAX		41
+#define HIST_BUCKETS		(HIST_SUB_COUNT + HIST_SHIFT_MAX * HIST_HALF_COUNT)
+
+
+typedef struct {
+	unsigned long long counts[HIST_BUCKETS];
+	unsigned long long count;
+	unsigned long long min;
+	unsigned long long max;
+	double sum;
+} hist;
+
+
+void hist_init(hist *h);
+void hist_record(hist *h, unsigned long long val);
+void hist_merge(hist *dst, const hist *src);
+unsigned long long hist_percentile(const hist *h, double pct);
+double hist_mean(const hist *h);
+unsigned long long hist_value(unsigned int idx);
+
+
+#endif
@@ -0,0 +1,475 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			hotplug.c
+ * @Description			CPU hotplug and cpuset change handling
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include "hotplug.h"
+#include "sampler.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define HOTPLUG_LIST_MAX	4096
+
+/* CPU core state bits */
+#define HOTPLUG_ONLINE		1
+#define HOTPLUG_ALLOWED		2	/* in process cpuset (affinity) */
+#define HOTPLUG_AVAILABLE	(HOTPLUG_ONLINE | HOTPLUG_ALLOWED)
+
+
+static unsigned char *cpu_state = NULL;
+static unsigned char *cpu_scratch = NULL;
+static unsigned int hotplug_cpus = 0;
+static pid_t hotplug_pid;
+static unsigned int hotplug_gen = 0;
+static unsigned long long events = 0;
+static volatile sig_atomic_t *hotplug_halt = NULL;
+static pthread_t watcher;
+static int watcher_running = 0;
+static volatile int watcher_stop = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpulist_read
+ * @BRIEF		read a CPU list sysfs file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: sysfs file path
+ * @param[out]		set: set[cpu] = 1 for each CPU core of the list
+ * @param[in]		count: number of CPU cores
+ * @DESCRIPTION		read a CPU list sysfs file (e.g. "0-3,6").
+ *//*------------------------------------------------------------------------ */
+static int cpulist_read(const char *path, unsigned char *set,
+	unsigned int count)
+{
+	char buf[HOTPLUG_LIST_MAX], *p, *end;
+	unsigned long first, last, cpu;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	if (p == NULL)
+		return -EIO;
+
+	memset(set, 0, count);
+	while ((*p != '\0') && (*p != '\n')) {
+		first = strtoul(p, &end, 10);
+		if (end == p)
+			return -EINVAL;
+		last = first;
+		if (*end == '-') {
+			p = end + 1;
+			last = strtoul(p, &end, 10);
+			if (end == p)
+				return -EINVAL;
+		}
+		for (cpu = first; (cpu <= last) && (cpu < count); cpu++)
+			set[cpu] = 1;
+		p = (*end == ',') ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_read
+ * @BRIEF		read state of all CPU cores.
+ * @param[out]		state: state bits of each CPU core
+ * @DESCRIPTION		read state of all CPU cores: online (sysfs), and in
+ *			process cpuset, as reflected by main thread affinity
+ *			(which is never pinned). CPU cores are assumed online
+ *			and allowed if either is not readable.
+ *//*------------------------------------------------------------------------ */
+static void hotplug_read(unsigned char *state)
+{
+	cpu_set_t allowed;
+	unsigned int cpu;
+	int allowed_ok;
+
+	if (cpulist_read("/sys/devices/system/cpu/online", state,
+		hotplug_cpus) != 0)
+		memset(state, 1, hotplug_cpus);
+	allowed_ok = (sched_getaffinity(hotplug_pid, sizeof(allowed),
+		&allowed) == 0);
+	for (cpu = 0; cpu < hotplug_cpus; cpu++) {
+		state[cpu] = state[cpu] ? HOTPLUG_ONLINE : 0;
+		if ((!allowed_ok) || ((cpu < CPU_SETSIZE) &&
+			(CPU_ISSET(cpu, &allowed))))
+			state[cpu] |= HOTPLUG_ALLOWED;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_poll
+ * @BRIEF		detect CPU cores state changes.
+ * @DESCRIPTION		detect CPU cores state changes: report them (output
+ *			and samples file), and bump hotplug generation so that
+ *			load threads check their placement.
+ *//*------------------------------------------------------------------------ */
+static void hotplug_poll(void)
+{
+	unsigned int cpu, changed = 0;
+	unsigned char old, new;
+
+	hotplug_read(cpu_scratch);
+	for (cpu = 0; cpu < hotplug_cpus; cpu++) {
+		old = cpu_state[cpu];
+		new = cpu_scratch[cpu];
+		if (old == new)
+			continue;
+		__atomic_store_n(&cpu_state[cpu], new, __ATOMIC_RELAXED);
+		changed++;
+		if ((old ^ new) & HOTPLUG_ONLINE) {
+			printf("Hotplug: CPU%u %s.\n", cpu,
+				(new & HOTPLUG_ONLINE) ? "online" : "offline");
+			sampler_mark("hotplug cpu%u=%s", cpu,
+				(new & HOTPLUG_ONLINE) ? "online" : "offline");
+		} else {
+			printf("Hotplug: CPU%u %s cpuset.\n", cpu,
+				(new & HOTPLUG_ALLOWED) ? "added to" : "removed from");
+			sampler_mark("cpuset cpu%u=%s", cpu,
+				(new & HOTPLUG_ALLOWED) ? "added" : "removed");
+		}
+	}
+	if (changed == 0)
+		return;
+	fflush(stdout);
+	__atomic_add_fetch(&events, changed, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&hotplug_gen, 1, __ATOMIC_RELEASE);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_watch
+ * @BRIEF		hotplug watcher thread.
+ * @RETURNS		NULL
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		hotplug watcher thread: poll CPU cores state every
+ *			HOTPLUG_POLL_MS. Termination signals are left to other
+ *			threads, so that main thread wakes up on CTRL+C.
+ *//*------------------------------------------------------------------------ */
+static void *hotplug_watch(void *ptr)
+{
+	struct timespec ts;
+	sigset_t set;
+
+	(void) ptr;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	while (!watcher_stop) {
+		ts.tv_sec = 0;
+		ts.tv_nsec = HOTPLUG_POLL_MS * 1000000L;
+		nanosleep(&ts, NULL);
+		hotplug_poll();
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_init
+ * @BRIEF		read initial state of CPU cores.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu_count: number of CPU cores (configured)
+ * @DESCRIPTION		read initial state of CPU cores.
+ *//*------------------------------------------------------------------------ */
+int hotplug_init(unsigned int cpu_count)
+{
+	cpu_state = malloc(cpu_count);
+	cpu_scratch = malloc(cpu_count);
+	if ((cpu_state == NULL) || (cpu_scratch == NULL)) {
+		hotplug_stop();
+		return -ENOMEM;
+	}
+	hotplug_cpus = cpu_count;
+	hotplug_pid = getpid();
+	hotplug_read(cpu_state);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_start
+ * @BRIEF		start watching CPU cores state.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		halt: load generation stop flag, ending parking
+ * @DESCRIPTION		start watcher thread, polling online CPU cores and
+ *			process cpuset (no netlink uevent needed, and cpuset
+ *			changes do not raise any).
+ *//*------------------------------------------------------------------------ */
+int hotplug_start(volatile sig_atomic_t *halt)
+{
+	int ret;
+
+	hotplug_halt = halt;
+	watcher_stop = 0;
+	ret = pthread_create(&watcher, NULL, hotplug_watch, NULL);
+	if (ret != 0)
+		return -ret;
+	watcher_running = 1;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_stop
+ * @BRIEF		stop watching CPU cores state.
+ * @DESCRIPTION		stop watcher thread and release CPU cores state.
+ *//*------------------------------------------------------------------------ */
+void hotplug_stop(void)
+{
+	if (watcher_running) {
+		watcher_stop = 1;
+		pthread_join(watcher, NULL);
+		watcher_running = 0;
+	}
+	free(cpu_state);
+	cpu_state = NULL;
+	free(cpu_scratch);
+	cpu_scratch = NULL;
+	hotplug_cpus = 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_cpu_available
+ * @BRIEF		tell whether a CPU core may be loaded.
+ * @RETURNS		1 if CPU core is online and in process cpuset (or if
+ *			state is unknown), 0 otherwise
+ * @param[in]		cpu: CPU core
+ * @DESCRIPTION		tell whether a CPU core may be loaded, as of last
+ *			poll.
+ *//*------------------------------------------------------------------------ */
+int hotplug_cpu_available(unsigned int cpu)
+{
+	if (cpu >= hotplug_cpus)
+		return 1;
+
+	return __atomic_load_n(&cpu_state[cpu], __ATOMIC_RELAXED) ==
+		HOTPLUG_AVAILABLE;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_events
+ * @BRIEF		return number of CPU core state changes.
+ * @RETURNS		number of CPU core state changes since start
+ * @DESCRIPTION		return number of CPU core state changes since start.
+ *//*------------------------------------------------------------------------ */
+unsigned long long hotplug_events(void)
+{
+	return __atomic_load_n(&events, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_placed
+ * @BRIEF		tell whether calling thread is pinned to a CPU core.
+ * @RETURNS		1 if calling thread affinity is this CPU core only
+ * @param[in]		cpu: CPU core
+ * @DESCRIPTION		tell whether calling thread is pinned to a CPU core:
+ *			kernel rewrites affinity of threads pinned to a CPU
+ *			core going offline (and cgroup v1 of all threads on
+ *			cpuset change).
+ *//*------------------------------------------------------------------------ */
+static int hotplug_placed(unsigned int cpu)
+{
+	cpu_set_t set;
+
+	if (sched_getaffinity(0, sizeof(set), &set) != 0)
+		return 0;
+
+	return (CPU_COUNT(&set) == 1) && (CPU_ISSET(cpu, &set));
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_place
+ * @BRIEF		pin calling load thread to its CPU core.
+ * @RETURNS		1 if load thread was parked, 0 otherwise
+ * @param[in, out]	w: load thread placement
+ * @param[in]		restore: 1 if placement was lost
+ * @DESCRIPTION		pin calling load thread to its CPU core. If CPU core
+ *			is offline or out of process cpuset (EINVAL), park
+ *			load thread (sleeping) until it is back, or until
+ *			load generation stops. Other failures leave it unpinned
+ *			and are accounted as errors.
+ *//*------------------------------------------------------------------------ */
+static int hotplug_place(hotplug_worker *w, int restore)
+{
+	struct timespec ts, ts_park, ts_now;
+	unsigned long long ns;
+	int parked = 0, err;
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(w->cpu, &set);
+	while (1) {
+		if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+			w->pinned = 1;
+			if ((restore) || (parked)) {
+				w->repins++;
+				if (w->metrics != NULL)
+					metrics_count(&w->metrics->repins, 1);
+			}
+			break;
+		}
+		err = errno;
+		w->pinned = 0;
+		if (err != EINVAL) {
+			fprintf(stderr,
+				"cpuloadgen: could not pin load thread to CPU%u (%s)!\n",
+				w->cpu, strerror(err));
+			metrics_error(w->metrics);
+			break;
+		}
+		if ((hotplug_halt == NULL) || (*hotplug_halt))
+			break;
+		if (!parked) {
+			parked = 1;
+			w->parks++;
+			if (w->metrics != NULL)
+				metrics_count(&w->metrics->parks, 1);
+			clock_gettime(CLOCK_MONOTONIC, &ts_park);
+			dprintf("%s(): CPU%u not available, parking\n",
+				__func__, w->cpu);
+		}
+		ts.tv_sec = 0;
+		ts.tv_nsec = HOTPLUG_PARK_MS * 1000000L;
+		nanosleep(&ts, NULL);
+	}
+
+	if (parked) {
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		ns = (unsigned long long) (ts_now.tv_sec - ts_park.tv_sec) *
+			1000000000ULL + ts_now.tv_nsec - ts_park.tv_nsec;
+		w->parked_ns += ns;
+		if (w->metrics != NULL)
+			metrics_count(&w->metrics->parked_ns, ns);
+	}
+
+	return parked;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_worker_init
+ * @BRIEF		place calling load thread.
+ * @param[out]		w: load thread placement
+ * @param[in]		cpu: CPU core of load thread
+ * @param[in]		pin: 1 to pin load thread to its CPU core
+ * @param[in]		metrics: live counters (NULL if metrics disabled)
+ * @DESCRIPTION		place calling load thread: pin it to its CPU core,
+ *			parking it first if CPU core is not available.
+ *//*------------------------------------------------------------------------ */
+void hotplug_worker_init(hotplug_worker *w, unsigned int cpu, int pin,
+	metrics_worker *metrics)
+{
+	memset(w, 0, sizeof(*w));
+	w->cpu = cpu;
+	w->pin = pin;
+	w->metrics = metrics;
+	w->gen = __atomic_load_n(&hotplug_gen, __ATOMIC_ACQUIRE);
+	if (pin)
+		hotplug_place(w, 0);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		hotplug_check
+ * @BRIEF		verify placement of calling load thread.
+ * @RETURNS		1 if load thread was parked (its schedule should
+ *			restart from now), 0 otherwise
+ * @param[in, out]	w: load thread placement
+ * @DESCRIPTION		verify placement of calling load thread, between
+ *			periods or chunks: cheap unless a CPU core changed
+ *			state or load thread runs on another CPU core, in
+ *			which case it is pinned again, or parked until its
+ *			CPU core is available.
+ *//*------------------------------------------------------------------------ */
+int hotplug_check(hotplug_worker *w)
+{
+	unsigned int gen;
+
+	gen = __atomic_load_n(&hotplug_gen, __ATOMIC_ACQUIRE);
+	if ((gen == w->gen) &&
+		((!w->pinned) || (sched_getcpu() == (int) w->cpu)))
+		return 0;
+	w->gen = gen;
+	if (!w->pin)
+		return 0;
+	if (hotplug_placed(w->cpu)) {
+		w->pinned = 1;
+		return 0;
+	}
+
+	return hotplug_place(w, w->pinned);
+}
@@ -0,0 +1,82 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			hotplug.h
+ * @Description			CPU hotplug and cpuset change handling
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_HOTPLUG_H__
+#define __CPULOADGEN_HOTPLUG_H__
+
+
+#include <signal.h>
+#include "metrics.h"
+
+
+/* Online CPU cores and cpuset polling interval (ms) */
+#define HOTPLUG_POLL_MS		100
+/* Placement retry interval of a parked load thread (ms) */
+#define HOTPLUG_PARK_MS		10
+
+
+/* Placement of a load thread. Owned by its thread. */
+typedef struct {
+	unsigned int cpu;
+	unsigned int gen;		/* last hotplug generation seen */
+	int pin;			/* pinning requested */
+	int pinned;			/* pinning in effect */
+	metrics_worker *metrics;	/* NULL if metrics disabled */
+	unsigned long long repins;	/* placement lost, then restored */
+	unsigned long long parks;	/* CPU core not available */
+	unsigned long long parked_ns;
+} hotplug_worker;
+
+
+int hotplug_init(unsigned int cpu_count);
+int hotplug_start(volatile sig_atomic_t *halt);
+void hotplug_stop(void);
+int hotplug_cpu_available(unsigned int cpu);
+unsigned long long hotplug_events(void);
+void hotplug_worker_init(hotplug_worker *w, unsigned int cpu, int pin,
+	metrics_worker *metrics);
+int hotplug_check(hotplug_worker *w);
+
+
+#endif
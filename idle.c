@@ -0,0 +1,267 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			idle.c
+ * @Description			Idle phase behaviour modes
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sched.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "idle.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define DMA_LATENCY_DEV		"/dev/cpu_dma_latency"
+/* Longest single TPAUSE, in TSC cycles (a few microseconds) */
+#define TPAUSE_CYCLES		10000ULL
+
+
+static const char *idle_names[IDLE_MODES_COUNT] = {
+	"sleep",
+	"pause",
+	"yield",
+	"tpause"
+};
+
+static int dma_latency_fd = -1;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_mode_parse
+ * @BRIEF		convert idle mode name into idle mode.
+ * @RETURNS		idle mode
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: idle mode name
+ * @DESCRIPTION		convert idle mode name into idle mode.
+ *//*------------------------------------------------------------------------ */
+int idle_mode_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < IDLE_MODES_COUNT; i++) {
+		if (strcmp(name, idle_names[i]) == 0)
+			return i;
+	}
+	/* umwait is accepted as an alias, TPAUSE being its timed variant */
+	if (strcmp(name, "umwait") == 0)
+		return IDLE_TPAUSE;
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_mode_name
+ * @BRIEF		return idle mode name.
+ * @RETURNS		idle mode name
+ * @param[in]		mode: idle mode
+ * @DESCRIPTION		return idle mode name.
+ *//*------------------------------------------------------------------------ */
+const char *idle_mode_name(idle_mode mode)
+{
+	if ((mode < 0) || (mode >= IDLE_MODES_COUNT))
+		return "unknown";
+	return idle_names[mode];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_mode_check
+ * @BRIEF		check idle mode is supported by the CPU.
+ * @RETURNS		idle mode to be used
+ * @param[in]		mode: requested idle mode
+ * @DESCRIPTION		check idle mode is supported by the CPU.
+ *			TPAUSE requires the x86 WAITPKG extension: fall back
+ *			to PAUSE spinning if it is not available.
+ *//*------------------------------------------------------------------------ */
+idle_mode idle_mode_check(idle_mode mode)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+#endif
+
+	if (mode != IDLE_TPAUSE)
+		return mode;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if ((__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) != 0) &&
+		((ecx & (1 << 5)) != 0))
+		return mode;
+#endif
+	fprintf(stderr,
+		"cpuloadgen: tpause not supported by this CPU, using pause instead!\n");
+
+	return IDLE_PAUSE;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tpause
+ * @BRIEF		wait in C0.2 state for a short time.
+ * @DESCRIPTION		wait in C0.2 light-weight state for at most
+ *			TPAUSE_CYCLES TSC cycles. Instructions are encoded by
+ *			hand so that no -mwaitpkg compiler support is needed.
+ *//*------------------------------------------------------------------------ */
+static inline void tpause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	uint32_t lo, hi;
+	uint64_t tsc;
+
+	__asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+	tsc = (((uint64_t) hi) << 32 | lo) + TPAUSE_CYCLES;
+	/* tpause %ecx (ecx = 0: C0.2), deadline in edx:eax */
+	__asm__ __volatile__(".byte 0x66, 0x0f, 0xae, 0xf1"
+		:: "c" (0), "a" ((uint32_t) tsc), "d" ((uint32_t) (tsc >> 32))
+		: "memory", "cc");
+#else
+	cpu_relax();
+#endif
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_until
+ * @BRIEF		stay idle until an absolute time.
+ * @param[in]		mode: idle mode
+ * @param[in]		deadline: end of idle phase (CLOCK_MONOTONIC)
+ * @DESCRIPTION		stay idle until an absolute time, either sleeping
+ *			(letting the core enter C-states), or spinning with
+ *			PAUSE, sched_yield() or TPAUSE (keeping it in C0).
+ *			Sleep ends early if interrupted by a signal, so that
+ *			caller may check whether it has to stop.
+ *//*------------------------------------------------------------------------ */
+void idle_until(idle_mode mode, const struct timespec *deadline)
+{
+	struct timespec now;
+
+	if (mode == IDLE_SLEEP) {
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline,
+			NULL);
+		return;
+	}
+
+	while (1) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec > deadline->tv_sec) ||
+			((now.tv_sec == deadline->tv_sec) &&
+			(now.tv_nsec >= deadline->tv_nsec)))
+			break;
+		switch (mode) {
+		case IDLE_YIELD:
+			sched_yield();
+			break;
+		case IDLE_TPAUSE:
+			tpause();
+			break;
+		case IDLE_PAUSE:
+		default:
+			cpu_relax();
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_dma_latency_hold
+ * @BRIEF		request a maximum CPU wakeup latency.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		us: maximum wakeup latency (in microseconds)
+ * @DESCRIPTION		request a maximum CPU wakeup latency via PM QoS,
+ *			preventing deeper C-states from being entered.
+ *			Request holds as long as /dev/cpu_dma_latency is kept
+ *			open, i.e. until idle_dma_latency_release() is called.
+ *//*------------------------------------------------------------------------ */
+int idle_dma_latency_hold(int us)
+{
+	int32_t val = (int32_t) us;
+	int ret;
+
+	dma_latency_fd = open(DMA_LATENCY_DEV, O_RDWR);
+	if (dma_latency_fd < 0) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not open %s (%s)!\n",
+			DMA_LATENCY_DEV, strerror(errno));
+		return ret;
+	}
+	if (write(dma_latency_fd, &val, sizeof(val)) != sizeof(val)) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not write %s (%s)!\n",
+			DMA_LATENCY_DEV, strerror(errno));
+		close(dma_latency_fd);
+		dma_latency_fd = -1;
+		return ret;
+	}
+	dprintf("%s(): holding %s at %dus\n", __func__, DMA_LATENCY_DEV, us);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		idle_dma_latency_release
+ * @BRIEF		release maximum CPU wakeup latency request.
+ * @DESCRIPTION		release maximum CPU wakeup latency request.
+ *//*------------------------------------------------------------------------ */
+void idle_dma_latency_release(void)
+{
+	if (dma_latency_fd < 0)
+		return;
+	close(dma_latency_fd);
+	dma_latency_fd = -1;
+}
@@ -0,0 +1,250 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			latency.c
+ * @Description			Wakeup latency probe
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "latency.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define LATENCY_PROBES_MAX	1024
+
+
+typedef struct {
+	unsigned int cpu;
+	long int interval;
+	int prio;
+	pthread_t thread;
+	hist h;
+} latency_probe;
+
+
+static latency_probe *probes[LATENCY_PROBES_MAX];
+static volatile int probes_stop = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_probe_thread
+ * @BRIEF		wakeup latency probe thread.
+ * @param[in]		ptr: pointer to the probe
+ * @DESCRIPTION		wakeup latency probe thread. Like cyclictest, sleep
+ *			until absolute deadlines spaced by the probe interval,
+ *			and record wakeup lateness (in nanoseconds).
+ *//*------------------------------------------------------------------------ */
+static void *latency_probe_thread(void *ptr)
+{
+	latency_probe *p = (latency_probe *) ptr;
+	struct sched_param param;
+	struct timespec next, now;
+	long long lateness;
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(p->cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+	if (p->prio > 0) {
+		param.sched_priority = p->prio;
+		if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+			fprintf(stderr,
+				"cpuloadgen: CPU%u: latency probe SCHED_FIFO priority %d denied (%s)!\n",
+				p->cpu, p->prio, strerror(errno));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!probes_stop) {
+		next.tv_nsec += p->interval * 1000;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		lateness = (long long) (now.tv_sec - next.tv_sec) * 1000000000LL
+			+ (now.tv_nsec - next.tv_nsec);
+		hist_record(&p->h, (lateness > 0) ?
+			(unsigned long long) lateness : 0);
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_probe_start
+ * @BRIEF		start wakeup latency probe on a given CPU core.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID
+ * @param[in]		interval: probe wakeup interval (in microseconds)
+ * @param[in]		prio: probe SCHED_FIFO priority ([1-99]),
+ *				0 to keep default policy
+ * @DESCRIPTION		start wakeup latency probe on a given CPU core.
+ *//*------------------------------------------------------------------------ */
+int latency_probe_start(unsigned int cpu, long int interval, int prio)
+{
+	latency_probe *p;
+	int ret;
+
+	if ((cpu >= LATENCY_PROBES_MAX) || (probes[cpu] != NULL) ||
+		(interval < 1))
+		return -EINVAL;
+
+	p = malloc(sizeof(latency_probe));
+	if (p == NULL)
+		return -ENOMEM;
+	p->cpu = cpu;
+	p->interval = interval;
+	p->prio = prio;
+	hist_init(&p->h);
+
+	probes_stop = 0;
+	ret = pthread_create(&p->thread, NULL, latency_probe_thread, p);
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: CPU%u: failed to start latency probe! (%d)\n",
+			cpu, ret);
+		free(p);
+		return -ret;
+	}
+	probes[cpu] = p;
+	dprintf("%s(): CPU%u probe started (%ldus)\n", __func__, cpu, interval);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_probe_stop
+ * @BRIEF		stop all wakeup latency probes.
+ * @DESCRIPTION		stop all wakeup latency probes, and wait for their
+ *			completion. Recorded histograms remain available
+ *			until latency_report() is called.
+ *//*------------------------------------------------------------------------ */
+void latency_probe_stop(void)
+{
+	unsigned int cpu;
+
+	probes_stop = 1;
+	for (cpu = 0; cpu < LATENCY_PROBES_MAX; cpu++) {
+		if (probes[cpu] != NULL)
+			pthread_join(probes[cpu]->thread, NULL);
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_probe_hist
+ * @BRIEF		return wakeup latency histogram of a given CPU core.
+ * @RETURNS		histogram (in nanoseconds), NULL if no probe
+ * @param[in]		cpu: CPU core ID
+ * @DESCRIPTION		return wakeup latency histogram of a given CPU core.
+ *//*------------------------------------------------------------------------ */
+const hist *latency_probe_hist(unsigned int cpu)
+{
+	if ((cpu >= LATENCY_PROBES_MAX) || (probes[cpu] == NULL))
+		return NULL;
+
+	return &probes[cpu]->h;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_probe_reset
+ * @BRIEF		clear wakeup latency histogram of a given CPU core.
+ * @param[in]		cpu: CPU core ID
+ * @DESCRIPTION		clear wakeup latency histogram of a given CPU core,
+ *			e.g. when load level changes. Samples being recorded
+ *			concurrently by the probe may be lost.
+ *//*------------------------------------------------------------------------ */
+void latency_probe_reset(unsigned int cpu)
+{
+	if ((cpu >= LATENCY_PROBES_MAX) || (probes[cpu] == NULL))
+		return;
+
+	hist_init(&probes[cpu]->h);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		latency_report
+ * @BRIEF		display wakeup latency statistics of a given CPU core.
+ * @param[in]		cpu: CPU core ID
+ * @param[in]		load: load generated on this CPU core
+ * @DESCRIPTION		display wakeup latency statistics of a given CPU core
+ *			(p50/p99/p99.9/max, in microseconds), then release
+ *			its probe.
+ *//*------------------------------------------------------------------------ */
+void latency_report(unsigned int cpu, unsigned int load)
+{
+	const hist *h;
+
+	h = latency_probe_hist(cpu);
+	if (h == NULL)
+		return;
+
+	if (h->count == 0) {
+		printf("CPU%-3u %3u%% %10s\n", cpu, load, "no sample");
+	} else {
+		printf("CPU%-3u %3u%% %10llu %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+			cpu, load, h->count, hist_mean(h) / 1000.0,
+			(double) hist_percentile(h, 50.0) / 1000.0,
+			(double) hist_percentile(h, 99.0) / 1000.0,
+			(double) hist_percentile(h, 99.9) / 1000.0,
+			(double) h->max / 1000.0);
+	}
+
+	free(probes[cpu]);
+	probes[cpu] = NULL;
+}
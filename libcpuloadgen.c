@@ -0,0 +1,621 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			libcpuloadgen.c
+ * @Description			Embeddable load generation engine
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "dist.h"
+#include "tlb.h"
+#include "chunk.h"
+#include "dhrystone.h"
+#include "libcpuloadgen.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define ENGINE_PERIOD_US		100000
+#define ENGINE_CHUNKS_PER_PERIOD	200
+#define ENGINE_CHUNK_US_MIN		10
+#define ENGINE_TLB_FOOTPRINT		(64UL << 20)
+#define ENGINE_DHRYSTONE_VAX_MIPS	1757.0
+
+
+typedef enum {
+	ENGINE_IDLE,
+	ENGINE_RUNNING
+} engine_state;
+
+typedef struct {
+	cpuloadgen_engine *engine;
+	unsigned int idx;
+	cpuloadgen_worker_config config;
+	pthread_t thread;
+	int started;
+	int ret;
+	unsigned int load;
+	unsigned long long iterations;
+	unsigned long long periods;
+	struct timespec ts_start;
+	struct timespec ts_end;
+	long long busy_ns;
+} engine_worker;
+
+struct cpuloadgen_engine {
+	engine_state state;
+	int stop;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	cpuloadgen_hooks hooks;
+	unsigned int count;
+	unsigned int size;
+	engine_worker **workers;
+};
+
+
+static const char *kernel_names[CPULOADGEN_KERNELS_COUNT] = {
+	"dhrystone",
+	"tlb",
+	"dhrystone-power"
+};
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		timespec_ns
+ * @BRIEF		convert timespec into nanoseconds.
+ * @RETURNS		time (in nanoseconds)
+ * @param[in]		ts: time
+ * @DESCRIPTION		convert timespec into nanoseconds.
+ *//*------------------------------------------------------------------------ */
+static long long timespec_ns(const struct timespec *ts)
+{
+	return (long long) ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		timespec_add_ns
+ * @BRIEF		add nanoseconds to a timespec.
+ * @param[in, out]	ts: time
+ * @param[in]		ns: nanoseconds to add
+ * @DESCRIPTION		add nanoseconds to a timespec.
+ *//*------------------------------------------------------------------------ */
+static void timespec_add_ns(struct timespec *ts, long long ns)
+{
+	ns += ts->tv_nsec;
+	ts->tv_sec += ns / 1000000000LL;
+	ts->tv_nsec = ns % 1000000000LL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_sleep
+ * @BRIEF		sleep until an absolute time, or engine stop.
+ * @param[in, out]	e: load engine
+ * @param[in]		ts: end of sleep (CLOCK_MONOTONIC)
+ * @DESCRIPTION		sleep until an absolute time, unless engine is stopped
+ *			meanwhile, so that stop does not wait for sleeping
+ *			workers.
+ *//*------------------------------------------------------------------------ */
+static void engine_sleep(cpuloadgen_engine *e, const struct timespec *ts)
+{
+	pthread_mutex_lock(&e->lock);
+	while ((!e->stop) &&
+		(pthread_cond_timedwait(&e->wake, &e->lock, ts) != ETIMEDOUT))
+		;
+	pthread_mutex_unlock(&e->lock);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		engine_worker_thread
+ * @BRIEF		generate load of one engine worker.
+ * @RETURNS		NULL
+ * @param[in, out]	arg: engine worker
+ * @DESCRIPTION		generate load of one engine worker: every period,
+ *			run kernel chunks for load% of the period, then sleep
+ *			until the absolute start of the next period.
+ *			Chunks are sized adaptively to a fraction of the
+ *			period (at most CHUNK_TARGET_US).
+ *			Load setpoint is read at the start of each period
+ *			(after period hook), and stop request is checked after
+ *			every chunk, so that worker stops within one chunk.
+ *//*------------------------------------------------------------------------ */
+static void *engine_worker_thread(void *arg)
+{
+	engine_worker *w = (engine_worker *) arg;
+	cpuloadgen_engine *e = w->engine;
+	struct timespec ts_period, ts_cpu;
+	uint64_t period_ns, busy_end_ns, now_ns;
+	unsigned int load, n, chunk_us;
+	chunk_sizer chunk;
+	rng_state rng;
+
+	/* Placement set by hook applies to kernel buffer first touch */
+	if (e->hooks.start != NULL)
+		e->hooks.start(w->idx, e->hooks.arg);
+
+	if (w->config.kernel == CPULOADGEN_KERNEL_TLB) {
+		rng_seed(&rng, (w->config.seed != 0) ? w->config.seed :
+			(uint64_t) timespec_ns(&w->ts_start), w->idx);
+		/* Same order as tlb_pages */
+		w->ret = tlb_thread_init(w->config.tlb_footprint,
+			(tlb_pages) w->config.tlb_pages, &rng);
+		if (w->ret != 0) {
+			clock_gettime(CLOCK_MONOTONIC, &w->ts_end);
+			if (e->hooks.stop != NULL)
+				e->hooks.stop(w->idx, e->hooks.arg);
+			return NULL;
+		}
+	}
+
+	if (w->config.kernel == CPULOADGEN_KERNEL_DHRYSTONE_POWER)
+		dhry_variant_set(DHRY_POWER);
+	else
+		dhry_variant_set(DHRY_FAITHFUL);
+
+	/* Busy phase end overshoot is bounded by chunk duration */
+	chunk_us = w->config.period_us / ENGINE_CHUNKS_PER_PERIOD;
+	if (chunk_us > CHUNK_TARGET_US)
+		chunk_us = CHUNK_TARGET_US;
+	else if (chunk_us < ENGINE_CHUNK_US_MIN)
+		chunk_us = ENGINE_CHUNK_US_MIN;
+	chunk_init(&chunk, chunk_us);
+
+	period_ns = (uint64_t) w->config.period_us * 1000ULL;
+	clock_gettime(CLOCK_MONOTONIC, &ts_period);
+	while (!__atomic_load_n(&e->stop, __ATOMIC_RELAXED)) {
+		if ((e->hooks.period != NULL) &&
+			(e->hooks.period(w->idx, &ts_period, e->hooks.arg)))
+			clock_gettime(CLOCK_MONOTONIC, &ts_period);
+		load = __atomic_load_n(&w->load, __ATOMIC_RELAXED);
+		busy_end_ns = (uint64_t) timespec_ns(&ts_period) +
+			(period_ns * load) / 100;
+		/* Do not time idle phase as part of first chunk */
+		now_ns = chunk_clock_ns();
+		chunk.last_ns = now_ns;
+		while ((now_ns < busy_end_ns) &&
+			(!__atomic_load_n(&e->stop, __ATOMIC_RELAXED))) {
+			n = chunk.size;
+			if (w->config.kernel == CPULOADGEN_KERNEL_TLB)
+				tlb_chase(n);
+			else
+				dhryStone(n);
+			__atomic_fetch_add(&w->iterations, n,
+				__ATOMIC_RELAXED);
+			now_ns = chunk_update(&chunk);
+		}
+
+		timespec_add_ns(&ts_period, period_ns);
+		if (load < 100)
+			engine_sleep(e, &ts_period);
+		/* Do not try to catch up with periods lost while preempted */
+		if (now_ns > (uint64_t) timespec_ns(&ts_period) + period_ns) {
+			ts_period.tv_sec = now_ns / 1000000000ULL;
+			ts_period.tv_nsec = now_ns % 1000000000ULL;
+		}
+		__atomic_fetch_add(&w->periods, 1, __ATOMIC_RELAXED);
+	}
+
+	if (w->config.kernel == CPULOADGEN_KERNEL_TLB)
+		tlb_thread_deinit();
+	else
+		dhryStone_release();
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_cpu);
+	__atomic_store_n(&w->busy_ns, timespec_ns(&ts_cpu), __ATOMIC_RELAXED);
+	clock_gettime(CLOCK_MONOTONIC, &w->ts_end);
+	dprintf("%s(): worker %u stopped after %llu periods\n", __func__,
+		w->idx, w->periods);
+	if (e->hooks.stop != NULL)
+		e->hooks.stop(w->idx, e->hooks.arg);
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_create
+ * @BRIEF		create a load engine.
+ * @RETURNS		load engine
+ *			NULL in case of failure (errno set)
+ * @DESCRIPTION		create a load engine, with no worker.
+ *//*------------------------------------------------------------------------ */
+cpuloadgen_engine *cpuloadgen_create(void)
+{
+	cpuloadgen_engine *engine;
+	pthread_condattr_t attr;
+
+	engine = calloc(1, sizeof(cpuloadgen_engine));
+	if (engine == NULL)
+		return NULL;
+
+	/* Workers sleep until absolute CLOCK_MONOTONIC times */
+	pthread_mutex_init(&engine->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&engine->wake, &attr);
+	pthread_condattr_destroy(&attr);
+
+	return engine;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_add_worker
+ * @BRIEF		add a worker to a load engine.
+ * @RETURNS		worker index (>= 0) on success
+ *			-EINVAL in case of invalid argument
+ *			-EBUSY if engine is running
+ *			-ENOMEM in case of memory allocation failure
+ * @param[in, out]	engine: load engine
+ * @param[in]		config: worker configuration
+ * @DESCRIPTION		add a worker to a stopped load engine. Worker index
+ *			is used to update and read worker afterwards.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_add_worker(cpuloadgen_engine *engine,
+	const cpuloadgen_worker_config *config)
+{
+	engine_worker **workers;
+	engine_worker *w;
+	unsigned int size;
+
+	if ((engine == NULL) || (config == NULL) || (config->load > 100) ||
+		(config->cpu < -1) || (config->cpu >= CPU_SETSIZE) ||
+		(config->kernel < 0) ||
+		(config->kernel >= CPULOADGEN_KERNELS_COUNT) ||
+		(config->tlb_pages < 0) ||
+		(config->tlb_pages >= CPULOADGEN_TLB_PAGES_COUNT))
+		return -EINVAL;
+	if (engine->state != ENGINE_IDLE)
+		return -EBUSY;
+
+	if (engine->count == engine->size) {
+		size = (engine->size == 0) ? 8 : 2 * engine->size;
+		workers = realloc(engine->workers,
+			size * sizeof(engine_worker *));
+		if (workers == NULL)
+			return -ENOMEM;
+		engine->workers = workers;
+		engine->size = size;
+	}
+	/* Separately allocated, so that worker counters do not share lines */
+	if (posix_memalign((void **) &w, 64, sizeof(engine_worker)) != 0)
+		return -ENOMEM;
+	memset(w, 0, sizeof(engine_worker));
+	w->engine = engine;
+	w->idx = engine->count;
+	w->config = *config;
+	if (w->config.period_us == 0)
+		w->config.period_us = ENGINE_PERIOD_US;
+	if (w->config.tlb_footprint == 0)
+		w->config.tlb_footprint = ENGINE_TLB_FOOTPRINT;
+	w->load = config->load;
+	engine->workers[engine->count] = w;
+
+	return engine->count++;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_set_hooks
+ * @BRIEF		set worker thread hooks of a load engine.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ *			-EBUSY if engine is running
+ * @param[in, out]	engine: load engine
+ * @param[in]		hooks: worker thread hooks, NULL for none
+ * @DESCRIPTION		set hooks called by all workers of a stopped load
+ *			engine, from their own thread.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_set_hooks(cpuloadgen_engine *engine,
+	const cpuloadgen_hooks *hooks)
+{
+	if (engine == NULL)
+		return -EINVAL;
+	if (engine->state != ENGINE_IDLE)
+		return -EBUSY;
+
+	if (hooks != NULL)
+		engine->hooks = *hooks;
+	else
+		memset(&engine->hooks, 0, sizeof(cpuloadgen_hooks));
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_start
+ * @BRIEF		start all workers of a load engine.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument or worker CPU
+ *			-EBUSY if engine is already running
+ *			-errno in case of thread creation failure
+ * @param[in, out]	engine: load engine
+ * @DESCRIPTION		start all workers of a load engine, pinned to their
+ *			CPU core from creation. Worker statistics are reset.
+ *			In case of failure, workers already started are
+ *			stopped.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_start(cpuloadgen_engine *engine)
+{
+	pthread_attr_t attr;
+	cpu_set_t set;
+	engine_worker *w;
+	unsigned int i;
+	int ret = 0;
+
+	if (engine == NULL)
+		return -EINVAL;
+	if (engine->state != ENGINE_IDLE)
+		return -EBUSY;
+
+	engine->stop = 0;
+	engine->state = ENGINE_RUNNING;
+	for (i = 0; i < engine->count; i++) {
+		w = engine->workers[i];
+		w->started = 0;
+		w->ret = 0;
+		w->iterations = 0;
+		w->periods = 0;
+		w->busy_ns = 0;
+		clock_gettime(CLOCK_MONOTONIC, &w->ts_start);
+
+		pthread_attr_init(&attr);
+		if (w->config.cpu != -1) {
+			CPU_ZERO(&set);
+			CPU_SET(w->config.cpu, &set);
+			pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+		}
+		ret = -pthread_create(&w->thread, &attr, engine_worker_thread,
+			w);
+		pthread_attr_destroy(&attr);
+		if (ret != 0)
+			break;
+		w->started = 1;
+	}
+	if (ret != 0)
+		cpuloadgen_stop(engine);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_set_load
+ * @BRIEF		update worker load setpoint.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ * @param[in, out]	engine: load engine
+ * @param[in]		worker: worker index, -1 for all workers
+ * @param[in]		load: new load setpoint (0 to 100%)
+ * @DESCRIPTION		update worker load setpoint. May be called while
+ *			engine is running: new setpoint applies from the next
+ *			worker period.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_set_load(cpuloadgen_engine *engine, int worker,
+	unsigned int load)
+{
+	unsigned int i;
+
+	if ((engine == NULL) || (load > 100) || (worker < -1) ||
+		(worker >= (int) engine->count))
+		return -EINVAL;
+
+	for (i = 0; i < engine->count; i++) {
+		if ((worker == -1) || (worker == (int) i))
+			__atomic_store_n(&engine->workers[i]->load, load,
+				__ATOMIC_RELAXED);
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_get_stats
+ * @BRIEF		read worker statistics.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ *			-errno worker failure code
+ * @param[in]		engine: load engine
+ * @param[in]		worker: worker index
+ * @param[out]		stats: worker statistics
+ * @DESCRIPTION		read worker statistics, either live (engine running)
+ *			or final (engine stopped). Busy time is the worker
+ *			thread CPU time, so that achieved load accounts for
+ *			preemption by other tasks.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_get_stats(cpuloadgen_engine *engine, int worker,
+	cpuloadgen_stats *stats)
+{
+	struct timespec ts_now, ts_cpu;
+	clockid_t clk;
+	engine_worker *w;
+	long long busy_ns;
+
+	if ((engine == NULL) || (stats == NULL) || (worker < 0) ||
+		(worker >= (int) engine->count))
+		return -EINVAL;
+	w = engine->workers[worker];
+
+	memset(stats, 0, sizeof(cpuloadgen_stats));
+	stats->load = __atomic_load_n(&w->load, __ATOMIC_RELAXED);
+	if (!w->started)
+		return w->ret;
+
+	busy_ns = __atomic_load_n(&w->busy_ns, __ATOMIC_RELAXED);
+	if (engine->state == ENGINE_RUNNING) {
+		clock_gettime(CLOCK_MONOTONIC, &ts_now);
+		if ((busy_ns == 0) &&
+			(pthread_getcpuclockid(w->thread, &clk) == 0) &&
+			(clock_gettime(clk, &ts_cpu) == 0))
+			busy_ns = timespec_ns(&ts_cpu);
+	} else {
+		ts_now = w->ts_end;
+	}
+	stats->elapsed_s = (double) (timespec_ns(&ts_now) -
+		timespec_ns(&w->ts_start)) / 1.0e9;
+	stats->busy_s = (double) busy_ns / 1.0e9;
+	if (stats->elapsed_s > 0.0)
+		stats->achieved = 100.0 * stats->busy_s / stats->elapsed_s;
+	stats->iterations = __atomic_load_n(&w->iterations, __ATOMIC_RELAXED);
+	stats->periods = __atomic_load_n(&w->periods, __ATOMIC_RELAXED);
+	if ((w->config.kernel != CPULOADGEN_KERNEL_TLB) &&
+		(stats->elapsed_s > 0.0))
+		stats->dmips = (double) stats->iterations / stats->elapsed_s /
+			ENGINE_DHRYSTONE_VAX_MIPS;
+
+	return __atomic_load_n(&w->ret, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_stop
+ * @BRIEF		stop all workers of a load engine.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ *			first worker failure code otherwise
+ * @param[in, out]	engine: load engine
+ * @DESCRIPTION		stop all workers of a load engine, waking up sleeping
+ *			ones, and wait (at most one chunk) for them to
+ *			complete. Statistics remain available, and engine may
+ *			be started again.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_stop(cpuloadgen_engine *engine)
+{
+	engine_worker *w;
+	unsigned int i;
+	int ret = 0;
+
+	if (engine == NULL)
+		return -EINVAL;
+	if (engine->state != ENGINE_RUNNING)
+		return 0;
+
+	pthread_mutex_lock(&engine->lock);
+	__atomic_store_n(&engine->stop, 1, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&engine->wake);
+	pthread_mutex_unlock(&engine->lock);
+	for (i = 0; i < engine->count; i++) {
+		w = engine->workers[i];
+		if (!w->started)
+			continue;
+		pthread_join(w->thread, NULL);
+		if ((ret == 0) && (w->ret != 0))
+			ret = w->ret;
+	}
+	engine->state = ENGINE_IDLE;
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_destroy
+ * @BRIEF		destroy a load engine.
+ * @param[in, out]	engine: load engine
+ * @DESCRIPTION		stop load engine if running, and release it.
+ *//*------------------------------------------------------------------------ */
+void cpuloadgen_destroy(cpuloadgen_engine *engine)
+{
+	unsigned int i;
+
+	if (engine == NULL)
+		return;
+
+	cpuloadgen_stop(engine);
+	for (i = 0; i < engine->count; i++)
+		free(engine->workers[i]);
+	free(engine->workers);
+	pthread_cond_destroy(&engine->wake);
+	pthread_mutex_destroy(&engine->lock);
+	free(engine);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_kernel_parse
+ * @BRIEF		convert kernel name into kernel.
+ * @RETURNS		kernel
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: kernel name
+ * @DESCRIPTION		convert kernel name into kernel.
+ *//*------------------------------------------------------------------------ */
+int cpuloadgen_kernel_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < CPULOADGEN_KERNELS_COUNT; i++) {
+		if (strcmp(name, kernel_names[i]) == 0)
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpuloadgen_kernel_name
+ * @BRIEF		return kernel name.
+ * @RETURNS		kernel name
+ * @param[in]		kernel: kernel
+ * @DESCRIPTION		return kernel name.
+ *//*------------------------------------------------------------------------ */
+const char *cpuloadgen_kernel_name(cpuloadgen_kernel kernel)
+{
+	if ((kernel < 0) || (kernel >= CPULOADGEN_KERNELS_COUNT))
+		return "unknown";
+	return kernel_names[kernel];
+}
@@ -0,0 +1,142 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			libcpuloadgen.h
+ * @Description			Embeddable load generation engine API
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __LIBCPULOADGEN_H__
+#define __LIBCPULOADGEN_H__
+
+
+#include <stddef.h>
+#include <time.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Only API is exported by the shared library */
+#define CPULOADGEN_API __attribute__((visibility("default")))
+
+
+/*
+ * Load engine: a set of per-core workers, each generating a PWM-style load
+ * (busy for load% of every period, idle for the rest).
+ * Engines hold no shared state: several engines may coexist in a process.
+ * Engine calls are not reentrant on the same engine, except
+ * cpuloadgen_set_load() and cpuloadgen_get_stats() that may be called from
+ * any thread while the engine is running.
+ */
+typedef struct cpuloadgen_engine cpuloadgen_engine;
+
+typedef enum {
+	CPULOADGEN_KERNEL_DHRYSTONE,		/* faithful Dhrystone */
+	CPULOADGEN_KERNEL_TLB,			/* dTLB pointer chasing */
+	CPULOADGEN_KERNEL_DHRYSTONE_POWER,	/* maximum power Dhrystone */
+	CPULOADGEN_KERNELS_COUNT
+} cpuloadgen_kernel;
+
+typedef enum {
+	CPULOADGEN_TLB_4K,			/* regular pages */
+	CPULOADGEN_TLB_THP,			/* transparent huge pages */
+	CPULOADGEN_TLB_HUGETLB,			/* reserved huge pages */
+	CPULOADGEN_TLB_PAGES_COUNT
+} cpuloadgen_tlb_pages;
+
+typedef struct {
+	int cpu;			/* CPU core to pin worker to, -1: none */
+	cpuloadgen_kernel kernel;	/* busy phase kernel */
+	unsigned int load;		/* load setpoint, 0 to 100 (%) */
+	unsigned int period_us;		/* PWM period (us), 0: default */
+	size_t tlb_footprint;		/* TLB kernel buffer (bytes), 0: default */
+	cpuloadgen_tlb_pages tlb_pages;	/* TLB kernel buffer pages */
+	unsigned long long seed;	/* TLB kernel chain seed, 0: time */
+} cpuloadgen_worker_config;
+
+/*
+ * Optional hooks, called from each worker thread (any may be NULL):
+ * start before the kernel is set up (e.g. to apply a scheduling policy),
+ * period at the start of each period, given its scheduled start time
+ * (returning non-zero restarts period timing from now, e.g. after the
+ * thread was parked), and stop once the worker stopped.
+ */
+typedef struct {
+	void (*start)(int worker, void *arg);
+	int (*period)(int worker, const struct timespec *start, void *arg);
+	void (*stop)(int worker, void *arg);
+	void *arg;
+} cpuloadgen_hooks;
+
+typedef struct {
+	unsigned int load;		/* current load setpoint (%) */
+	double elapsed_s;		/* time since worker start (s) */
+	double busy_s;			/* worker thread CPU time (s) */
+	double achieved;		/* achieved load, busy vs elapsed (%) */
+	unsigned long long iterations;	/* kernel iterations */
+	unsigned long long periods;	/* completed PWM periods */
+	double dmips;			/* Dhrystone MIPS, 0 for other kernels */
+} cpuloadgen_stats;
+
+
+CPULOADGEN_API cpuloadgen_engine *cpuloadgen_create(void);
+CPULOADGEN_API int cpuloadgen_add_worker(cpuloadgen_engine *engine,
+	const cpuloadgen_worker_config *config);
+CPULOADGEN_API int cpuloadgen_set_hooks(cpuloadgen_engine *engine,
+	const cpuloadgen_hooks *hooks);
+CPULOADGEN_API int cpuloadgen_start(cpuloadgen_engine *engine);
+CPULOADGEN_API int cpuloadgen_set_load(cpuloadgen_engine *engine, int worker,
+	unsigned int load);
+CPULOADGEN_API int cpuloadgen_get_stats(cpuloadgen_engine *engine, int worker,
+	cpuloadgen_stats *stats);
+CPULOADGEN_API int cpuloadgen_stop(cpuloadgen_engine *engine);
+CPULOADGEN_API void cpuloadgen_destroy(cpuloadgen_engine *engine);
+CPULOADGEN_API int cpuloadgen_kernel_parse(const char *name);
+CPULOADGEN_API const char *cpuloadgen_kernel_name(cpuloadgen_kernel kernel);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			lock.c
+ * @Description			Lock contention primitives
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "lock.h"
+#include "idle.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define LOCK_NAME_MAX		16
+#define DEFAULT_WRITE_PCT	10
+
+
+static const char *lock_names[LOCK_TYPES_COUNT] = {
+	"mutex",
+	"spin",
+	"ticket",
+	"mcs",
+	"rwlock",
+	"atomic"
+};
+
+static lock_type type = LOCK_MUTEX;
+static pthread_mutex_t mutex;
+static pthread_spinlock_t spin;
+static pthread_rwlock_t rwlock;
+/* Ticket lock, MCS lock tail and atomic counter share a single line */
+static struct {
+	volatile unsigned int next_ticket;
+	volatile unsigned int now_serving;
+	lock_node *volatile tail;
+	volatile unsigned long long counter;
+} shared __attribute__((aligned(LOCK_CACHE_LINE)));
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_parse
+ * @BRIEF		parse lock primitive argument.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid argument
+ * @param[in]		arg: "name[:write_pct]" string
+ * @param[out]		type: lock primitive
+ * @param[out]		write_pct: share of write acquisitions (rwlock only,
+ *				in %, 100 for other primitives)
+ * @DESCRIPTION		parse lock primitive argument.
+ *//*------------------------------------------------------------------------ */
+int lock_parse(const char *arg, lock_type *type, int *write_pct)
+{
+	char name[LOCK_NAME_MAX];
+	const char *sep;
+	size_t len;
+	int i;
+
+	sep = strchr(arg, ':');
+	len = (sep != NULL) ? (size_t) (sep - arg) : strlen(arg);
+	if ((len == 0) || (len >= LOCK_NAME_MAX))
+		return -EINVAL;
+	memcpy(name, arg, len);
+	name[len] = '\0';
+
+	for (i = 0; i < LOCK_TYPES_COUNT; i++) {
+		if (strcmp(name, lock_names[i]) == 0)
+			break;
+	}
+	if (i == LOCK_TYPES_COUNT)
+		return -EINVAL;
+	*type = (lock_type) i;
+	*write_pct = (*type == LOCK_RWLOCK) ? DEFAULT_WRITE_PCT : 100;
+
+	if (sep != NULL) {
+		if ((*type != LOCK_RWLOCK) ||
+			(sscanf(sep + 1, "%d", write_pct) != 1) ||
+			(*write_pct < 0) || (*write_pct > 100))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_name
+ * @BRIEF		return lock primitive name.
+ * @RETURNS		lock primitive name
+ * @param[in]		type: lock primitive
+ * @DESCRIPTION		return lock primitive name.
+ *//*------------------------------------------------------------------------ */
+const char *lock_name(lock_type type)
+{
+	if ((type < 0) || (type >= LOCK_TYPES_COUNT))
+		return "unknown";
+	return lock_names[type];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_init
+ * @BRIEF		initialise the shared lock.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		t: lock primitive
+ * @DESCRIPTION		initialise the shared lock, contended by all load
+ *			threads.
+ *//*------------------------------------------------------------------------ */
+int lock_init(lock_type t)
+{
+	int ret = 0;
+
+	type = t;
+	memset((void *) &shared, 0, sizeof(shared));
+	switch (type) {
+	case LOCK_MUTEX:
+		ret = pthread_mutex_init(&mutex, NULL);
+		break;
+	case LOCK_SPIN:
+		ret = pthread_spin_init(&spin, PTHREAD_PROCESS_PRIVATE);
+		break;
+	case LOCK_RWLOCK:
+		ret = pthread_rwlock_init(&rwlock, NULL);
+		break;
+	default:
+		break;
+	}
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: could not initialise %s lock (%s)!\n",
+			lock_names[type], strerror(ret));
+		return -ret;
+	}
+	dprintf("%s(): %s lock initialised\n", __func__, lock_names[type]);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_deinit
+ * @BRIEF		release the shared lock.
+ * @DESCRIPTION		release the shared lock.
+ *//*------------------------------------------------------------------------ */
+void lock_deinit(void)
+{
+	switch (type) {
+	case LOCK_MUTEX:
+		pthread_mutex_destroy(&mutex);
+		break;
+	case LOCK_SPIN:
+		pthread_spin_destroy(&spin);
+		break;
+	case LOCK_RWLOCK:
+		pthread_rwlock_destroy(&rwlock);
+		break;
+	default:
+		break;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_enter
+ * @BRIEF		acquire the shared lock.
+ * @param[in, out]	node: calling thread lock context
+ * @param[in]		write: rwlock only: acquire for writing if != 0
+ * @DESCRIPTION		acquire the shared lock, and update the shared
+ *			counter (moving its cache line to this core). With
+ *			atomic primitive, only do a fetch-and-add on the
+ *			counter.
+ *//*------------------------------------------------------------------------ */
+void lock_enter(lock_node *node, int write)
+{
+	lock_node *pred;
+	unsigned int ticket;
+
+	switch (type) {
+	case LOCK_MUTEX:
+		pthread_mutex_lock(&mutex);
+		break;
+	case LOCK_SPIN:
+		pthread_spin_lock(&spin);
+		break;
+	case LOCK_TICKET:
+		ticket = __atomic_fetch_add(&shared.next_ticket, 1,
+			__ATOMIC_RELAXED);
+		while (__atomic_load_n(&shared.now_serving,
+			__ATOMIC_ACQUIRE) != ticket)
+			cpu_relax();
+		break;
+	case LOCK_MCS:
+		node->next = NULL;
+		node->locked = 1;
+		pred = __atomic_exchange_n(&shared.tail, node,
+			__ATOMIC_ACQ_REL);
+		if (pred != NULL) {
+			__atomic_store_n(&pred->next, node, __ATOMIC_RELEASE);
+			while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE))
+				cpu_relax();
+		}
+		break;
+	case LOCK_RWLOCK:
+		if (write)
+			pthread_rwlock_wrlock(&rwlock);
+		else
+			pthread_rwlock_rdlock(&rwlock);
+		break;
+	case LOCK_ATOMIC:
+	default:
+		__atomic_fetch_add(&shared.counter, 1, __ATOMIC_SEQ_CST);
+		return;
+	}
+
+	/* Readers must not write the shared counter */
+	if ((type != LOCK_RWLOCK) || (write))
+		shared.counter++;
+	else
+		(void) shared.counter;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		lock_exit
+ * @BRIEF		release the shared lock.
+ * @param[in, out]	node: calling thread lock context
+ * @param[in]		write: rwlock only: was acquired for writing if != 0
+ * @DESCRIPTION		release the shared lock.
+ *//*------------------------------------------------------------------------ */
+void lock_exit(lock_node *node, int write)
+{
+	lock_node *next, *expected;
+
+	(void) write;
+	switch (type) {
+	case LOCK_MUTEX:
+		pthread_mutex_unlock(&mutex);
+		break;
+	case LOCK_SPIN:
+		pthread_spin_unlock(&spin);
+		break;
+	case LOCK_TICKET:
+		__atomic_store_n(&shared.now_serving, shared.now_serving + 1,
+			__ATOMIC_RELEASE);
+		break;
+	case LOCK_MCS:
+		next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+		if (next == NULL) {
+			expected = node;
+			if (__atomic_compare_exchange_n(&shared.tail, &expected,
+				NULL, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+				return;
+			/* A successor is enqueuing itself: wait for it */
+			while ((next = __atomic_load_n(&node->next,
+				__ATOMIC_ACQUIRE)) == NULL)
+				cpu_relax();
+		}
+		__atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+		break;
+	case LOCK_RWLOCK:
+		pthread_rwlock_unlock(&rwlock);
+		break;
+	case LOCK_ATOMIC:
+	default:
+		break;
+	}
+}
@@ -0,0 +1,78 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			lock.h
+ * @Description			Lock contention primitives
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_LOCK_H__
+#define __CPULOADGEN_LOCK_H__
+
+
+#define LOCK_CACHE_LINE		64
+
+
+typedef enum {
+	LOCK_MUTEX,
+	LOCK_SPIN,
+	LOCK_TICKET,
+	LOCK_MCS,
+	LOCK_RWLOCK,
+	LOCK_ATOMIC,
+	LOCK_TYPES_COUNT
+} lock_type;
+
+/* Per-thread lock context (MCS queue node) */
+typedef struct lock_node {
+	struct lock_node *volatile next;
+	volatile int locked;
+	char pad[LOCK_CACHE_LINE - sizeof(void *) - sizeof(int)];
+} lock_node;
+
+
+int lock_parse(const char *arg, lock_type *type, int *write_pct);
+const char *lock_name(lock_type type);
+int lock_init(lock_type type);
+void lock_deinit(void);
+void lock_enter(lock_node *node, int write);
+void lock_exit(lock_node *node, int write);
+
+
+#endif
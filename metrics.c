@@ -0,0 +1,623 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			metrics.c
+ * @Description			OpenMetrics exposition endpoint
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define METRICS_REQUEST_MAX	2048
+#define METRICS_POLL_MS		200
+#define METRICS_FAMILIES	8
+#define METRICS_TIMEOUT_S	2
+#define METRICS_CONTENT_TYPE	\
+	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+
+static const double overshoot_bounds_us[METRICS_OVERSHOOT_BUCKETS - 1] = {
+	10.0, 50.0, 100.0, 500.0, 1000.0, 5000.0, 10000.0
+};
+
+static metrics_worker *workers = NULL;
+static unsigned int workers_count = 0;
+static int listen_fd = -1;
+static char *unix_path = NULL;
+static pthread_t server;
+static volatile int server_stop = 0;
+static int server_running = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_worker_get
+ * @BRIEF		return live counters of a load thread.
+ * @RETURNS		live counters, NULL if metrics disabled
+ * @param[in]		idx: load thread index
+ * @DESCRIPTION		return live counters of a load thread.
+ *//*------------------------------------------------------------------------ */
+metrics_worker *metrics_worker_get(unsigned int idx)
+{
+	if ((workers == NULL) || (idx >= workers_count))
+		return NULL;
+
+	return &workers[idx];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_worker_begin
+ * @BRIEF		account start of a load thread run.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @param[in]		cpu: CPU core of load thread
+ * @param[in]		setpoint: requested load
+ * @DESCRIPTION		account start of a load thread run (called by load
+ *			thread itself): its CPU time is then read live.
+ *//*------------------------------------------------------------------------ */
+void metrics_worker_begin(metrics_worker *w, unsigned int cpu,
+	unsigned int setpoint)
+{
+	clockid_t clock;
+
+	if (w == NULL)
+		return;
+	if (pthread_getcpuclockid(pthread_self(), &clock) != 0)
+		return;
+
+	__atomic_store_n(&w->seq, w->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	w->clock = clock;
+	__atomic_store_n(&w->active, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&w->seq, w->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&w->cpu, (int) cpu, __ATOMIC_RELAXED);
+	__atomic_store_n(&w->setpoint, (int) setpoint, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_worker_end
+ * @BRIEF		account end of a load thread run.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @DESCRIPTION		account end of a load thread run (called by load
+ *			thread itself): its CPU time is added to completed
+ *			runs one, in a single seqlock-protected update so that
+ *			busy time never goes backwards for readers.
+ *//*------------------------------------------------------------------------ */
+void metrics_worker_end(metrics_worker *w)
+{
+	struct timespec ts;
+
+	if ((w == NULL) || (!w->active))
+		return;
+	clock_gettime(w->clock, &ts);
+
+	__atomic_store_n(&w->seq, w->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&w->busy_ns, w->busy_ns +
+		(unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec,
+		__ATOMIC_RELAXED);
+	__atomic_store_n(&w->active, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&w->seq, w->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&w->setpoint, -1, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_overshoot
+ * @BRIEF		account sleep overshoot.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @param[in]		deadline: end of idle phase (CLOCK_MONOTONIC)
+ * @DESCRIPTION		account sleep overshoot: how late idle phase ended
+ *			(now) compared to its deadline.
+ *//*------------------------------------------------------------------------ */
+void metrics_overshoot(metrics_worker *w, const struct timespec *deadline)
+{
+	struct timespec now;
+	long long ns;
+	unsigned int i;
+
+	if (w == NULL)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (long long) (now.tv_sec - deadline->tv_sec) * 1000000000LL +
+		(now.tv_nsec - deadline->tv_nsec);
+	if (ns < 0)
+		ns = 0;
+
+	for (i = 0; i < METRICS_OVERSHOOT_BUCKETS - 1; i++) {
+		if ((double) ns <= overshoot_bounds_us[i] * 1000.0)
+			break;
+	}
+	metrics_count(&w->overshoot[i], 1);
+	metrics_count(&w->overshoot_ns, (unsigned long long) ns);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_error
+ * @BRIEF		account a load thread error.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @DESCRIPTION		account a load thread error (e.g. scheduling setup or
+ *			kernel initialisation failure).
+ *//*------------------------------------------------------------------------ */
+void metrics_error(metrics_worker *w)
+{
+	if (w != NULL)
+		metrics_count(&w->errors, 1);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_worker_busy_s
+ * @BRIEF		read CPU time of a load thread.
+ * @RETURNS		CPU time of all runs of load thread, in seconds
+ * @param[in]		w: live counters
+ * @DESCRIPTION		read CPU time of all runs of load thread (completed
+ *			ones, and current one if running), retrying if a run
+ *			starts or ends meanwhile.
+ *//*------------------------------------------------------------------------ */
+double metrics_worker_busy_s(metrics_worker *w)
+{
+	unsigned long long busy_ns;
+	struct timespec ts;
+	unsigned int seq;
+	int active;
+	clockid_t clock;
+
+	do {
+		seq = __atomic_load_n(&w->seq, __ATOMIC_ACQUIRE);
+		busy_ns = __atomic_load_n(&w->busy_ns, __ATOMIC_RELAXED);
+		active = __atomic_load_n(&w->active, __ATOMIC_RELAXED);
+		clock = w->clock;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (((seq & 1) != 0) ||
+		(seq != __atomic_load_n(&w->seq, __ATOMIC_RELAXED)));
+
+	/* Thread may have just exited: its clock is then invalid */
+	if ((active) && (clock_gettime(clock, &ts) == 0))
+		busy_ns += (unsigned long long) ts.tv_sec * 1000000000ULL +
+			ts.tv_nsec;
+
+	return (double) busy_ns * 1.0e-9;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_family
+ * @BRIEF		write metric family metadata.
+ * @param[in]		fp: output stream
+ * @param[in]		name: metric family name
+ * @param[in]		type: metric family type
+ * @param[in]		unit: metric family unit (NULL if none)
+ * @param[in]		help: metric family description
+ * @DESCRIPTION		write metric family metadata.
+ *//*------------------------------------------------------------------------ */
+static void metrics_family(FILE *fp, const char *name, const char *type,
+	const char *unit, const char *help)
+{
+	fprintf(fp, "# TYPE %s %s\n", name, type);
+	if (unit != NULL)
+		fprintf(fp, "# UNIT %s %s\n", name, unit);
+	fprintf(fp, "# HELP %s %s\n", name, help);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_write
+ * @BRIEF		write all metrics.
+ * @param[in]		fp: output stream
+ * @DESCRIPTION		write all metrics of started load threads, in
+ *			OpenMetrics text format (samples grouped by family).
+ *//*------------------------------------------------------------------------ */
+static void metrics_write(FILE *fp)
+{
+	unsigned long long n, cumul, counts[METRICS_OVERSHOOT_BUCKETS];
+	metrics_worker *w;
+	unsigned int i, j, f;
+	int cpu;
+
+	for (f = 0; f < METRICS_FAMILIES; f++) {
+		switch (f) {
+		case 0:
+			metrics_family(fp, "cpuloadgen_setpoint_percent",
+				"gauge", NULL,
+				"Requested load of load thread CPU core, -1 if not running.");
+			break;
+		case 1:
+			metrics_family(fp, "cpuloadgen_busy_seconds", "counter",
+				"seconds",
+				"CPU time of load thread (its rate is achieved load).");
+			break;
+		case 2:
+			metrics_family(fp, "cpuloadgen_iterations", "counter",
+				NULL, "Dhrystone iterations of load thread.");
+			break;
+		case 3:
+			metrics_family(fp, "cpuloadgen_errors", "counter", NULL,
+				"Errors of load thread (scheduling, cgroup or kernel setup).");
+			break;
+		case 4:
+			metrics_family(fp, "cpuloadgen_repins", "counter", NULL,
+				"Load thread pinnings restored after CPU hotplug or cpuset change.");
+			break;
+		case 5:
+			metrics_family(fp, "cpuloadgen_parks", "counter", NULL,
+				"Load thread parkings, its CPU core being offline or out of cpuset.");
+			break;
+		case 6:
+			metrics_family(fp, "cpuloadgen_parked_seconds", "counter",
+				"seconds", "Time load thread spent parked.");
+			break;
+		default:
+			metrics_family(fp, "cpuloadgen_sleep_overshoot_seconds",
+				"histogram", "seconds",
+				"Lateness of load thread idle phase end.");
+		}
+
+		for (i = 0; i < workers_count; i++) {
+			w = &workers[i];
+			cpu = __atomic_load_n(&w->cpu, __ATOMIC_RELAXED);
+			if (cpu < 0)
+				continue;
+			switch (f) {
+			case 0:
+				fprintf(fp, "cpuloadgen_setpoint_percent{cpu=\"%d\",thread=\"%u\"} %d\n",
+					cpu, i, __atomic_load_n(&w->setpoint,
+					__ATOMIC_RELAXED));
+				break;
+			case 1:
+				fprintf(fp, "cpuloadgen_busy_seconds_total{cpu=\"%d\",thread=\"%u\"} %.6f\n",
+					cpu, i, metrics_worker_busy_s(w));
+				break;
+			case 2:
+				fprintf(fp, "cpuloadgen_iterations_total{cpu=\"%d\",thread=\"%u\"} %llu\n",
+					cpu, i, __atomic_load_n(&w->iterations,
+					__ATOMIC_RELAXED));
+				break;
+			case 3:
+				fprintf(fp, "cpuloadgen_errors_total{cpu=\"%d\",thread=\"%u\"} %llu\n",
+					cpu, i, __atomic_load_n(&w->errors,
+					__ATOMIC_RELAXED));
+				break;
+			case 4:
+				fprintf(fp, "cpuloadgen_repins_total{cpu=\"%d\",thread=\"%u\"} %llu\n",
+					cpu, i, __atomic_load_n(&w->repins,
+					__ATOMIC_RELAXED));
+				break;
+			case 5:
+				fprintf(fp, "cpuloadgen_parks_total{cpu=\"%d\",thread=\"%u\"} %llu\n",
+					cpu, i, __atomic_load_n(&w->parks,
+					__ATOMIC_RELAXED));
+				break;
+			case 6:
+				fprintf(fp, "cpuloadgen_parked_seconds_total{cpu=\"%d\",thread=\"%u\"} %.6f\n",
+					cpu, i, (double) __atomic_load_n(
+					&w->parked_ns, __ATOMIC_RELAXED) * 1.0e-9);
+				break;
+			default:
+				/* Count is the sum of buckets read, so both match */
+				n = 0;
+				for (j = 0; j < METRICS_OVERSHOOT_BUCKETS; j++) {
+					counts[j] = __atomic_load_n(
+						&w->overshoot[j],
+						__ATOMIC_RELAXED);
+					n += counts[j];
+				}
+				cumul = 0;
+				for (j = 0; j < METRICS_OVERSHOOT_BUCKETS; j++) {
+					cumul += counts[j];
+					fprintf(fp, "cpuloadgen_sleep_overshoot_seconds_bucket{cpu=\"%d\",thread=\"%u\",le=\"",
+						cpu, i);
+					if (j < METRICS_OVERSHOOT_BUCKETS - 1)
+						fprintf(fp, "%g", overshoot_bounds_us[j]
+							* 1.0e-6);
+					else
+						fprintf(fp, "+Inf");
+					fprintf(fp, "\"} %llu\n", cumul);
+				}
+				fprintf(fp, "cpuloadgen_sleep_overshoot_seconds_count{cpu=\"%d\",thread=\"%u\"} %llu\n",
+					cpu, i, n);
+				fprintf(fp, "cpuloadgen_sleep_overshoot_seconds_sum{cpu=\"%d\",thread=\"%u\"} %.9f\n",
+					cpu, i, (double) __atomic_load_n(
+					&w->overshoot_ns, __ATOMIC_RELAXED) *
+					1.0e-9);
+			}
+		}
+	}
+	fprintf(fp, "# EOF\n");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_serve
+ * @BRIEF		serve a scrape request.
+ * @param[in]		fd: client socket
+ * @DESCRIPTION		serve a scrape request: read HTTP request header, and
+ *			reply with all metrics ("/" or "/metrics"), or 404.
+ *//*------------------------------------------------------------------------ */
+static void metrics_serve(int fd)
+{
+	char req[METRICS_REQUEST_MAX], hdr[256], *body = NULL;
+	struct timeval tv = {METRICS_TIMEOUT_S, 0};
+	size_t len = 0, body_len = 0;
+	ssize_t ret;
+	FILE *fp;
+	int hlen;
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	while (len < sizeof(req) - 1) {
+		ret = read(fd, req + len, sizeof(req) - 1 - len);
+		if (ret <= 0)
+			return;
+		len += ret;
+		req[len] = '\0';
+		if (strstr(req, "\r\n\r\n") != NULL)
+			break;
+	}
+
+	if ((strncmp(req, "GET / ", 6) != 0) &&
+		(strncmp(req, "GET /metrics ", 13) != 0) &&
+		(strncmp(req, "GET /metrics?", 13) != 0)) {
+		hlen = snprintf(hdr, sizeof(hdr),
+			"HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+		send(fd, hdr, hlen, MSG_NOSIGNAL);
+		return;
+	}
+
+	fp = open_memstream(&body, &body_len);
+	if (fp == NULL)
+		return;
+	metrics_write(fp);
+	fclose(fp);
+	hlen = snprintf(hdr, sizeof(hdr),
+		"HTTP/1.0 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+		METRICS_CONTENT_TYPE, body_len);
+	if (send(fd, hdr, hlen, MSG_NOSIGNAL) == hlen) {
+		for (len = 0; len < body_len; len += ret) {
+			ret = send(fd, body + len, body_len - len,
+				MSG_NOSIGNAL);
+			if (ret <= 0)
+				break;
+		}
+	}
+	free(body);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_server
+ * @BRIEF		metrics server thread.
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		metrics server thread: serve scrape requests one at a
+ *			time until stopped.
+ *//*------------------------------------------------------------------------ */
+static void *metrics_server(void *ptr)
+{
+	struct pollfd pfd;
+	int fd;
+
+	(void) ptr;
+	pfd.fd = listen_fd;
+	pfd.events = POLLIN;
+	while (!server_stop) {
+		if (poll(&pfd, 1, METRICS_POLL_MS) <= 0)
+			continue;
+		fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0)
+			continue;
+		metrics_serve(fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_listen
+ * @BRIEF		create listening socket.
+ * @RETURNS		socket on success
+ *			-errno in case of failure
+ * @param[in]		addr: "[ip:]port" (default ip: 127.0.0.1) or Unix
+ *			socket path (containing '/')
+ * @DESCRIPTION		create listening socket.
+ *//*------------------------------------------------------------------------ */
+static int metrics_listen(const char *addr)
+{
+	struct sockaddr_un sun;
+	struct sockaddr_in sin;
+	struct stat sb;
+	char ip[INET_ADDRSTRLEN] = "127.0.0.1";
+	const char *port;
+	int fd, one = 1, n, ret;
+
+	if (strchr(addr, '/') != NULL) {
+		if (strlen(addr) >= sizeof(sun.sun_path))
+			return -ENAMETOOLONG;
+		memset(&sun, 0, sizeof(sun));
+		sun.sun_family = AF_UNIX;
+		strcpy(sun.sun_path, addr);
+		/* Remove stale socket of a previous run, nothing else */
+		if ((lstat(addr, &sb) == 0) && (S_ISSOCK(sb.st_mode)))
+			unlink(addr);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+			return -errno;
+		if ((bind(fd, (struct sockaddr *) &sun, sizeof(sun)) != 0) ||
+			(listen(fd, 8) != 0)) {
+			ret = -errno;
+			close(fd);
+			return ret;
+		}
+		unix_path = strdup(addr);
+		return fd;
+	}
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	port = strrchr(addr, ':');
+	if (port != NULL) {
+		if ((size_t) (port - addr) >= sizeof(ip))
+			return -EINVAL;
+		memcpy(ip, addr, port - addr);
+		ip[port - addr] = '\0';
+		port++;
+	} else {
+		port = addr;
+	}
+	if ((inet_pton(AF_INET, ip, &sin.sin_addr) != 1) ||
+		(sscanf(port, "%d%n", &ret, &n) != 1) || (port[n] != '\0') ||
+		(ret < 1) || (ret > 65535))
+		return -EINVAL;
+	sin.sin_port = htons(ret);
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -errno;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if ((bind(fd, (struct sockaddr *) &sin, sizeof(sin)) != 0) ||
+		(listen(fd, 8) != 0)) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_start
+ * @BRIEF		start metrics endpoint.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		addr: "[ip:]port" (default ip: 127.0.0.1) or Unix
+ *			socket path (containing '/'), NULL for no server
+ * @param[in]		count: number of load threads
+ * @DESCRIPTION		allocate live counters of load threads and start
+ *			metrics server thread, serving OpenMetrics text over
+ *			HTTP. Without addr, live counters are only allocated
+ *			for in-process readers (e.g. TUI).
+ *//*------------------------------------------------------------------------ */
+int metrics_start(const char *addr, unsigned int count)
+{
+	unsigned int i;
+	int ret;
+
+	workers = aligned_alloc(64, count * sizeof(metrics_worker));
+	if (workers == NULL)
+		return -ENOMEM;
+	memset(workers, 0, count * sizeof(metrics_worker));
+	for (i = 0; i < count; i++) {
+		workers[i].cpu = -1;
+		workers[i].setpoint = -1;
+	}
+	workers_count = count;
+	if (addr == NULL)
+		return 0;
+
+	listen_fd = metrics_listen(addr);
+	if (listen_fd < 0) {
+		ret = listen_fd;
+		fprintf(stderr, "cpuloadgen: could not listen on %s (%s)!\n",
+			addr, strerror(-ret));
+		metrics_stop();
+		return ret;
+	}
+
+	server_stop = 0;
+	ret = pthread_create(&server, NULL, metrics_server, NULL);
+	if (ret != 0) {
+		metrics_stop();
+		return -ret;
+	}
+	server_running = 1;
+	printf("Serving OpenMetrics on %s.\n", addr);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_stop
+ * @BRIEF		stop metrics endpoint.
+ * @DESCRIPTION		stop metrics server thread and release live counters.
+ *//*------------------------------------------------------------------------ */
+void metrics_stop(void)
+{
+	if (server_running) {
+		server_stop = 1;
+		pthread_join(server, NULL);
+		server_running = 0;
+	}
+	if (listen_fd >= 0)
+		close(listen_fd);
+	listen_fd = -1;
+	if (unix_path != NULL) {
+		unlink(unix_path);
+		free(unix_path);
+		unix_path = NULL;
+	}
+	free(workers);
+	workers = NULL;
+	workers_count = 0;
+}
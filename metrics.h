@@ -0,0 +1,133 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			metrics.h
+ * @Description			OpenMetrics exposition endpoint
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_METRICS_H__
+#define __CPULOADGEN_METRICS_H__
+
+
+#include <time.h>
+
+
+/* Sleep overshoot histogram upper bounds (us), last bucket is +Inf */
+#define METRICS_OVERSHOOT_BUCKETS	8
+
+
+/*
+ * Live counters of a load thread. Written by their thread only, read by the
+ * metrics server and TUI: relaxed atomic accesses, so that none ever waits.
+ */
+typedef struct {
+	int cpu;			/* -1 if never started */
+	int setpoint;			/* %, -1 if not running */
+	unsigned long long iterations;
+	unsigned long long errors;
+	unsigned long long overshoot[METRICS_OVERSHOOT_BUCKETS];
+	unsigned long long overshoot_ns;
+	unsigned long long repins;	/* placement restored */
+	unsigned long long parks;	/* CPU core not available */
+	unsigned long long parked_ns;
+	unsigned long long busy_ns;	/* CPU time of completed runs */
+	unsigned int seq;		/* odd while a run starts or ends */
+	int active;
+	clockid_t clock;		/* CPU time clock of running thread */
+} __attribute__((aligned(64))) metrics_worker;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_count
+ * @BRIEF		increment a live counter.
+ * @param[in, out]	ctr: counter (owned by calling thread)
+ * @param[in]		n: increment
+ * @DESCRIPTION		increment a live counter. Single writer: plain
+ *			increment, atomic stores only so that readers never
+ *			see a torn value.
+ *//*------------------------------------------------------------------------ */
+static inline void metrics_count(unsigned long long *ctr,
+	unsigned long long n)
+{
+	__atomic_store_n(ctr, __atomic_load_n(ctr, __ATOMIC_RELAXED) + n,
+		__ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_iterations
+ * @BRIEF		account Dhrystone iterations.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @param[in]		n: number of iterations
+ * @DESCRIPTION		account Dhrystone iterations.
+ *//*------------------------------------------------------------------------ */
+static inline void metrics_iterations(metrics_worker *w, unsigned long long n)
+{
+	if (w != NULL)
+		metrics_count(&w->iterations, n);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		metrics_setpoint
+ * @BRIEF		account a requested load change.
+ * @param[in, out]	w: live counters (NULL if metrics disabled)
+ * @param[in]		setpoint: new requested load
+ * @DESCRIPTION		account a requested load change (e.g. from TUI).
+ *//*------------------------------------------------------------------------ */
+static inline void metrics_setpoint(metrics_worker *w, int setpoint)
+{
+	if (w != NULL)
+		__atomic_store_n(&w->setpoint, setpoint, __ATOMIC_RELAXED);
+}
+
+
+int metrics_start(const char *addr, unsigned int workers);
+metrics_worker *metrics_worker_get(unsigned int idx);
+void metrics_worker_begin(metrics_worker *w, unsigned int cpu,
+	unsigned int setpoint);
+void metrics_worker_end(metrics_worker *w);
+void metrics_overshoot(metrics_worker *w, const struct timespec *deadline);
+void metrics_error(metrics_worker *w);
+double metrics_worker_busy_s(metrics_worker *w);
+void metrics_stop(void);
+
+
+#endif
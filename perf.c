@@ -0,0 +1,266 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			perf.c
+ * @Description			Hardware performance counters
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+static const unsigned int perf_types[PERF_COUNTERS_COUNT] = {
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HW_CACHE
+};
+
+static const unsigned long long perf_configs[PERF_COUNTERS_COUNT] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES,
+	PERF_COUNT_HW_CACHE_DTLB |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+
+static const char *perf_names[PERF_COUNTERS_COUNT] = {
+	"cycles",
+	"instructions",
+	"cache_misses",
+	"branch_misses",
+	"dtlb_misses"
+};
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_counter_name
+ * @BRIEF		return counter name.
+ * @RETURNS		counter name
+ * @param[in]		c: counter
+ * @DESCRIPTION		return counter name.
+ *//*------------------------------------------------------------------------ */
+const char *perf_counter_name(perf_counter c)
+{
+	if (c >= PERF_COUNTERS_COUNT)
+		return "unknown";
+
+	return perf_names[c];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_open
+ * @BRIEF		open counters group on calling thread.
+ * @RETURNS		0 on success (at least one counter available)
+ *			-errno in case of failure
+ * @param[in, out]	grp: counters group
+ * @DESCRIPTION		open counters group on calling thread (user and
+ *			kernel modes, any CPU), and save initial values.
+ *			Counters are grouped so that they are read all at
+ *			once, with a single read() system call. Counters not
+ *			supported by the CPU are skipped.
+ *//*------------------------------------------------------------------------ */
+int perf_open(perf_group *grp)
+{
+	struct perf_event_attr attr;
+	int i, leader = -1, ret = -ENOENT;
+
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		grp->fd[i] = -1;
+		grp->id[i] = 0;
+	}
+
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = perf_types[i];
+		attr.config = perf_configs[i];
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+			PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.exclude_hv = 1;
+		grp->fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1,
+			leader, 0);
+		if (grp->fd[i] < 0) {
+			ret = -errno;
+			grp->fd[i] = -1;
+			dprintf("%s(): %s not available (%d)\n", __func__,
+				perf_names[i], ret);
+			continue;
+		}
+		ioctl(grp->fd[i], PERF_EVENT_IOC_ID, &grp->id[i]);
+		if (leader == -1)
+			leader = grp->fd[i];
+	}
+
+	if (leader == -1)
+		return ret;
+
+	return perf_read(grp, &grp->start);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_read
+ * @BRIEF		read counters group.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		grp: counters group
+ * @param[out]		counts: counter values
+ * @DESCRIPTION		read counters group. Values are scaled by
+ *			enabled/running time ratio in case counters were
+ *			multiplexed.
+ *//*------------------------------------------------------------------------ */
+int perf_read(perf_group *grp, perf_counts *counts)
+{
+	/* nr, time_enabled, time_running, then {value, id} per counter */
+	unsigned long long buf[3 + 2 * PERF_COUNTERS_COUNT];
+	unsigned long long nr, enabled, running;
+	double scale;
+	int i, j, leader = -1;
+
+	memset(counts, 0, sizeof(perf_counts));
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		if (grp->fd[i] != -1) {
+			leader = grp->fd[i];
+			break;
+		}
+	}
+	if (leader == -1)
+		return -ENOENT;
+
+	if (read(leader, buf, sizeof(buf)) < (ssize_t) (3 * sizeof(buf[0])))
+		return -EIO;
+	nr = buf[0];
+	enabled = buf[1];
+	running = buf[2];
+	scale = (running != 0) ? (double) enabled / (double) running : 1.0;
+
+	for (j = 0; (j < (int) nr) && (j < PERF_COUNTERS_COUNT); j++) {
+		for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+			if ((grp->fd[i] == -1) ||
+				(grp->id[i] != buf[3 + 2 * j + 1]))
+				continue;
+			counts->val[i] = (unsigned long long)
+				((double) buf[3 + 2 * j] * scale);
+			counts->valid[i] = 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_delta
+ * @BRIEF		compute counters difference.
+ * @param[in]		start: counter values at start of interval
+ * @param[in]		end: counter values at end of interval
+ * @param[out]		delta: (end - start) counter values
+ * @DESCRIPTION		compute counters difference.
+ *//*------------------------------------------------------------------------ */
+void perf_delta(const perf_counts *start, const perf_counts *end,
+	perf_counts *delta)
+{
+	int i;
+
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		delta->valid[i] = start->valid[i] && end->valid[i];
+		delta->val[i] = delta->valid[i] ?
+			end->val[i] - start->val[i] : 0;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_add
+ * @BRIEF		accumulate counter values.
+ * @param[in, out]	total: accumulated counter values
+ * @param[in]		counts: counter values to be added
+ * @DESCRIPTION		accumulate counter values (e.g. threads of a CPU core).
+ *//*------------------------------------------------------------------------ */
+void perf_add(perf_counts *total, const perf_counts *counts)
+{
+	int i;
+
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		if (!counts->valid[i])
+			continue;
+		total->val[i] += counts->val[i];
+		total->valid[i] = 1;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		perf_close
+ * @BRIEF		close counters group.
+ * @param[in, out]	grp: counters group
+ * @DESCRIPTION		close counters group.
+ *//*------------------------------------------------------------------------ */
+void perf_close(perf_group *grp)
+{
+	int i;
+
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		if (grp->fd[i] != -1)
+			close(grp->fd[i]);
+		grp->fd[i] = -1;
+	}
+}
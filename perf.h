@@ -0,0 +1,83 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			perf.h
+ * @Description			Hardware performance counters
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_PERF_H__
+#define __CPULOADGEN_PERF_H__
+
+
+typedef enum {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_CACHE_MISSES,
+	PERF_BRANCH_MISSES,
+	PERF_DTLB_MISSES,
+	PERF_COUNTERS_COUNT
+} perf_counter;
+
+
+/* Counter values, scaled in case of multiplexing. Unavailable: valid = 0 */
+typedef struct {
+	unsigned long long val[PERF_COUNTERS_COUNT];
+	int valid[PERF_COUNTERS_COUNT];
+} perf_counts;
+
+
+/* Per-thread counters group */
+typedef struct {
+	int fd[PERF_COUNTERS_COUNT];
+	unsigned long long id[PERF_COUNTERS_COUNT];
+	perf_counts start;
+} perf_group;
+
+
+const char *perf_counter_name(perf_counter c);
+int perf_open(perf_group *grp);
+int perf_read(perf_group *grp, perf_counts *counts);
+void perf_delta(const perf_counts *start, const perf_counts *end,
+	perf_counts *delta);
+void perf_add(perf_counts *total, const perf_counts *counts);
+void perf_close(perf_group *grp);
+
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			request.c
+ * @Description			Open-loop request arrival statistics
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "request.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define REQUEST_CPUS_MAX	1024
+#define REQUEST_LINE_MAX	128
+
+
+typedef struct {
+	hist response;
+	hist wait;
+	unsigned long long completed;
+	unsigned long long backlog;
+} request_stats;
+
+
+static request_stats *stats[REQUEST_CPUS_MAX];
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static double *trace = NULL;
+static unsigned int trace_len = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_trace_load
+ * @BRIEF		load request arrival trace file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		filename: trace file name
+ * @DESCRIPTION		load request arrival trace file: one inter-arrival
+ *			time per line, in microseconds. Empty lines and lines
+ *			starting with '#' are ignored.
+ *//*------------------------------------------------------------------------ */
+int request_trace_load(const char *filename)
+{
+	char line[REQUEST_LINE_MAX];
+	unsigned int size = 0, n = 0;
+	double *buf;
+	double val;
+	FILE *fp;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "cpuloadgen: could not open %s (%s)!\n",
+			filename, strerror(errno));
+		return -errno;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((line[0] == '#') || (line[0] == '\n'))
+			continue;
+		if ((sscanf(line, "%lf", &val) != 1) || (val < 0.0)) {
+			fprintf(stderr,
+				"cpuloadgen: %s: invalid inter-arrival time (%s)!\n",
+				filename, line);
+			fclose(fp);
+			free(trace);
+			trace = NULL;
+			return -EINVAL;
+		}
+		if (n == size) {
+			size = (size == 0) ? 1024 : size * 2;
+			buf = realloc(trace, size * sizeof(double));
+			if (buf == NULL) {
+				fclose(fp);
+				free(trace);
+				trace = NULL;
+				return -ENOMEM;
+			}
+			trace = buf;
+		}
+		trace[n++] = val;
+	}
+	fclose(fp);
+
+	if (n == 0) {
+		fprintf(stderr, "cpuloadgen: %s: empty trace!\n", filename);
+		free(trace);
+		trace = NULL;
+		return -EINVAL;
+	}
+	trace_len = n;
+	dprintf("%s(): %u inter-arrival times loaded\n", __func__, n);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_trace_len
+ * @BRIEF		return number of inter-arrival times in trace.
+ * @RETURNS		number of inter-arrival times in trace (0 if none)
+ * @DESCRIPTION		return number of inter-arrival times in trace.
+ *//*------------------------------------------------------------------------ */
+unsigned int request_trace_len(void)
+{
+	return trace_len;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_trace_get
+ * @BRIEF		return an inter-arrival time of the trace.
+ * @RETURNS		inter-arrival time (in microseconds)
+ * @param[in]		pos: position in trace (wraps around)
+ * @DESCRIPTION		return an inter-arrival time of the trace, which is
+ *			replayed in a loop.
+ *//*------------------------------------------------------------------------ */
+double request_trace_get(unsigned int pos)
+{
+	return trace[pos % trace_len];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_trace_free
+ * @BRIEF		release request arrival trace.
+ * @DESCRIPTION		release request arrival trace.
+ *//*------------------------------------------------------------------------ */
+void request_trace_free(void)
+{
+	free(trace);
+	trace = NULL;
+	trace_len = 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_record
+ * @BRIEF		accumulate request statistics of a worker thread.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID
+ * @param[in]		response: response time histogram (in nanoseconds)
+ * @param[in]		wait: queueing delay histogram (in nanoseconds)
+ * @param[in]		completed: number of completed requests
+ * @param[in]		backlog: number of requests left in queue
+ * @DESCRIPTION		accumulate request statistics of a worker thread into
+ *			its CPU core statistics.
+ *//*------------------------------------------------------------------------ */
+int request_record(unsigned int cpu, const hist *response, const hist *wait,
+	unsigned long long completed, unsigned long long backlog)
+{
+	request_stats *s;
+
+	if (cpu >= REQUEST_CPUS_MAX)
+		return -EINVAL;
+
+	pthread_mutex_lock(&stats_mutex);
+	s = stats[cpu];
+	if (s == NULL) {
+		s = malloc(sizeof(request_stats));
+		if (s == NULL) {
+			pthread_mutex_unlock(&stats_mutex);
+			return -ENOMEM;
+		}
+		hist_init(&s->response);
+		hist_init(&s->wait);
+		s->completed = 0;
+		s->backlog = 0;
+		stats[cpu] = s;
+	}
+	hist_merge(&s->response, response);
+	hist_merge(&s->wait, wait);
+	s->completed += completed;
+	s->backlog += backlog;
+	pthread_mutex_unlock(&stats_mutex);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_hist
+ * @BRIEF		return response time histogram of a given CPU core.
+ * @RETURNS		histogram (in nanoseconds), NULL if no request
+ * @param[in]		cpu: CPU core ID
+ * @DESCRIPTION		return response time histogram of a given CPU core.
+ *//*------------------------------------------------------------------------ */
+const hist *request_hist(unsigned int cpu)
+{
+	if ((cpu >= REQUEST_CPUS_MAX) || (stats[cpu] == NULL))
+		return NULL;
+
+	return &stats[cpu]->response;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		request_report
+ * @BRIEF		display request statistics of a given CPU core.
+ * @param[in]		cpu: CPU core ID
+ * @param[in]		load: requested load on this CPU core
+ * @param[in]		utilisation: achieved load on this CPU core (in %)
+ * @param[in]		elapsed_s: run duration (in seconds)
+ * @DESCRIPTION		display request statistics of a given CPU core
+ *			(throughput, backlog, response time percentiles and
+ *			p99 queueing delay, in microseconds), then release
+ *			them.
+ *//*------------------------------------------------------------------------ */
+void request_report(unsigned int cpu, unsigned int load, double utilisation,
+	double elapsed_s)
+{
+	request_stats *s;
+	const hist *h;
+
+	if ((cpu >= REQUEST_CPUS_MAX) || (stats[cpu] == NULL))
+		return;
+	s = stats[cpu];
+	h = &s->response;
+
+	if ((h->count == 0) || (elapsed_s <= 0.0)) {
+		printf("CPU%-3u %3u%% %6.1f%% %10s\n", cpu, load, utilisation,
+			"no request");
+	} else {
+		printf("CPU%-3u %3u%% %6.1f%% %9.1f %8llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+			cpu, load, utilisation,
+			(double) s->completed / elapsed_s, s->backlog,
+			hist_mean(h) / 1000.0,
+			(double) hist_percentile(h, 50.0) / 1000.0,
+			(double) hist_percentile(h, 99.0) / 1000.0,
+			(double) hist_percentile(h, 99.9) / 1000.0,
+			(double) h->max / 1000.0,
+			(double) hist_percentile(&s->wait, 99.0) / 1000.0);
+	}
+
+	free(stats[cpu]);
+	stats[cpu] = NULL;
+}
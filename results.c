@@ -0,0 +1,616 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			results.c
+ * @Description			Machine-readable results export
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include "results.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define CPUINFO_FILE		"/proc/cpuinfo"
+#define TOPOLOGY_FILE		"/sys/devices/system/cpu/cpu%u/topology/%s"
+#define RESULTS_LINE_MAX	256
+
+
+typedef enum {
+	RESULTS_JSON,
+	RESULTS_CSV
+} results_format;
+
+
+static FILE *results_fp = NULL;
+static results_format format;
+static unsigned int results_cpus = 0;
+static int *topo_package = NULL;
+static int *topo_core = NULL;
+static int config_open = 0;
+static int config_count = 0;
+static int step_open = 0;
+static int step_current = 0;
+static int step_cores = 0;
+static int steps_count = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		json_str
+ * @BRIEF		write a JSON string.
+ * @param[in]		s: string (NULL: null)
+ * @DESCRIPTION		write a JSON string, escaping it as needed.
+ *//*------------------------------------------------------------------------ */
+static void json_str(const char *s)
+{
+	if (s == NULL) {
+		fprintf(results_fp, "null");
+		return;
+	}
+	fputc('"', results_fp);
+	for (; *s != '\0'; s++) {
+		if ((*s == '"') || (*s == '\\'))
+			fprintf(results_fp, "\\%c", *s);
+		else if ((unsigned char) *s < 0x20)
+			fprintf(results_fp, "\\u%04x", (unsigned char) *s);
+		else
+			fputc(*s, results_fp);
+	}
+	fputc('"', results_fp);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		json_num
+ * @BRIEF		write a JSON number.
+ * @param[in]		val: value (< 0: null)
+ * @param[in]		fmt: printf format of value
+ * @DESCRIPTION		write a JSON number, or null if not available.
+ *//*------------------------------------------------------------------------ */
+static void json_num(double val, const char *fmt)
+{
+	if (val < 0.0)
+		fprintf(results_fp, "null");
+	else
+		fprintf(results_fp, fmt, val);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		csv_num
+ * @BRIEF		write a CSV number field.
+ * @param[in]		val: value (< 0: empty field)
+ * @param[in]		fmt: printf format of value
+ * @DESCRIPTION		write a CSV number field (with leading comma), empty if
+ *			not available.
+ *//*------------------------------------------------------------------------ */
+static void csv_num(double val, const char *fmt)
+{
+	fputc(',', results_fp);
+	if (val >= 0.0)
+		fprintf(results_fp, fmt, val);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		iso_time
+ * @BRIEF		format current time.
+ * @param[out]		buf: formatted time
+ * @param[in]		size: buf size
+ * @DESCRIPTION		format current time (UTC, ISO 8601).
+ *//*------------------------------------------------------------------------ */
+static void iso_time(char *buf, size_t size)
+{
+	struct tm tm;
+	time_t t;
+
+	t = time(NULL);
+	gmtime_r(&t, &tm);
+	strftime(buf, size, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		cpu_model
+ * @BRIEF		retrieve CPU model name.
+ * @param[out]		buf: CPU model name ("unknown" if not found)
+ * @param[in]		size: buf size
+ * @DESCRIPTION		retrieve CPU model name from /proc/cpuinfo ("model
+ *			name" on x86, "Processor" or "Hardware" on ARM).
+ *//*------------------------------------------------------------------------ */
+static void cpu_model(char *buf, size_t size)
+{
+	static const char *keys[] = {"model name", "Processor", "Hardware"};
+	char line[RESULTS_LINE_MAX], *p;
+	unsigned int k;
+	FILE *fp;
+
+	snprintf(buf, size, "unknown");
+	fp = fopen(CPUINFO_FILE, "r");
+	if (fp == NULL)
+		return;
+	for (k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+		rewind(fp);
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			if ((strncmp(line, keys[k], strlen(keys[k])) != 0) ||
+				((p = strchr(line, ':')) == NULL))
+				continue;
+			for (p++; *p == ' '; p++)
+				;
+			p[strcspn(p, "\n")] = '\0';
+			snprintf(buf, size, "%s", p);
+			fclose(fp);
+			return;
+		}
+	}
+	fclose(fp);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		topology_read
+ * @BRIEF		read a CPU core topology attribute.
+ * @RETURNS		attribute value, -1 if not available
+ * @param[in]		cpu: CPU core
+ * @param[in]		attr: topology attribute name
+ * @DESCRIPTION		read a CPU core topology attribute from sysfs.
+ *//*------------------------------------------------------------------------ */
+static int topology_read(unsigned int cpu, const char *attr)
+{
+	char path[RESULTS_LINE_MAX];
+	FILE *fp;
+	int val;
+
+	snprintf(path, sizeof(path), TOPOLOGY_FILE, cpu, attr);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	if (fscanf(fp, "%d", &val) != 1)
+		val = -1;
+	fclose(fp);
+
+	return val;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_open
+ * @BRIEF		create results file and write run metadata.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		filename: results file name (".csv": CSV, else JSON)
+ * @param[in]		revision: cpuloadgen revision
+ * @param[in]		builddate: cpuloadgen build date
+ * @param[in]		cpu_count: number of CPU cores (configured)
+ * @param[in]		argc: command line argument number
+ * @param[in]		argv: command line arguments
+ * @DESCRIPTION		create results file and write run metadata: build,
+ *			host (name, kernel, CPU model and topology), command
+ *			line and start time. JSON file is a single object;
+ *			CSV file has metadata as leading "# key: value"
+ *			lines, then a row per CPU core and step.
+ *//*------------------------------------------------------------------------ */
+int results_open(const char *filename, const char *revision,
+	const char *builddate, unsigned int cpu_count, int argc, char *argv[])
+{
+	char buf[RESULTS_LINE_MAX];
+	struct utsname uts;
+	size_t len;
+	unsigned int cpu;
+	int i, ret;
+
+	topo_package = malloc(cpu_count * sizeof(int));
+	topo_core = malloc(cpu_count * sizeof(int));
+	if ((topo_package == NULL) || (topo_core == NULL)) {
+		results_close(0);
+		return -ENOMEM;
+	}
+	len = strlen(filename);
+	format = ((len > 4) && (strcmp(filename + len - 4, ".csv") == 0)) ?
+		RESULTS_CSV : RESULTS_JSON;
+	results_fp = fopen(filename, "w");
+	if (results_fp == NULL) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not create %s (%s)!\n",
+			filename, strerror(errno));
+		results_close(0);
+		return ret;
+	}
+	results_cpus = cpu_count;
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		topo_package[cpu] = topology_read(cpu, "physical_package_id");
+		topo_core[cpu] = topology_read(cpu, "core_id");
+	}
+	if (uname(&uts) != 0)
+		memset(&uts, 0, sizeof(uts));
+
+	if (format == RESULTS_CSV) {
+		fprintf(results_fp, "# schema: cpuloadgen-results/%d\n",
+			RESULTS_SCHEMA_VERSION);
+		fprintf(results_fp, "# revision: %s\n# builddate: %s\n",
+			revision, builddate);
+		gethostname(buf, sizeof(buf));
+		buf[sizeof(buf) - 1] = '\0';
+		fprintf(results_fp, "# hostname: %s\n", buf);
+		fprintf(results_fp, "# kernel: %s %s %s %s\n", uts.sysname,
+			uts.release, uts.version, uts.machine);
+		cpu_model(buf, sizeof(buf));
+		fprintf(results_fp, "# cpu_model: %s\n", buf);
+		fprintf(results_fp, "# cpus_online: %ld\n",
+			sysconf(_SC_NPROCESSORS_ONLN));
+		fprintf(results_fp, "# command:");
+		for (i = 0; i < argc; i++)
+			fprintf(results_fp, " %s", argv[i]);
+		iso_time(buf, sizeof(buf));
+		fprintf(results_fp, "\n# start: %s\n", buf);
+		config_open = 1;
+		return 0;
+	}
+
+	fprintf(results_fp, "{\n  \"schema\": \"cpuloadgen-results\",\n");
+	fprintf(results_fp, "  \"schema_version\": %d,\n",
+		RESULTS_SCHEMA_VERSION);
+	fprintf(results_fp, "  \"build\": {\"revision\": ");
+	json_str(revision);
+	fprintf(results_fp, ", \"date\": ");
+	json_str(builddate);
+	fprintf(results_fp, "},\n  \"host\": {\n    \"hostname\": ");
+	gethostname(buf, sizeof(buf));
+	buf[sizeof(buf) - 1] = '\0';
+	json_str(buf);
+	fprintf(results_fp, ",\n    \"kernel\": {\"sysname\": ");
+	json_str(uts.sysname);
+	fprintf(results_fp, ", \"release\": ");
+	json_str(uts.release);
+	fprintf(results_fp, ", \"version\": ");
+	json_str(uts.version);
+	fprintf(results_fp, ", \"machine\": ");
+	json_str(uts.machine);
+	fprintf(results_fp, "},\n    \"cpu_model\": ");
+	cpu_model(buf, sizeof(buf));
+	json_str(buf);
+	fprintf(results_fp, ",\n    \"cpus_online\": %ld,\n    \"topology\": [",
+		sysconf(_SC_NPROCESSORS_ONLN));
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		fprintf(results_fp, "%s\n      {\"cpu\": %u, \"package\": ",
+			(cpu == 0) ? "" : ",", cpu);
+		json_num(topo_package[cpu], "%.0f");
+		fprintf(results_fp, ", \"core\": ");
+		json_num(topo_core[cpu], "%.0f");
+		fprintf(results_fp, "}");
+	}
+	fprintf(results_fp, "\n    ]\n  },\n  \"command\": [");
+	for (i = 0; i < argc; i++) {
+		if (i != 0)
+			fprintf(results_fp, ", ");
+		json_str(argv[i]);
+	}
+	iso_time(buf, sizeof(buf));
+	fprintf(results_fp, "],\n  \"start\": ");
+	json_str(buf);
+	fprintf(results_fp, ",\n  \"config\": {");
+	config_open = 1;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_config_key
+ * @BRIEF		write a configuration key.
+ * @RETURNS		1 if key was written, 0 otherwise
+ * @param[in]		key: configuration key
+ * @DESCRIPTION		write a configuration key, if configuration is still
+ *			being written (i.e. no result added yet).
+ *//*------------------------------------------------------------------------ */
+static int results_config_key(const char *key)
+{
+	if ((results_fp == NULL) || (!config_open))
+		return 0;
+
+	if (format == RESULTS_CSV) {
+		fprintf(results_fp, "# config.%s: ", key);
+	} else {
+		fprintf(results_fp, "%s\n    ", (config_count == 0) ? "" : ",");
+		json_str(key);
+		fprintf(results_fp, ": ");
+	}
+	config_count++;
+
+	return 1;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_config_str
+ * @BRIEF		write a string configuration value.
+ * @param[in]		key: configuration key
+ * @param[in]		val: configuration value (NULL if not set)
+ * @DESCRIPTION		write a string configuration value. Must be called
+ *			before any result is added.
+ *//*------------------------------------------------------------------------ */
+void results_config_str(const char *key, const char *val)
+{
+	if (!results_config_key(key))
+		return;
+
+	if (format == RESULTS_CSV)
+		fprintf(results_fp, "%s\n", (val != NULL) ? val : "");
+	else
+		json_str(val);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_config_num
+ * @BRIEF		write a numeric configuration value.
+ * @param[in]		key: configuration key
+ * @param[in]		val: configuration value
+ * @DESCRIPTION		write a numeric configuration value. Must be called
+ *			before any result is added.
+ *//*------------------------------------------------------------------------ */
+void results_config_num(const char *key, double val)
+{
+	if (!results_config_key(key))
+		return;
+
+	fprintf(results_fp, "%.15g", val);
+	if (format == RESULTS_CSV)
+		fprintf(results_fp, "\n");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_config_end
+ * @BRIEF		end configuration section.
+ * @DESCRIPTION		end configuration section, and start results one.
+ *//*------------------------------------------------------------------------ */
+static void results_config_end(void)
+{
+	int i;
+
+	if (!config_open)
+		return;
+	config_open = 0;
+
+	if (format == RESULTS_JSON) {
+		fprintf(results_fp, "\n  },\n  \"steps\": [");
+		return;
+	}
+
+	fprintf(results_fp,
+		"step,cpu,package,core,requested_pct,achieved_pct,dmips,elapsed_s,iterations,kernel_ops,syscalls,io_reads");
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++)
+		fprintf(results_fp, ",%s", perf_counter_name(i));
+	fprintf(results_fp, ",freq_mhz,idle_pct,temp_max_c,power_w");
+	fprintf(results_fp,
+		",latency_count,latency_p50_ns,latency_p99_ns,latency_p99_9_ns,latency_max_ns");
+	fprintf(results_fp,
+		",response_count,response_p50_ns,response_p99_ns,response_p99_9_ns,response_max_ns");
+	fprintf(results_fp, ",repins,parks,parked_s\n");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_hist
+ * @BRIEF		write a histogram.
+ * @param[in]		h: histogram (NULL if not available)
+ * @DESCRIPTION		write a histogram: count and percentiles, and in JSON
+ *			non-empty buckets as [highest value, count] pairs.
+ *//*------------------------------------------------------------------------ */
+static void results_hist(const hist *h)
+{
+	static const double pcts[] = {50.0, 99.0, 99.9};
+	unsigned int i, n = 0;
+
+	if ((h == NULL) || (h->count == 0)) {
+		if (format == RESULTS_CSV)
+			fprintf(results_fp, ",,,,,");
+		else
+			fprintf(results_fp, "null");
+		return;
+	}
+
+	if (format == RESULTS_CSV) {
+		fprintf(results_fp, ",%llu", h->count);
+		for (i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++)
+			fprintf(results_fp, ",%llu", hist_percentile(h, pcts[i]));
+		fprintf(results_fp, ",%llu", h->max);
+		return;
+	}
+
+	fprintf(results_fp,
+		"{\"count\": %llu, \"min\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99_9\": %llu, \"max\": %llu,\n         \"buckets\": [",
+		h->count, h->min, hist_mean(h), hist_percentile(h, 50.0),
+		hist_percentile(h, 90.0), hist_percentile(h, 99.0),
+		hist_percentile(h, 99.9), h->max);
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		if (h->counts[i] == 0)
+			continue;
+		fprintf(results_fp, "%s[%llu, %llu]", (n++ == 0) ? "" : ", ",
+			hist_value(i), h->counts[i]);
+	}
+	fprintf(results_fp, "]}");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_add
+ * @BRIEF		add results of a CPU core.
+ * @param[in]		core: CPU core results
+ * @DESCRIPTION		add results of a CPU core, for a run or sweep step.
+ *			Results of a given step must be added in a row.
+ *//*------------------------------------------------------------------------ */
+void results_add(const results_core *core)
+{
+	int pkg, cid, i;
+
+	if (results_fp == NULL)
+		return;
+	results_config_end();
+	pkg = (core->cpu < results_cpus) ? topo_package[core->cpu] : -1;
+	cid = (core->cpu < results_cpus) ? topo_core[core->cpu] : -1;
+
+	if (format == RESULTS_CSV) {
+		fprintf(results_fp, "%d,%u", core->step, core->cpu);
+		csv_num(pkg, "%.0f");
+		csv_num(cid, "%.0f");
+		fprintf(results_fp, ",%d", core->requested);
+		csv_num(core->achieved, "%.2f");
+		csv_num(core->dmips, "%.1f");
+		csv_num(core->elapsed_s, "%.3f");
+		fprintf(results_fp, ",%llu,%llu,%llu,%llu", core->iterations,
+			core->kernel_ops, core->syscalls, core->io_reads);
+		for (i = 0; i < PERF_COUNTERS_COUNT; i++)
+			csv_num(core->perf.valid[i] ?
+				(double) core->perf.val[i] : -1.0, "%.0f");
+		csv_num(core->sampler.freq_mhz, "%.0f");
+		csv_num(core->sampler.idle_pct, "%.2f");
+		csv_num(core->sampler.temp_max_c, "%.1f");
+		csv_num(core->sampler.power_w, "%.3f");
+		results_hist(core->latency);
+		results_hist(core->response);
+		fprintf(results_fp, ",%llu,%llu,%.3f\n", core->repins, core->parks,
+			core->parked_s);
+		fflush(results_fp);
+		return;
+	}
+
+	if ((step_open) && (core->step != step_current)) {
+		fprintf(results_fp, "\n    ]}");
+		step_open = 0;
+	}
+	if (!step_open) {
+		fprintf(results_fp, "%s\n    {\"step\": %d, \"cores\": [",
+			(steps_count++ == 0) ? "" : ",", core->step);
+		step_open = 1;
+		step_current = core->step;
+		step_cores = 0;
+	}
+	fprintf(results_fp, "%s\n      {\"cpu\": %u, \"package\": ",
+		(step_cores++ == 0) ? "" : ",", core->cpu);
+	json_num(pkg, "%.0f");
+	fprintf(results_fp, ", \"core\": ");
+	json_num(cid, "%.0f");
+	fprintf(results_fp, ", \"requested_pct\": %d, \"achieved_pct\": ",
+		core->requested);
+	json_num(core->achieved, "%.2f");
+	fprintf(results_fp, ", \"dmips\": ");
+	json_num(core->dmips, "%.1f");
+	fprintf(results_fp, ", \"elapsed_s\": ");
+	json_num(core->elapsed_s, "%.3f");
+	fprintf(results_fp,
+		",\n       \"iterations\": %llu, \"kernel_ops\": %llu, \"syscalls\": %llu, \"io_reads\": %llu,\n       \"repins\": %llu, \"parks\": %llu, \"parked_s\": %.3f,\n       \"counters\": {",
+		core->iterations, core->kernel_ops, core->syscalls,
+		core->io_reads, core->repins, core->parks, core->parked_s);
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		fprintf(results_fp, "%s\"%s\": ", (i == 0) ? "" : ", ",
+			perf_counter_name(i));
+		json_num(core->perf.valid[i] ?
+			(double) core->perf.val[i] : -1.0, "%.0f");
+	}
+	fprintf(results_fp, "},\n       \"sampler\": {\"freq_mhz\": ");
+	json_num(core->sampler.freq_mhz, "%.0f");
+	fprintf(results_fp, ", \"idle_pct\": ");
+	json_num(core->sampler.idle_pct, "%.2f");
+	fprintf(results_fp, ", \"temp_max_c\": ");
+	json_num(core->sampler.temp_max_c, "%.1f");
+	fprintf(results_fp, ", \"power_w\": ");
+	json_num(core->sampler.power_w, "%.3f");
+	fprintf(results_fp, "},\n       \"latency_ns\": ");
+	results_hist(core->latency);
+	fprintf(results_fp, ",\n       \"response_ns\": ");
+	results_hist(core->response);
+	fprintf(results_fp, "}");
+	fflush(results_fp);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		results_close
+ * @BRIEF		complete and close results file.
+ * @param[in]		interrupted: run was interrupted by user
+ * @DESCRIPTION		complete results file (end time, interruption) and
+ *			close it.
+ *//*------------------------------------------------------------------------ */
+void results_close(int interrupted)
+{
+	char buf[RESULTS_LINE_MAX];
+
+	if (results_fp != NULL) {
+		results_config_end();
+		iso_time(buf, sizeof(buf));
+		if (format == RESULTS_CSV) {
+			fprintf(results_fp, "# end: %s\n# interrupted: %d\n",
+				buf, interrupted ? 1 : 0);
+		} else {
+			if (step_open)
+				fprintf(results_fp, "\n    ]}");
+			fprintf(results_fp, "\n  ],\n  \"end\": ");
+			json_str(buf);
+			fprintf(results_fp, ",\n  \"interrupted\": %s\n}\n",
+				interrupted ? "true" : "false");
+		}
+		fclose(results_fp);
+		dprintf("%s(): results closed\n", __func__);
+	}
+	results_fp = NULL;
+	free(topo_package);
+	free(topo_core);
+	topo_package = NULL;
+	topo_core = NULL;
+	config_open = 0;
+	config_count = 0;
+	step_open = 0;
+	step_cores = 0;
+	steps_count = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			results.h
+ * @Description			Machine-readable results export
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_RESULTS_H__
+#define __CPULOADGEN_RESULTS_H__
+
+
+#include "hist.h"
+#include "perf.h"
+#include "sampler.h"
+
+
+/* Bumped on any incompatible change of results file layout */
+#define RESULTS_SCHEMA_VERSION	1
+
+
+/* Results of a CPU core over a run or sweep step */
+typedef struct {
+	int step;			/* -1 for a single run */
+	unsigned int cpu;
+	int requested;			/* % */
+	double achieved;		/* %, < 0 if n/a */
+	double dmips;
+	double elapsed_s;
+	unsigned long long iterations;
+	unsigned long long kernel_ops;
+	unsigned long long syscalls;
+	unsigned long long io_reads;
+	unsigned long long repins;	/* placement restored */
+	unsigned long long parks;	/* CPU core not available */
+	double parked_s;
+	perf_counts perf;
+	sampler_summary sampler;	/* fields < 0 if n/a */
+	const hist *latency;		/* wakeup latency (ns), NULL if n/a */
+	const hist *response;		/* response time (ns), NULL if n/a */
+} results_core;
+
+
+int results_open(const char *filename, const char *revision,
+	const char *builddate, unsigned int cpu_count, int argc, char *argv[]);
+void results_config_str(const char *key, const char *val);
+void results_config_num(const char *key, double val);
+void results_add(const results_core *core);
+void results_close(int interrupted);
+
+
+#endif
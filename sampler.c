@@ -0,0 +1,753 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			sampler.c
+ * @Description			Power, frequency and thermal sampler
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sampler.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define SAMPLER_PATH_MAX	320
+#define SAMPLER_NAME_MAX	48
+#define SAMPLER_IDLE_STATES_MAX	16
+#define SAMPLER_LABEL_MAX	16
+#define SAMPLER_VALUE_MAX	32
+
+
+typedef enum {
+	SRC_FREQ,
+	SRC_TEMP,
+	SRC_ENERGY,
+	SRC_IDLE
+} source_type;
+
+static const char *source_names[] = {"freq", "temp", "energy", "cpuidle"};
+static const char *source_units[] = {"kHz", "C", "J", "us"};
+
+typedef struct {
+	source_type type;
+	int cpu;
+	char path[SAMPLER_PATH_MAX];
+	char name[SAMPLER_NAME_MAX];
+	int fd;				/* kept open, -1 if none */
+	unsigned long long last;
+	unsigned long long range;
+	int valid;
+	unsigned int state;
+	char label[SAMPLER_LABEL_MAX];
+	double window_acc;
+} source;
+
+typedef struct {
+	double freq_sum;
+	unsigned long long freq_count;
+	double idle_us;
+	int idle_valid;
+} cpu_window;
+
+
+static source *sources = NULL;
+static unsigned int source_count = 0;
+static cpu_window *windows = NULL;
+static unsigned long long *idle_prev = NULL;
+static unsigned long long *idle_cur = NULL;
+static unsigned int sampler_cpu_count = 0;
+static long int sampler_interval = 0;
+static FILE *sampler_fp = NULL;
+static pthread_t sampler_thread;
+static pthread_mutex_t sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int sampler_running = 0;
+static volatile int sampler_enabled = 1;
+
+static struct timespec window_start, window_last;
+static double window_energy_uj;
+static int window_energy_valid;	/* -1: lost to unknown wrap-around */
+static long long window_temp_max;
+static int window_temp_valid;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		read_ull
+ * @BRIEF		read unsigned integer value from a sysfs file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: sysfs file path
+ * @param[out]		val: value read
+ * @DESCRIPTION		read unsigned integer value from a sysfs file.
+ *//*------------------------------------------------------------------------ */
+static int read_ull(const char *path, unsigned long long *val)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	ret = (fscanf(fp, "%llu", val) == 1) ? 0 : -EIO;
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		read_str
+ * @BRIEF		read first word of a sysfs file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: sysfs file path
+ * @param[out]		str: string read
+ * @param[in]		size: string buffer size
+ * @DESCRIPTION		read first word of a sysfs file.
+ *//*------------------------------------------------------------------------ */
+static int read_str(const char *path, char *str, unsigned int size)
+{
+	char fmt[16];
+	FILE *fp;
+	int ret;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	snprintf(fmt, sizeof(fmt), "%%%us", size - 1);
+	ret = (fscanf(fp, fmt, str) == 1) ? 0 : -EIO;
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		source_read
+ * @BRIEF		read current value of a source.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		src: source
+ * @param[out]		val: value read
+ * @DESCRIPTION		read current value of a source, from its file kept
+ *			open if any (sysfs attributes are regenerated on each
+ *			read at offset 0), so that sampling does neither
+ *			allocate memory nor open files.
+ *//*------------------------------------------------------------------------ */
+static int source_read(const source *src, unsigned long long *val)
+{
+	char buf[SAMPLER_VALUE_MAX], *end;
+	ssize_t len;
+	int fd;
+
+	fd = (src->fd >= 0) ? src->fd : open(src->path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (src->fd < 0)
+		close(fd);
+	if (len <= 0)
+		return (len < 0) ? -errno : -EIO;
+	buf[len] = '\0';
+	*val = strtoull(buf, &end, 10);
+
+	return (end == buf) ? -EIO : 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sources_free
+ * @BRIEF		close and release all sources.
+ * @DESCRIPTION		close and release all sources.
+ *//*------------------------------------------------------------------------ */
+static void sources_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < source_count; i++) {
+		if (sources[i].fd >= 0)
+			close(sources[i].fd);
+	}
+	free(sources);
+	sources = NULL;
+	source_count = 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		source_add
+ * @BRIEF		add a source to the list of sampled sources.
+ * @RETURNS		0 on success
+ *			-errno in case of failure (e.g. source not readable)
+ * @param[in]		type: source type
+ * @param[in]		cpu: CPU core ID (-1 if not per-cpu)
+ * @param[in]		path: sysfs file path
+ * @param[in]		name: source name
+ * @DESCRIPTION		add a source to the list of sampled sources,
+ *			provided it is readable. Its file is kept open, unless
+ *			out of file descriptors (then opened at each sample).
+ *//*------------------------------------------------------------------------ */
+static int source_add(source_type type, int cpu, const char *path,
+	const char *name)
+{
+	unsigned long long val;
+	source *tmp;
+
+	if (read_ull(path, &val) != 0)
+		return -ENOENT;
+
+	tmp = realloc(sources, (source_count + 1) * sizeof(source));
+	if (tmp == NULL)
+		return -ENOMEM;
+	sources = tmp;
+	memset(&sources[source_count], 0, sizeof(source));
+	sources[source_count].type = type;
+	sources[source_count].cpu = cpu;
+	strncpy(sources[source_count].path, path, SAMPLER_PATH_MAX - 1);
+	strncpy(sources[source_count].name, name, SAMPLER_NAME_MAX - 1);
+	sources[source_count].fd = open(path, O_RDONLY | O_CLOEXEC);
+	source_count++;
+	dprintf("%s(): %s %s (%s)\n", __func__, source_names[type], name, path);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sources_discover
+ * @BRIEF		discover available sources.
+ * @param[in]		cpu_count: number of CPU cores
+ * @DESCRIPTION		discover available sources: cpufreq current frequency,
+ *			thermal zones temperature, RAPL (powercap) energy
+ *			counters and cpuidle states residency.
+ *			Report missing source types.
+ *//*------------------------------------------------------------------------ */
+static void sources_discover(unsigned int cpu_count)
+{
+	char path[SAMPLER_PATH_MAX];
+	char name[SAMPLER_NAME_MAX];
+	unsigned int cpu, state, count;
+	struct dirent *d;
+	DIR *dir;
+	char *p;
+
+	/* CPU frequency */
+	count = 0;
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq",
+			cpu);
+		snprintf(name, sizeof(name), "cpu%u", cpu);
+		if (source_add(SRC_FREQ, cpu, path, name) == 0)
+			count++;
+	}
+	if (count == 0)
+		printf("Sampler: CPU frequency not available (no cpufreq).\n");
+
+	/* Thermal zones */
+	count = 0;
+	dir = opendir("/sys/class/thermal");
+	if (dir != NULL) {
+		while ((d = readdir(dir)) != NULL) {
+			if (strncmp(d->d_name, "thermal_zone", 12) != 0)
+				continue;
+			snprintf(path, sizeof(path), "/sys/class/thermal/%s/temp",
+				d->d_name);
+			if (source_add(SRC_TEMP, -1, path, d->d_name) == 0)
+				count++;
+		}
+		closedir(dir);
+	}
+	if (count == 0)
+		printf("Sampler: temperature not available (no thermal zone).\n");
+
+	/* RAPL energy counters: top-level (package) zones only */
+	count = 0;
+	dir = opendir("/sys/class/powercap");
+	if (dir != NULL) {
+		while ((d = readdir(dir)) != NULL) {
+			p = strchr(d->d_name, ':');
+			if ((p == NULL) || (strchr(p + 1, ':') != NULL))
+				continue;
+			snprintf(path, sizeof(path),
+				"/sys/class/powercap/%s/energy_uj", d->d_name);
+			if (source_add(SRC_ENERGY, -1, path, d->d_name) != 0)
+				continue;
+			snprintf(path, sizeof(path),
+				"/sys/class/powercap/%s/max_energy_range_uj",
+				d->d_name);
+			read_ull(path, &sources[source_count - 1].range);
+			count++;
+		}
+		closedir(dir);
+	}
+	if (count == 0)
+		printf("Sampler: energy not available (no powercap/RAPL).\n");
+
+	/* cpuidle states residency */
+	count = 0;
+	for (cpu = 0; cpu < cpu_count; cpu++) {
+		for (state = 0; state < SAMPLER_IDLE_STATES_MAX; state++) {
+			snprintf(path, sizeof(path),
+				"/sys/devices/system/cpu/cpu%u/cpuidle/state%u/time",
+				cpu, state);
+			snprintf(name, sizeof(name), "cpu%u/state%u", cpu,
+				state);
+			if (source_add(SRC_IDLE, cpu, path, name) != 0)
+				break;
+			sources[source_count - 1].state = state;
+			snprintf(path, sizeof(path),
+				"/sys/devices/system/cpu/cpu%u/cpuidle/state%u/name",
+				cpu, state);
+			read_str(path, sources[source_count - 1].label,
+				SAMPLER_LABEL_MAX);
+			count++;
+		}
+	}
+	if (count == 0)
+		printf("Sampler: C-state residency not available (no cpuidle).\n");
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_sample
+ * @BRIEF		sample all sources once.
+ * @DESCRIPTION		sample all sources once, save samples into file
+ *			(if any) and update window accumulators.
+ *			A source that becomes unreadable is reported once and
+ *			skipped. Window energy is not reported if a counter
+ *			with unknown range wraps around.
+ *//*------------------------------------------------------------------------ */
+static void sampler_sample(void)
+{
+	unsigned long long val = 0, delta;
+	unsigned long long *idle = idle_cur;
+	struct timespec ts;
+	unsigned int i;
+	source *src;
+
+	pthread_mutex_lock(&sampler_mutex);
+	memset(idle, 0, sampler_cpu_count * sizeof(unsigned long long));
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	for (i = 0; i < source_count; i++) {
+		src = &sources[i];
+		if (source_read(src, &val) != 0) {
+			if (src->valid >= 0)
+				fprintf(stderr, "cpuloadgen: sampler: %s %s no longer readable, skipped.\n",
+					source_names[src->type], src->name);
+			src->valid = -1;
+			continue;
+		}
+
+		switch (src->type) {
+		case SRC_FREQ:
+			windows[src->cpu].freq_sum += (double) val;
+			windows[src->cpu].freq_count++;
+			break;
+		case SRC_TEMP:
+			if ((!window_temp_valid) ||
+				((long long) val > window_temp_max))
+				window_temp_max = (long long) val;
+			window_temp_valid = 1;
+			break;
+		case SRC_ENERGY:
+			if ((src->valid == 1) && (val < src->last) &&
+				(src->range == 0)) {
+				/* Wrap-around of unknown range: window lost */
+				window_energy_valid = -1;
+			} else if (src->valid == 1) {
+				/* Handle counter wrap-around */
+				if (val >= src->last)
+					delta = val - src->last;
+				else
+					delta = src->range - src->last + val;
+				window_energy_uj += (double) delta;
+				if (window_energy_valid == 0)
+					window_energy_valid = 1;
+			}
+			break;
+		case SRC_IDLE:
+			idle[src->cpu] += val;
+			if ((src->valid == 1) && (val >= src->last))
+				src->window_acc += (double) (val - src->last);
+			break;
+		}
+		src->last = val;
+		src->valid = 1;
+
+		if (sampler_fp == NULL)
+			continue;
+		if (src->type == SRC_TEMP)
+			fprintf(sampler_fp, "%ld.%09ld,%s,%s,%.3f,%s\n",
+				(long) ts.tv_sec, ts.tv_nsec,
+				source_names[src->type], src->name,
+				(double) val / 1000.0, source_units[src->type]);
+		else if (src->type == SRC_ENERGY)
+			fprintf(sampler_fp, "%ld.%09ld,%s,%s,%.6f,%s\n",
+				(long) ts.tv_sec, ts.tv_nsec,
+				source_names[src->type], src->name,
+				(double) val / 1.0e6, source_units[src->type]);
+		else
+			fprintf(sampler_fp, "%ld.%09ld,%s,%s,%llu,%s\n",
+				(long) ts.tv_sec, ts.tv_nsec,
+				source_names[src->type], src->name, val,
+				source_units[src->type]);
+	}
+
+	/* Accumulate residency of all idle states since previous sample */
+	for (i = 0; i < sampler_cpu_count; i++) {
+		if (idle[i] == 0)
+			continue;
+		if ((idle_prev[i] != 0) && (idle[i] >= idle_prev[i])) {
+			windows[i].idle_us += (double) (idle[i] - idle_prev[i]);
+			windows[i].idle_valid = 1;
+		}
+		idle_prev[i] = idle[i];
+	}
+	window_last = ts;
+	pthread_mutex_unlock(&sampler_mutex);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_thread_fn
+ * @BRIEF		sampler thread.
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		sampler thread: sample all sources periodically,
+ *			on absolute CLOCK_MONOTONIC deadlines.
+ *//*------------------------------------------------------------------------ */
+static void *sampler_thread_fn(void *ptr)
+{
+	struct timespec next;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (sampler_running) {
+		if (sampler_enabled)
+			sampler_sample();
+		next.tv_nsec += sampler_interval * 1000000L;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_start
+ * @BRIEF		discover sources and start sampler thread.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu_count: number of CPU cores
+ * @param[in]		interval: sampling interval (in milliseconds)
+ * @param[in]		filename: samples CSV file name (NULL if none)
+ * @DESCRIPTION		discover sources and start sampler thread.
+ *			Samples are timestamped with CLOCK_MONOTONIC (in
+ *			seconds), the timebase of load thread PWM phases.
+ *//*------------------------------------------------------------------------ */
+int sampler_start(unsigned int cpu_count, long int interval,
+	const char *filename)
+{
+	int ret;
+
+	windows = calloc(cpu_count, sizeof(cpu_window));
+	idle_prev = calloc(cpu_count, sizeof(unsigned long long));
+	idle_cur = calloc(cpu_count, sizeof(unsigned long long));
+	if ((windows == NULL) || (idle_prev == NULL) || (idle_cur == NULL)) {
+		free(windows);
+		free(idle_prev);
+		free(idle_cur);
+		return -ENOMEM;
+	}
+	sampler_cpu_count = cpu_count;
+	sampler_interval = interval;
+
+	if (filename != NULL) {
+		sampler_fp = fopen(filename, "w");
+		if (sampler_fp == NULL) {
+			ret = -errno;
+			fprintf(stderr, "cpuloadgen: could not create %s (%s)!\n",
+				filename, strerror(-ret));
+			goto err;
+		}
+		fprintf(sampler_fp, "time_s,source,name,value,unit\n");
+	}
+
+	sources_discover(cpu_count);
+	clock_gettime(CLOCK_MONOTONIC, &window_last);
+	sampler_window_reset();
+
+	sampler_running = 1;
+	ret = pthread_create(&sampler_thread, NULL, sampler_thread_fn, NULL);
+	if (ret != 0) {
+		sampler_running = 0;
+		fprintf(stderr, "cpuloadgen: failed to start sampler! (%d)\n",
+			ret);
+		ret = -ret;
+		goto err;
+	}
+
+	return 0;
+
+err:
+	if (sampler_fp != NULL) {
+		fclose(sampler_fp);
+		sampler_fp = NULL;
+	}
+	sources_free();
+	free(windows);
+	windows = NULL;
+	free(idle_prev);
+	idle_prev = NULL;
+	free(idle_cur);
+	idle_cur = NULL;
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_mark
+ * @BRIEF		save a timestamped phase event into samples file.
+ * @param[in]		fmt: event description format string
+ * @DESCRIPTION		save a timestamped phase event (e.g. load level change)
+ *			into samples file, so that samples can be correlated
+ *			with load phases.
+ *//*------------------------------------------------------------------------ */
+void sampler_mark(const char *fmt, ...)
+{
+	struct timespec ts;
+	char buf[128];
+	va_list ap;
+
+	if (sampler_fp == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	pthread_mutex_lock(&sampler_mutex);
+	fprintf(sampler_fp, "%ld.%09ld,phase,%s,,\n", (long) ts.tv_sec,
+		ts.tv_nsec, buf);
+	fflush(sampler_fp);
+	pthread_mutex_unlock(&sampler_mutex);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_enable
+ * @BRIEF		pause or resume periodic sampling.
+ * @param[in]		enable: 1 to resume sampling, 0 to pause it
+ * @DESCRIPTION		pause or resume periodic sampling (e.g. per scenario
+ *			phase). On resume, counters are re-primed so that
+ *			time spent paused is not accounted into next window.
+ *			No-op if sampler is not running.
+ *//*------------------------------------------------------------------------ */
+void sampler_enable(int enable)
+{
+	unsigned int i;
+
+	if ((!sampler_running) || (enable == sampler_enabled))
+		return;
+
+	if (!enable) {
+		sampler_enabled = 0;
+		sampler_mark("sampling off");
+		return;
+	}
+
+	pthread_mutex_lock(&sampler_mutex);
+	for (i = 0; i < source_count; i++)
+		if (sources[i].valid == 1)
+			sources[i].valid = 0;
+	memset(idle_prev, 0, sampler_cpu_count * sizeof(unsigned long long));
+	pthread_mutex_unlock(&sampler_mutex);
+	sampler_sample();
+	sampler_mark("sampling on");
+	sampler_enabled = 1;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_window_reset
+ * @BRIEF		start a new averaging window.
+ * @DESCRIPTION		start a new averaging window (e.g. new load level).
+ *			Energy and idle residency being accumulated as deltas
+ *			between consecutive samples, window starts at the
+ *			latest sample.
+ *//*------------------------------------------------------------------------ */
+void sampler_window_reset(void)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&sampler_mutex);
+	if (windows != NULL)
+		memset(windows, 0, sampler_cpu_count * sizeof(cpu_window));
+	window_start = window_last;
+	for (i = 0; i < source_count; i++)
+		sources[i].window_acc = 0.0;
+	window_energy_uj = 0.0;
+	window_energy_valid = 0;
+	window_temp_max = 0;
+	window_temp_valid = 0;
+	pthread_mutex_unlock(&sampler_mutex);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_window_get
+ * @BRIEF		retrieve values averaged over current window.
+ * @param[in]		cpu: CPU core ID
+ * @param[out]		sum: averaged values (< 0 if not available)
+ * @DESCRIPTION		retrieve values averaged over current window,
+ *			for a given CPU core.
+ *//*------------------------------------------------------------------------ */
+void sampler_window_get(unsigned int cpu, sampler_summary *sum)
+{
+	double elapsed_us;
+	cpu_window *w;
+
+	sum->freq_mhz = -1.0;
+	sum->idle_pct = -1.0;
+	sum->temp_max_c = -1.0;
+	sum->power_w = -1.0;
+	if ((windows == NULL) || (cpu >= sampler_cpu_count))
+		return;
+
+	pthread_mutex_lock(&sampler_mutex);
+	w = &windows[cpu];
+	elapsed_us = ((double) (window_last.tv_sec - window_start.tv_sec))
+		* 1.0e6 + ((double) (window_last.tv_nsec -
+		window_start.tv_nsec)) * 1.0e-3;
+	if (w->freq_count != 0)
+		sum->freq_mhz = w->freq_sum / (double) w->freq_count / 1000.0;
+	if ((w->idle_valid) && (elapsed_us > 0.0))
+		sum->idle_pct = 100.0 * w->idle_us / elapsed_us;
+	if (window_temp_valid)
+		sum->temp_max_c = (double) window_temp_max / 1000.0;
+	if ((window_energy_valid > 0) && (elapsed_us > 0.0))
+		sum->power_w = window_energy_uj / elapsed_us;
+	pthread_mutex_unlock(&sampler_mutex);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_cstate_get
+ * @BRIEF		retrieve residency of a C-state over current window.
+ * @RETURNS		0 on success
+ *			-ENOENT if C-state does not exist (or no cpuidle)
+ * @param[in]		cpu: CPU core ID
+ * @param[in]		state: cpuidle state index
+ * @param[out]		name: C-state name (e.g. "C1E")
+ * @param[out]		pct: C-state residency over current window (in %)
+ * @DESCRIPTION		retrieve residency of a C-state over current window.
+ *//*------------------------------------------------------------------------ */
+int sampler_cstate_get(unsigned int cpu, unsigned int state,
+	const char **name, double *pct)
+{
+	double elapsed_us;
+	unsigned int i;
+	int ret = -ENOENT;
+
+	pthread_mutex_lock(&sampler_mutex);
+	elapsed_us = ((double) (window_last.tv_sec - window_start.tv_sec))
+		* 1.0e6 + ((double) (window_last.tv_nsec -
+		window_start.tv_nsec)) * 1.0e-3;
+	for (i = 0; i < source_count; i++) {
+		if ((sources[i].type != SRC_IDLE) ||
+			(sources[i].cpu != (int) cpu) ||
+			(sources[i].state != state))
+			continue;
+		*name = (sources[i].label[0] != '\0') ?
+			sources[i].label : sources[i].name;
+		*pct = (elapsed_us > 0.0) ?
+			100.0 * sources[i].window_acc / elapsed_us : 0.0;
+		ret = 0;
+		break;
+	}
+	pthread_mutex_unlock(&sampler_mutex);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sampler_stop
+ * @BRIEF		stop sampler thread and release resources.
+ * @DESCRIPTION		stop sampler thread and release resources.
+ *//*------------------------------------------------------------------------ */
+void sampler_stop(void)
+{
+	if (!sampler_running)
+		return;
+
+	sampler_running = 0;
+	pthread_join(sampler_thread, NULL);
+
+	if (sampler_fp != NULL) {
+		fclose(sampler_fp);
+		sampler_fp = NULL;
+	}
+	sources_free();
+	free(windows);
+	windows = NULL;
+	free(idle_prev);
+	idle_prev = NULL;
+	free(idle_cur);
+	idle_cur = NULL;
+	sampler_cpu_count = 0;
+}
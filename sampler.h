@@ -0,0 +1,69 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			sampler.h
+ * @Description			Power, frequency and thermal sampler
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_SAMPLER_H__
+#define __CPULOADGEN_SAMPLER_H__
+
+
+/* Sampled values averaged over a window (e.g. one load level) */
+typedef struct {
+	double freq_mhz;	/* average CPU frequency, < 0 if n/a */
+	double idle_pct;	/* cpuidle states residency, < 0 if n/a */
+	double temp_max_c;	/* max temperature of all zones, < 0 if n/a */
+	double power_w;		/* average RAPL power of all packages, < 0 if n/a */
+} sampler_summary;
+
+
+int sampler_start(unsigned int cpu_count, long int interval,
+	const char *filename);
+void sampler_mark(const char *fmt, ...);
+void sampler_enable(int enable);
+void sampler_window_reset(void);
+void sampler_window_get(unsigned int cpu, sampler_summary *sum);
+int sampler_cstate_get(unsigned int cpu, unsigned int state,
+	const char **name, double *pct);
+void sampler_stop(void);
+
+
+#endif
@@ -0,0 +1,483 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			scenario.c
+ * @Description			Multi-phase scenario file
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <sys/wait.h>
+#include "coherence.h"
+#include "scenario.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define SCENARIO_LINE_MAX	1024
+#define SCENARIO_DELIMS		" \t\r\n"
+
+
+static scenario_phase *phases = NULL;
+static unsigned int phases_len = 0;
+static unsigned int phases_cpus = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_phase_add
+ * @BRIEF		append a new phase to scenario.
+ * @RETURNS		new phase, NULL in case of failure
+ * @param[in]		name: phase name
+ * @param[in]		line: phase line number in scenario file
+ * @DESCRIPTION		append a new phase to scenario, no CPU core loaded.
+ *//*------------------------------------------------------------------------ */
+static scenario_phase *scenario_phase_add(const char *name, unsigned int line)
+{
+	scenario_phase *buf, *ph;
+	unsigned int cpu;
+
+	buf = realloc(phases, (phases_len + 1) * sizeof(scenario_phase));
+	if (buf == NULL)
+		return NULL;
+	phases = buf;
+	ph = &phases[phases_len];
+	memset(ph, 0, sizeof(scenario_phase));
+	ph->loads = malloc(phases_cpus * sizeof(int));
+	if (ph->loads == NULL)
+		return NULL;
+	for (cpu = 0; cpu < phases_cpus; cpu++)
+		ph->loads[cpu] = -1;
+	snprintf(ph->name, sizeof(ph->name), "%s", name);
+	ph->line = line;
+	ph->duration_s = -1.0;
+	ph->period = -1;
+	ph->pingpong = -1;
+	ph->sample = -1;
+	ph->syscall_mix = SYSLOAD_ALL;
+	phases_len++;
+
+	return ph;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_option_parse
+ * @BRIEF		parse a phase option.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of invalid option
+ * @param[in, out]	ph: phase
+ * @param[in]		opt: option ("key=value")
+ * @DESCRIPTION		parse a phase option, with command line syntax.
+ *//*------------------------------------------------------------------------ */
+static int scenario_option_parse(scenario_phase *ph, char *opt)
+{
+	unsigned int cpu;
+	int load, ret, n = 0;
+
+	if (sscanf(opt, "cpu%u=%d%n", &cpu, &load, &n) == 2) {
+		if ((opt[n] != '\0') || (cpu >= phases_cpus) ||
+			(load < 1) || (load > 100) || (ph->loads[cpu] != -1))
+			return -EINVAL;
+		ph->loads[cpu] = load;
+	} else if (strncmp(opt, "duration=", 9) == 0) {
+		if ((sscanf(opt, "duration=%lf%n", &ph->duration_s, &n) != 1) ||
+			(opt[n] != '\0') || (ph->duration_s <= 0.0))
+			return -EINVAL;
+	} else if (strncmp(opt, "period=", 7) == 0) {
+		if ((sscanf(opt, "period=%ld%n", &ph->period, &n) != 1) ||
+			(opt[n] != '\0') || (ph->period < 1) ||
+			(ph->period > PERIOD_MAX_US))
+			return -EINVAL;
+	} else if (strncmp(opt, "jitter=", 7) == 0) {
+		if (dist_parse(opt + 7, &ph->jitter) != 0)
+			return -EINVAL;
+		ph->jitter_set = (ph->jitter.type != DIST_CONSTANT);
+	} else if (strncmp(opt, "tlb=", 4) == 0) {
+		if ((sscanf(opt, "tlb=%u%n", &ph->tlb_mb, &n) != 1) ||
+			(ph->tlb_mb < 1))
+			return -EINVAL;
+		if (opt[n] != '\0') {
+			if (strncmp(opt + n, ",pages=", 7) != 0)
+				return -EINVAL;
+			ret = tlb_pages_parse(opt + n + 7);
+			if (ret < 0)
+				return ret;
+			ph->tlb_backing = (tlb_pages) ret;
+		}
+	} else if (strncmp(opt, "pingpong=", 9) == 0) {
+		ph->pingpong = coherence_parse(opt + 9);
+		if (ph->pingpong < 0)
+			return -EINVAL;
+	} else if (strncmp(opt, "syscall=", 8) == 0) {
+		if ((sscanf(opt, "syscall=%d%n", &ph->syscall_pct, &n) != 1) ||
+			(ph->syscall_pct < 1) || (ph->syscall_pct > 100))
+			return -EINVAL;
+		if (opt[n] != '\0') {
+			if (strncmp(opt + n, ",mix=", 5) != 0)
+				return -EINVAL;
+			ret = sysload_mix_parse(opt + n + 5);
+			if (ret < 0)
+				return ret;
+			ph->syscall_mix = (sysload_mix) ret;
+		}
+	} else if (strcmp(opt, "sample=on") == 0) {
+		ph->sample = 1;
+	} else if (strcmp(opt, "sample=off") == 0) {
+		ph->sample = 0;
+	} else if (strncmp(opt, "iowait=", 7) == 0) {
+		if ((sscanf(opt, "iowait=%d%n", &ph->iowait_pct, &n) != 1) ||
+			(ph->iowait_pct < 1) || (ph->iowait_pct > 100))
+			return -EINVAL;
+		if (opt[n] != '\0') {
+			if ((strncmp(opt + n, ",file=", 6) != 0) ||
+				(opt[n + 6] == '\0'))
+				return -EINVAL;
+			ph->iowait_file = strdup(opt + n + 6);
+			if (ph->iowait_file == NULL)
+				return -ENOMEM;
+		}
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_phase_check
+ * @BRIEF		check phase consistency.
+ * @RETURNS		0 on success
+ *			-EINVAL in case of inconsistent phase
+ * @param[in]		filename: scenario file name
+ * @param[in]		ph: phase
+ * @DESCRIPTION		check phase consistency: duration is mandatory, and
+ *			kernels follow command line compatibility rules.
+ *//*------------------------------------------------------------------------ */
+static int scenario_phase_check(const char *filename,
+	const scenario_phase *ph)
+{
+	int kernels;
+
+	if (ph->duration_s <= 0.0) {
+		fprintf(stderr, "cpuloadgen: %s:%u: phase %s has no duration!\n",
+			filename, ph->line, ph->name);
+		return -EINVAL;
+	}
+	kernels = (ph->tlb_mb != 0) + (ph->pingpong != -1) +
+		((ph->syscall_pct != 0) || (ph->iowait_pct != 0));
+	if (kernels > 1) {
+		fprintf(stderr,
+			"cpuloadgen: %s:%u: phase %s: tlb, pingpong and syscall/iowait are mutually exclusive!\n",
+			filename, ph->line, ph->name);
+		return -EINVAL;
+	}
+	if ((ph->jitter_set) && ((ph->tlb_mb != 0) || (ph->pingpong != -1))) {
+		fprintf(stderr,
+			"cpuloadgen: %s:%u: phase %s: tlb and pingpong are not compatible with jitter!\n",
+			filename, ph->line, ph->name);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_parse
+ * @BRIEF		parse and validate scenario.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		fp: scenario stream
+ * @param[in]		filename: scenario name (for error messages)
+ * @param[in]		cpu_count: number of CPU cores
+ * @param[in]		hooks: 1 to allow hooks (shell commands)
+ * @DESCRIPTION		parse and validate scenario: a list of phases,
+ *			each starting with a "[name]" line, followed by
+ *			lines of whitespace-separated options (command line
+ *			syntax). "onstart=" and "onstop=" options take the
+ *			rest of their line as shell command, and are rejected
+ *			unless hooks are allowed. Empty lines and lines
+ *			starting with '#' are ignored.
+ *//*------------------------------------------------------------------------ */
+static int scenario_parse(FILE *fp, const char *filename,
+	unsigned int cpu_count, int hooks)
+{
+	char line[SCENARIO_LINE_MAX];
+	scenario_phase *ph = NULL;
+	unsigned int n = 0;
+	char *p, *opt, *save, **hook;
+	size_t len;
+	int ret = 0;
+
+	phases_cpus = cpu_count;
+
+	while ((ret == 0) && (fgets(line, sizeof(line), fp) != NULL)) {
+		n++;
+		for (p = line; isspace((unsigned char) *p); p++)
+			;
+		len = strcspn(p, "\r\n");
+		p[len] = '\0';
+		while ((len > 0) && (isspace((unsigned char) p[len - 1])))
+			p[--len] = '\0';
+		if ((*p == '\0') || (*p == '#'))
+			continue;
+
+		if (*p == '[') {
+			if ((len < 3) || (p[len - 1] != ']')) {
+				fprintf(stderr,
+					"cpuloadgen: %s:%u: invalid phase header!\n",
+					filename, n);
+				ret = -EINVAL;
+				break;
+			}
+			if ((ph != NULL) &&
+				(scenario_phase_check(filename, ph) != 0)) {
+				ret = -EINVAL;
+				break;
+			}
+			p[len - 1] = '\0';
+			ph = scenario_phase_add(p + 1, n);
+			if (ph == NULL)
+				ret = -ENOMEM;
+			continue;
+		}
+		if (ph == NULL) {
+			fprintf(stderr,
+				"cpuloadgen: %s:%u: option outside of phase!\n",
+				filename, n);
+			ret = -EINVAL;
+			break;
+		}
+
+		hook = NULL;
+		if (strncmp(p, "onstart=", 8) == 0)
+			hook = &ph->onstart;
+		else if (strncmp(p, "onstop=", 7) == 0)
+			hook = &ph->onstop;
+		if ((hook != NULL) && (!hooks)) {
+			fprintf(stderr,
+				"cpuloadgen: %s:%u: hooks refused (see hooks option)!\n",
+				filename, n);
+			ret = -EPERM;
+			break;
+		} else if (hook != NULL) {
+			p = strchr(p, '=') + 1;
+			if ((*p == '\0') || (*hook != NULL)) {
+				fprintf(stderr,
+					"cpuloadgen: %s:%u: invalid hook!\n",
+					filename, n);
+				ret = -EINVAL;
+				break;
+			}
+			*hook = strdup(p);
+			if (*hook == NULL)
+				ret = -ENOMEM;
+			continue;
+		}
+
+		for (opt = strtok_r(p, SCENARIO_DELIMS, &save); opt != NULL;
+			opt = strtok_r(NULL, SCENARIO_DELIMS, &save)) {
+			ret = scenario_option_parse(ph, opt);
+			if (ret != 0) {
+				fprintf(stderr,
+					"cpuloadgen: %s:%u: invalid option (%s)!\n",
+					filename, n, opt);
+				break;
+			}
+		}
+	}
+
+	if ((ret == 0) && (ph == NULL)) {
+		fprintf(stderr, "cpuloadgen: %s: no phase!\n", filename);
+		ret = -EINVAL;
+	} else if (ret == 0) {
+		ret = scenario_phase_check(filename, ph);
+	}
+	if (ret != 0) {
+		scenario_free();
+		return ret;
+	}
+	dprintf("%s(): %u phases loaded\n", __func__, phases_len);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_load
+ * @BRIEF		load and validate scenario file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		filename: scenario file name
+ * @param[in]		cpu_count: number of CPU cores
+ * @DESCRIPTION		load and validate scenario file (see scenario_parse()).
+ *//*------------------------------------------------------------------------ */
+int scenario_load(const char *filename, unsigned int cpu_count)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not open %s (%s)!\n",
+			filename, strerror(errno));
+		return ret;
+	}
+	ret = scenario_parse(fp, filename, cpu_count, 1);
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_load_buf
+ * @BRIEF		load and validate scenario from memory.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		name: scenario name (for error messages)
+ * @param[in]		buf: scenario file content
+ * @param[in]		len: scenario file content length
+ * @param[in]		cpu_count: number of CPU cores
+ * @param[in]		hooks: 1 to allow hooks (shell commands)
+ * @DESCRIPTION		load and validate scenario from memory (e.g. received
+ *			from coordinator, whose hooks must not run unless
+ *			explicitly allowed locally), see scenario_parse().
+ *//*------------------------------------------------------------------------ */
+int scenario_load_buf(const char *name, char *buf, size_t len,
+	unsigned int cpu_count, int hooks)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fmemopen(buf, len, "r");
+	if (fp == NULL)
+		return -errno;
+	ret = scenario_parse(fp, name, cpu_count, hooks);
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_len
+ * @BRIEF		return number of phases in scenario.
+ * @RETURNS		number of phases in scenario (0 if none)
+ * @DESCRIPTION		return number of phases in scenario.
+ *//*------------------------------------------------------------------------ */
+unsigned int scenario_len(void)
+{
+	return phases_len;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_get
+ * @BRIEF		return a given phase of scenario.
+ * @RETURNS		phase, NULL if out of range
+ * @param[in]		pos: phase position in scenario
+ * @DESCRIPTION		return a given phase of scenario.
+ *//*------------------------------------------------------------------------ */
+const scenario_phase *scenario_get(unsigned int pos)
+{
+	if (pos >= phases_len)
+		return NULL;
+
+	return &phases[pos];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_hook
+ * @BRIEF		run a phase hook.
+ * @RETURNS		0 on success
+ *			-ECHILD if hook could not run or failed
+ * @param[in]		cmd: shell command
+ * @DESCRIPTION		run a phase hook (shell command) and wait for its
+ *			completion. Failure is reported, not fatal.
+ *//*------------------------------------------------------------------------ */
+int scenario_hook(const char *cmd)
+{
+	int status;
+
+	fflush(stdout);
+	status = system(cmd);
+	if ((status == -1) || (!WIFEXITED(status)) ||
+		(WEXITSTATUS(status) != 0)) {
+		fprintf(stderr, "cpuloadgen: hook \"%s\" failed (%d)!\n",
+			cmd, status);
+		return -ECHILD;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scenario_free
+ * @BRIEF		release scenario.
+ * @DESCRIPTION		release scenario.
+ *//*------------------------------------------------------------------------ */
+void scenario_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < phases_len; i++) {
+		free(phases[i].loads);
+		free(phases[i].iowait_file);
+		free(phases[i].onstart);
+		free(phases[i].onstop);
+	}
+	free(phases);
+	phases = NULL;
+	phases_len = 0;
+}
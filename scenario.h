@@ -0,0 +1,91 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			scenario.h
+ * @Description			Multi-phase scenario file
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_SCENARIO_H__
+#define __CPULOADGEN_SCENARIO_H__
+
+
+#include <stddef.h>
+#include "dist.h"
+#include "tlb.h"
+#include "sysload.h"
+
+
+#define SCENARIO_NAME_MAX	32
+/* Longest PWM period (us), fitting load engine unsigned int periods */
+#define PERIOD_MAX_US		1000000000L
+
+
+/* Scenario phase. Unset options are -1 (0 for tlb_mb and percentages) */
+typedef struct {
+	char name[SCENARIO_NAME_MAX];
+	unsigned int line;
+	double duration_s;
+	int *loads;			/* per CPU core, -1 if not loaded */
+	long int period;		/* us */
+	int jitter_set;
+	dist jitter;
+	unsigned int tlb_mb;
+	tlb_pages tlb_backing;
+	int pingpong;			/* coherence_mode */
+	int syscall_pct;
+	sysload_mix syscall_mix;
+	int iowait_pct;
+	char *iowait_file;
+	int sample;			/* sampling: 1 on, 0 off, -1 unchanged */
+	char *onstart;			/* shell command */
+	char *onstop;			/* shell command */
+} scenario_phase;
+
+
+int scenario_load(const char *filename, unsigned int cpu_count);
+int scenario_load_buf(const char *name, char *buf, size_t len,
+	unsigned int cpu_count, int hooks);
+unsigned int scenario_len(void);
+const scenario_phase *scenario_get(unsigned int pos);
+int scenario_hook(const char *cmd);
+void scenario_free(void);
+
+
+#endif
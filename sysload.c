@@ -0,0 +1,519 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			sysload.c
+ * @Description			System call and I/O wait load
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "sysload.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define SYSLOAD_BLOCK_SIZE	4096
+#define SYSLOAD_PIPE_MSG	64
+#define SYSLOAD_IO_FILE_SIZE	(16 * 1024 * 1024)
+#define SYSLOAD_IO_TEMPLATE	"cpuloadgen-io.XXXXXX"
+#define SYSLOAD_RW_TEMPLATE	"/dev/shm/cpuloadgen-rw.XXXXXX"
+#define SYSLOAD_RW_FALLBACK	"/tmp/cpuloadgen-rw.XXXXXX"
+#define SYSLOAD_STAT		"/proc/stat"
+#define SYSLOAD_CPUS_MAX	1024
+#define SYSLOAD_LINE_MAX	256
+
+
+typedef struct {
+	unsigned long long user;
+	unsigned long long sys;
+	unsigned long long iowait;
+	unsigned long long idle;
+	unsigned long long steal;
+} sysload_times;
+
+
+static const char *mix_names[SYSLOAD_COUNT] = {
+	"getpid",
+	"rw",
+	"pipe",
+	"futex",
+	"all"
+};
+
+/* I/O wait file, shared by all threads */
+static char io_path[PATH_MAX];
+static int io_created = 0;
+static off_t io_blocks = 0;
+static int io_cached_warned = 0;
+
+/* Futex woken by all threads */
+static int futex_word = 0;
+
+/* /proc/stat times at start of run */
+static sysload_times stat_start[SYSLOAD_CPUS_MAX];
+
+/* Per-thread descriptors */
+static __thread int rw_fd = -1;
+static __thread int pipe_fd[2] = {-1, -1};
+static __thread int io_fd = -1;
+static __thread int io_direct = 0;
+static __thread void *io_buf = NULL;
+static __thread unsigned int mix_next = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_mix_parse
+ * @BRIEF		convert system call mix name into system call mix.
+ * @RETURNS		system call mix
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: system call mix name
+ * @DESCRIPTION		convert system call mix name into system call mix.
+ *//*------------------------------------------------------------------------ */
+int sysload_mix_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SYSLOAD_COUNT; i++) {
+		if (strcmp(name, mix_names[i]) == 0)
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_mix_name
+ * @BRIEF		return system call mix name.
+ * @RETURNS		system call mix name
+ * @param[in]		mix: system call mix
+ * @DESCRIPTION		return system call mix name.
+ *//*------------------------------------------------------------------------ */
+const char *sysload_mix_name(sysload_mix mix)
+{
+	if ((mix < 0) || (mix >= SYSLOAD_COUNT))
+		return "unknown";
+	return mix_names[mix];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_io_init
+ * @BRIEF		prepare I/O wait file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: file to read from, NULL to create a temporary
+ *				one in current directory
+ * @DESCRIPTION		prepare I/O wait file. The temporary file is filled
+ *			with data, as reading holes would not reach the
+ *			storage device.
+ *//*------------------------------------------------------------------------ */
+int sysload_io_init(const char *path)
+{
+	struct stat sb;
+	char *buf;
+	int fd, i, ret = 0;
+
+	if (path != NULL) {
+		if (stat(path, &sb) != 0) {
+			ret = -errno;
+			fprintf(stderr, "cpuloadgen: could not open %s (%s)!\n",
+				path, strerror(errno));
+			return ret;
+		}
+		if (sb.st_size < SYSLOAD_BLOCK_SIZE) {
+			fprintf(stderr, "cpuloadgen: %s is too small!\n", path);
+			return -EINVAL;
+		}
+		snprintf(io_path, sizeof(io_path), "%s", path);
+		io_blocks = sb.st_size / SYSLOAD_BLOCK_SIZE;
+		return 0;
+	}
+
+	snprintf(io_path, sizeof(io_path), "%s", SYSLOAD_IO_TEMPLATE);
+	fd = mkstemp(io_path);
+	if (fd < 0) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not create I/O file (%s)!\n",
+			strerror(errno));
+		return ret;
+	}
+	io_created = 1;
+	buf = malloc(SYSLOAD_BLOCK_SIZE);
+	if (buf == NULL) {
+		close(fd);
+		sysload_io_deinit();
+		return -ENOMEM;
+	}
+	memset(buf, 0xa5, SYSLOAD_BLOCK_SIZE);
+	for (i = 0; i < SYSLOAD_IO_FILE_SIZE / SYSLOAD_BLOCK_SIZE; i++) {
+		if (write(fd, buf, SYSLOAD_BLOCK_SIZE) != SYSLOAD_BLOCK_SIZE) {
+			ret = (errno != 0) ? -errno : -EIO;
+			break;
+		}
+	}
+	free(buf);
+	if ((ret == 0) && (fsync(fd) != 0))
+		ret = -errno;
+	close(fd);
+	if (ret != 0) {
+		fprintf(stderr, "cpuloadgen: could not write I/O file (%s)!\n",
+			strerror(-ret));
+		sysload_io_deinit();
+		return ret;
+	}
+	io_blocks = SYSLOAD_IO_FILE_SIZE / SYSLOAD_BLOCK_SIZE;
+	dprintf("%s(): %s created\n", __func__, io_path);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_io_deinit
+ * @BRIEF		release I/O wait file.
+ * @DESCRIPTION		release I/O wait file, removing it if temporary.
+ *//*------------------------------------------------------------------------ */
+void sysload_io_deinit(void)
+{
+	if (io_created)
+		unlink(io_path);
+	io_created = 0;
+	io_blocks = 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_thread_init
+ * @BRIEF		open calling thread descriptors.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		mix: system call mix
+ * @param[in]		io: open I/O wait file if != 0
+ * @DESCRIPTION		open calling thread descriptors: tmpfs file and pipe
+ *			used by system call mix, and I/O wait file, opened
+ *			with O_DIRECT so that reads block on the storage
+ *			device. If the file system does not support
+ *			O_DIRECT, page cache is dropped before each read.
+ *//*------------------------------------------------------------------------ */
+int sysload_thread_init(sysload_mix mix, int io)
+{
+	char path[] = SYSLOAD_RW_TEMPLATE;
+	char fallback[] = SYSLOAD_RW_FALLBACK;
+	int ret;
+
+	mix_next = 0;
+	if ((mix == SYSLOAD_RW) || (mix == SYSLOAD_ALL)) {
+		rw_fd = mkstemp(path);
+		if (rw_fd >= 0) {
+			unlink(path);
+		} else {
+			rw_fd = mkstemp(fallback);
+			if (rw_fd < 0)
+				goto err;
+			unlink(fallback);
+		}
+	}
+	if ((mix == SYSLOAD_PIPE) || (mix == SYSLOAD_ALL)) {
+		if (pipe(pipe_fd) != 0)
+			goto err;
+	}
+
+	if (io) {
+		if (posix_memalign(&io_buf, SYSLOAD_BLOCK_SIZE,
+			SYSLOAD_BLOCK_SIZE) != 0) {
+			io_buf = NULL;
+			errno = ENOMEM;
+			goto err;
+		}
+		io_direct = 1;
+		io_fd = open(io_path, O_RDONLY | O_DIRECT);
+		if ((io_fd < 0) && (errno == EINVAL)) {
+			io_direct = 0;
+			io_fd = open(io_path, O_RDONLY);
+			if ((io_fd >= 0) && (__sync_lock_test_and_set(
+				&io_cached_warned, 1) == 0))
+				fprintf(stderr,
+					"cpuloadgen: O_DIRECT not supported on %s, dropping page cache instead!\n",
+					io_path);
+		}
+		if (io_fd < 0)
+			goto err;
+	}
+
+	return 0;
+
+err:
+	ret = -errno;
+	fprintf(stderr, "cpuloadgen: could not open system call load files (%s)!\n",
+		strerror(errno));
+	sysload_thread_deinit();
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_thread_deinit
+ * @BRIEF		close calling thread descriptors.
+ * @DESCRIPTION		close calling thread descriptors.
+ *//*------------------------------------------------------------------------ */
+void sysload_thread_deinit(void)
+{
+	if (rw_fd >= 0)
+		close(rw_fd);
+	if (pipe_fd[0] >= 0)
+		close(pipe_fd[0]);
+	if (pipe_fd[1] >= 0)
+		close(pipe_fd[1]);
+	if (io_fd >= 0)
+		close(io_fd);
+	free(io_buf);
+	rw_fd = pipe_fd[0] = pipe_fd[1] = io_fd = -1;
+	io_buf = NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_call
+ * @BRIEF		perform a batch of system calls.
+ * @RETURNS		number of system calls performed
+ * @param[in]		mix: system call mix
+ * @param[in]		count: number of operations
+ * @DESCRIPTION		perform a batch of system calls: raw getpid() (not
+ *			cached by libc), 4K write and read back on a tmpfs
+ *			file, 64-byte write and read back through a pipe, or
+ *			wake of a futex shared by all threads (contending on
+ *			its hash bucket). All cycles through these.
+ *//*------------------------------------------------------------------------ */
+unsigned int sysload_call(sysload_mix mix, unsigned int count)
+{
+	static __thread char buf[SYSLOAD_BLOCK_SIZE];
+	unsigned int i, calls = 0;
+	sysload_mix m = mix;
+
+	for (i = 0; i < count; i++) {
+		if (mix == SYSLOAD_ALL)
+			m = (sysload_mix) (mix_next++ % SYSLOAD_ALL);
+		switch (m) {
+		case SYSLOAD_RW:
+			if (pwrite(rw_fd, buf, SYSLOAD_BLOCK_SIZE, 0) > 0)
+				calls++;
+			if (pread(rw_fd, buf, SYSLOAD_BLOCK_SIZE, 0) > 0)
+				calls++;
+			break;
+		case SYSLOAD_PIPE:
+			if (write(pipe_fd[1], buf, SYSLOAD_PIPE_MSG) > 0)
+				calls++;
+			if (read(pipe_fd[0], buf, SYSLOAD_PIPE_MSG) > 0)
+				calls++;
+			break;
+		case SYSLOAD_FUTEX:
+			syscall(SYS_futex, &futex_word, FUTEX_WAKE_PRIVATE,
+				INT_MAX, NULL, NULL, 0);
+			calls++;
+			break;
+		default:
+			syscall(SYS_getpid);
+			calls++;
+			break;
+		}
+	}
+
+	return calls;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_io_until
+ * @BRIEF		block on I/O until a given time.
+ * @RETURNS		number of reads performed
+ * @param[in]		deadline: absolute CLOCK_MONOTONIC time
+ * @param[in, out]	rng: calling thread random generator
+ * @DESCRIPTION		block on I/O until a given time: read random 4K
+ *			blocks of I/O wait file, one at a time. Last read
+ *			may end past deadline.
+ *//*------------------------------------------------------------------------ */
+unsigned int sysload_io_until(const struct timespec *deadline,
+	rng_state *rng)
+{
+	struct timespec now;
+	unsigned int reads = 0;
+	off_t off;
+
+	if ((io_fd < 0) || (io_blocks == 0))
+		return 0;
+
+	while (1) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec > deadline->tv_sec) ||
+			((now.tv_sec == deadline->tv_sec) &&
+			(now.tv_nsec >= deadline->tv_nsec)))
+			break;
+		off = (off_t) (rng_next(rng) % (uint64_t) io_blocks) *
+			SYSLOAD_BLOCK_SIZE;
+		if (!io_direct)
+			posix_fadvise(io_fd, off, SYSLOAD_BLOCK_SIZE,
+				POSIX_FADV_DONTNEED);
+		if (pread(io_fd, io_buf, SYSLOAD_BLOCK_SIZE, off) < 0)
+			break;
+		reads++;
+	}
+
+	return reads;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_stat_read
+ * @BRIEF		read CPU times of all CPU cores.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu_count: number of CPU cores
+ * @param[out]		times: CPU times (in clock ticks), cpu_count entries
+ * @DESCRIPTION		read CPU times of all CPU cores from /proc/stat.
+ *			Offline CPU cores are left untouched.
+ *//*------------------------------------------------------------------------ */
+static int sysload_stat_read(unsigned int cpu_count, sysload_times *times)
+{
+	unsigned long long user, nice, sys, idle, iowait, irq, softirq, steal;
+	char line[SYSLOAD_LINE_MAX];
+	unsigned int cpu;
+	FILE *fp;
+
+	fp = fopen(SYSLOAD_STAT, "r");
+	if (fp == NULL)
+		return -errno;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		steal = 0;
+		if (sscanf(line, "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu",
+			&cpu, &user, &nice, &sys, &idle, &iowait, &irq,
+			&softirq, &steal) < 8)
+			continue;
+		if (cpu >= cpu_count)
+			continue;
+		times[cpu].user = user + nice;
+		times[cpu].sys = sys + irq + softirq;
+		times[cpu].iowait = iowait;
+		times[cpu].idle = idle;
+		times[cpu].steal = steal;
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_stat_start
+ * @BRIEF		save CPU times of all CPU cores at start of run.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu_count: number of CPU cores
+ * @DESCRIPTION		save CPU times of all CPU cores at start of run.
+ *//*------------------------------------------------------------------------ */
+int sysload_stat_start(unsigned int cpu_count)
+{
+	if (cpu_count > SYSLOAD_CPUS_MAX)
+		cpu_count = SYSLOAD_CPUS_MAX;
+	memset(stat_start, 0, sizeof(stat_start));
+
+	return sysload_stat_read(cpu_count, stat_start);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		sysload_stat_split
+ * @BRIEF		compute CPU time split of a CPU core since start of run.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu: CPU core ID
+ * @param[out]		split: user/system/iowait/idle split
+ * @DESCRIPTION		compute CPU time split of a CPU core since
+ *			sysload_stat_start() call, from /proc/stat. Includes
+ *			time spent by any task on the CPU core, not only
+ *			load threads.
+ *//*------------------------------------------------------------------------ */
+int sysload_stat_split(unsigned int cpu, sysload_split *split)
+{
+	sysload_times now[SYSLOAD_CPUS_MAX];
+	unsigned long long user, sys, iowait, idle, total;
+	int ret;
+
+	if (cpu >= SYSLOAD_CPUS_MAX)
+		return -EINVAL;
+	memset(&now[cpu], 0, sizeof(sysload_times));
+	ret = sysload_stat_read(cpu + 1, now);
+	if (ret != 0)
+		return ret;
+
+	user = now[cpu].user - stat_start[cpu].user;
+	sys = now[cpu].sys - stat_start[cpu].sys;
+	/* With NOHZ, idle and iowait counters may go slightly backwards */
+	iowait = (now[cpu].iowait >= stat_start[cpu].iowait) ?
+		now[cpu].iowait - stat_start[cpu].iowait : 0;
+	idle = (now[cpu].idle >= stat_start[cpu].idle) ?
+		now[cpu].idle - stat_start[cpu].idle : 0;
+	total = user + sys + iowait + idle +
+		(now[cpu].steal - stat_start[cpu].steal);
+	if (total == 0)
+		return -EAGAIN;
+
+	split->user_pct = 100.0 * (double) user / (double) total;
+	split->sys_pct = 100.0 * (double) sys / (double) total;
+	split->iowait_pct = 100.0 * (double) iowait / (double) total;
+	split->idle_pct = 100.0 * (double) idle / (double) total;
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			sysload.h
+ * @Description			System call and I/O wait load
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_SYSLOAD_H__
+#define __CPULOADGEN_SYSLOAD_H__
+
+
+#include <time.h>
+#include "dist.h"
+
+
+typedef enum {
+	SYSLOAD_GETPID,
+	SYSLOAD_RW,
+	SYSLOAD_PIPE,
+	SYSLOAD_FUTEX,
+	SYSLOAD_ALL,
+	SYSLOAD_COUNT
+} sysload_mix;
+
+
+/* CPU time split of a CPU core, in percent of elapsed time */
+typedef struct {
+	double user_pct;	/* user and nice */
+	double sys_pct;		/* system, irq and softirq */
+	double iowait_pct;
+	double idle_pct;
+} sysload_split;
+
+
+int sysload_mix_parse(const char *name);
+const char *sysload_mix_name(sysload_mix mix);
+int sysload_io_init(const char *path);
+void sysload_io_deinit(void);
+int sysload_thread_init(sysload_mix mix, int io);
+void sysload_thread_deinit(void);
+unsigned int sysload_call(sysload_mix mix, unsigned int count);
+unsigned int sysload_io_until(const struct timespec *deadline,
+	rng_state *rng);
+int sysload_stat_start(unsigned int cpu_count);
+int sysload_stat_split(unsigned int cpu, sysload_split *split);
+
+
+#endif
@@ -0,0 +1,293 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			tlb.c
+ * @Description			TLB pressure kernel
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include "tlb.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+#define TLB_PAGE_SIZE		4096UL
+#define TLB_HUGE_PAGE_SIZE	(2UL * 1024 * 1024)
+#define TLB_CACHE_LINE		64UL
+#define TLB_LINES_PER_PAGE	(TLB_PAGE_SIZE / TLB_CACHE_LINE)
+#define TLB_MEMINFO		"/proc/meminfo"
+#define TLB_THP_ENABLED		"/sys/kernel/mm/transparent_hugepage/enabled"
+#define TLB_LINE_MAX		128
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB		0x40000
+#endif
+
+
+static const char *tlb_names[TLB_PAGES_COUNT] = {
+	"4k",
+	"thp",
+	"huge"
+};
+
+/* Per-thread mapping, and current position in pointer chain */
+static __thread void *map = NULL;
+static __thread size_t map_size = 0;
+static __thread void **pos = NULL;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_pages_parse
+ * @BRIEF		convert page backing name into page backing.
+ * @RETURNS		page backing
+ *			-EINVAL in case of unknown name
+ * @param[in]		name: page backing name
+ * @DESCRIPTION		convert page backing name into page backing.
+ *//*------------------------------------------------------------------------ */
+int tlb_pages_parse(const char *name)
+{
+	int i;
+
+	for (i = 0; i < TLB_PAGES_COUNT; i++) {
+		if (strcmp(name, tlb_names[i]) == 0)
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_pages_name
+ * @BRIEF		return page backing name.
+ * @RETURNS		page backing name
+ * @param[in]		pages: page backing
+ * @DESCRIPTION		return page backing name.
+ *//*------------------------------------------------------------------------ */
+const char *tlb_pages_name(tlb_pages pages)
+{
+	if ((pages < 0) || (pages >= TLB_PAGES_COUNT))
+		return "unknown";
+	return tlb_names[pages];
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_check
+ * @BRIEF		check page backing is available.
+ * @RETURNS		0 on success
+ *			-ENOMEM if not enough huge pages are reserved
+ * @param[in]		pages: page backing
+ * @param[in]		footprint: per-thread footprint (in bytes)
+ * @param[in]		threads: number of load threads
+ * @DESCRIPTION		check page backing is available: explicit huge pages
+ *			must be reserved beforehand (vm.nr_hugepages). Only
+ *			warn if THP is disabled, as mapping still works.
+ *//*------------------------------------------------------------------------ */
+int tlb_check(tlb_pages pages, size_t footprint, unsigned int threads)
+{
+	char line[TLB_LINE_MAX];
+	unsigned long long free_pages = 0, page_kb = 0, needed;
+	FILE *fp;
+
+	if (pages == TLB_PAGES_THP) {
+		fp = fopen(TLB_THP_ENABLED, "r");
+		if ((fp == NULL) || (fgets(line, sizeof(line), fp) == NULL) ||
+			(strstr(line, "[never]") != NULL))
+			fprintf(stderr,
+				"cpuloadgen: transparent huge pages not available, 4k pages may be used!\n");
+		if (fp != NULL)
+			fclose(fp);
+		return 0;
+	} else if (pages != TLB_PAGES_HUGETLB) {
+		return 0;
+	}
+
+	fp = fopen(TLB_MEMINFO, "r");
+	if (fp == NULL)
+		return -errno;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		sscanf(line, "HugePages_Free: %llu", &free_pages);
+		sscanf(line, "Hugepagesize: %llu", &page_kb);
+	}
+	fclose(fp);
+
+	needed = threads * ((footprint + TLB_HUGE_PAGE_SIZE - 1) /
+		TLB_HUGE_PAGE_SIZE);
+	if ((page_kb * 1024 != TLB_HUGE_PAGE_SIZE) || (free_pages < needed)) {
+		fprintf(stderr,
+			"cpuloadgen: %llu free 2MB huge pages needed, %llu available (see /proc/sys/vm/nr_hugepages)!\n",
+			needed, (page_kb * 1024 == TLB_HUGE_PAGE_SIZE) ?
+			free_pages : 0);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_thread_init
+ * @BRIEF		allocate and link calling thread buffer.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		footprint: buffer size (in bytes)
+ * @param[in]		pages: page backing
+ * @param[in, out]	rng: calling thread random generator
+ * @DESCRIPTION		allocate calling thread buffer (first touched by
+ *			this thread, hence local to its NUMA node), and link
+ *			one cache line per 4K page, at random offset, into a
+ *			single random cycle (Sattolo's algorithm), so that
+ *			each access depends on the previous one and likely
+ *			misses the TLB.
+ *//*------------------------------------------------------------------------ */
+int tlb_thread_init(size_t footprint, tlb_pages pages, rng_state *rng)
+{
+	uint32_t *perm;
+	size_t count, i, j, tmp;
+	uintptr_t base;
+	void **node;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	int ret;
+
+	count = footprint / TLB_PAGE_SIZE;
+	if (count < 2)
+		return -EINVAL;
+
+	map_size = footprint;
+	if (pages == TLB_PAGES_HUGETLB) {
+		map_size = (footprint + TLB_HUGE_PAGE_SIZE - 1) &
+			~(TLB_HUGE_PAGE_SIZE - 1);
+		flags |= MAP_HUGETLB;
+	} else if (pages == TLB_PAGES_THP) {
+		/* Room to align on huge page boundary */
+		map_size = footprint + TLB_HUGE_PAGE_SIZE;
+	}
+	map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (map == MAP_FAILED) {
+		ret = -errno;
+		fprintf(stderr, "cpuloadgen: could not map %zu bytes of %s pages (%s)!\n",
+			map_size, tlb_names[pages], strerror(errno));
+		map = NULL;
+		return ret;
+	}
+	base = (uintptr_t) map;
+	if (pages == TLB_PAGES_THP) {
+		base = (base + TLB_HUGE_PAGE_SIZE - 1) &
+			~(TLB_HUGE_PAGE_SIZE - 1);
+		madvise((void *) base, footprint, MADV_HUGEPAGE);
+	} else if (pages == TLB_PAGES_4K) {
+		madvise(map, map_size, MADV_NOHUGEPAGE);
+	}
+
+	perm = malloc(count * sizeof(uint32_t));
+	if (perm == NULL) {
+		munmap(map, map_size);
+		map = NULL;
+		return -ENOMEM;
+	}
+	for (i = 0; i < count; i++)
+		perm[i] = i;
+	for (i = count - 1; i > 0; i--) {
+		j = rng_next(rng) % i;
+		tmp = perm[i];
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+
+	/* Node of page i is at a random cache line of page i */
+	for (i = 0; i < count; i++) {
+		node = (void **) (base + perm[i] * TLB_PAGE_SIZE +
+			(perm[i] % TLB_LINES_PER_PAGE) * TLB_CACHE_LINE);
+		*node = (void *) (base + perm[(i + 1) % count] * TLB_PAGE_SIZE +
+			(perm[(i + 1) % count] % TLB_LINES_PER_PAGE) *
+			TLB_CACHE_LINE);
+	}
+	pos = (void **) (base + perm[0] * TLB_PAGE_SIZE +
+		(perm[0] % TLB_LINES_PER_PAGE) * TLB_CACHE_LINE);
+	free(perm);
+	dprintf("%s(): %zu pages linked (%s)\n", __func__, count,
+		tlb_names[pages]);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_thread_deinit
+ * @BRIEF		release calling thread buffer.
+ * @DESCRIPTION		release calling thread buffer.
+ *//*------------------------------------------------------------------------ */
+void tlb_thread_deinit(void)
+{
+	if (map != NULL)
+		munmap(map, map_size);
+	map = NULL;
+	pos = NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tlb_chase
+ * @BRIEF		follow calling thread pointer chain.
+ * @param[in]		count: number of accesses
+ * @DESCRIPTION		follow calling thread pointer chain (dependent loads,
+ *			one page apart).
+ *//*------------------------------------------------------------------------ */
+void tlb_chase(unsigned int count)
+{
+	void **p = pos;
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		p = (void **) *(void * volatile *) p;
+	pos = p;
+}
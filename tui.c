@@ -0,0 +1,738 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			tui.c
+ * @Description			Live per-core load heatmap terminal view
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include "tui.h"
+#include "metrics.h"
+#include "hotplug.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+#define TUI_PATH_MAX		320
+#define TUI_ZONES_MAX		16
+#define TUI_TEMP_INPUTS_MAX	128
+#define TUI_CELL_WIDTH		14
+#define TUI_CELL_BYTES		512	/* 4 lines with escape sequences */
+#define TUI_SCREEN_BYTES	1024	/* header */
+#define TUI_DEFAULT_COLUMNS	80
+
+
+/* 256-color palette heat ramp, from idle (dark green) to loaded (red) */
+static const unsigned char heat_ramp[] = {
+	22, 28, 34, 40, 76, 112, 148, 184, 178, 172, 166, 160, 196};
+#define HEAT_LEVELS	(sizeof(heat_ramp) / sizeof(heat_ramp[0]))
+
+typedef struct {
+	unsigned int cpu;
+	char temp_path[TUI_PATH_MAX];	/* coretemp input, "" if none */
+	double busy_s;			/* CPU time of its load threads */
+	double achieved;		/* %, -1 until first refresh */
+} tui_core;
+
+
+static tui_core *cores = NULL;
+static unsigned int core_count = 0;
+static unsigned int selected = 0;
+static unsigned int tui_threads_per_cpu;
+static int *tui_setpoints;
+static void (*tui_quit)(void);
+static char zones[TUI_ZONES_MAX][TUI_PATH_MAX];
+static unsigned int zone_count = 0;
+static char *screen = NULL;
+static size_t screen_size, screen_len;
+static struct timespec refresh_last;
+static struct termios saved_termios;
+static int termios_saved = 0;
+static pthread_t tui_thread;
+static int tui_running = 0;
+static volatile int tui_halt = 0;
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		read_ull
+ * @BRIEF		read an unsigned integer from a sysfs file.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		path: sysfs file path
+ * @param[out]		val: value read
+ * @DESCRIPTION		read an unsigned integer from a sysfs file.
+ *//*------------------------------------------------------------------------ */
+static int read_ull(const char *path, unsigned long long *val)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -errno;
+	ret = (fscanf(fp, "%llu", val) == 1) ? 0 : -EIO;
+	fclose(fp);
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_write
+ * @BRIEF		write a string to the terminal.
+ * @param[in]		str: string
+ * @param[in]		len: string length
+ * @DESCRIPTION		write a string to the terminal, in as few write()
+ *			calls as possible so that frames are not torn.
+ *//*------------------------------------------------------------------------ */
+static void tui_write(const char *str, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = write(STDOUT_FILENO, str, len);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		str += ret;
+		len -= ret;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		scr_printf
+ * @BRIEF		append formatted text to the frame being built.
+ * @param[in]		format: printf() format
+ * @DESCRIPTION		append formatted text to the frame being built,
+ *			truncating it if the frame buffer is full.
+ *//*------------------------------------------------------------------------ */
+static void scr_printf(const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	if (screen_len >= screen_size - 1)
+		return;
+	va_start(args, format);
+	n = vsnprintf(screen + screen_len, screen_size - screen_len, format,
+		args);
+	va_end(args);
+	if (n < 0)
+		return;
+	screen_len += (size_t) n;
+	if (screen_len > screen_size - 1)
+		screen_len = screen_size - 1;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		temp_discover
+ * @BRIEF		find the per-core temperature input of a CPU core.
+ * @param[in, out]	c: CPU core
+ * @DESCRIPTION		find the coretemp hwmon "Core <n>" input matching
+ *			CPU core topology (core ID, within its package).
+ *			Leaves temp_path empty if there is none (e.g. not
+ *			x86), thermal zones being used instead.
+ *//*------------------------------------------------------------------------ */
+static void temp_discover(tui_core *c)
+{
+	char path[TUI_PATH_MAX], link[TUI_PATH_MAX], name[16];
+	unsigned long long core_id, package_id;
+	unsigned int i, id;
+	struct dirent *d;
+	ssize_t len;
+	FILE *fp;
+	DIR *dir;
+	char *p;
+	int ret;
+
+	c->temp_path[0] = '\0';
+	snprintf(path, sizeof(path),
+		"/sys/devices/system/cpu/cpu%u/topology/core_id", c->cpu);
+	if (read_ull(path, &core_id) != 0)
+		return;
+	snprintf(path, sizeof(path),
+		"/sys/devices/system/cpu/cpu%u/topology/physical_package_id",
+		c->cpu);
+	if (read_ull(path, &package_id) != 0)
+		return;
+
+	dir = opendir("/sys/class/hwmon");
+	if (dir == NULL)
+		return;
+	while ((c->temp_path[0] == '\0') && ((d = readdir(dir)) != NULL)) {
+		if (strncmp(d->d_name, "hwmon", 5) != 0)
+			continue;
+		snprintf(path, sizeof(path), "/sys/class/hwmon/%s/name",
+			d->d_name);
+		fp = fopen(path, "r");
+		if (fp == NULL)
+			continue;
+		ret = fscanf(fp, "%15s", name);
+		fclose(fp);
+		if ((ret != 1) || (strcmp(name, "coretemp") != 0))
+			continue;
+		/* One coretemp device per package: coretemp.<package> */
+		snprintf(path, sizeof(path), "/sys/class/hwmon/%s/device",
+			d->d_name);
+		len = readlink(path, link, sizeof(link) - 1);
+		if (len <= 0)
+			continue;
+		link[len] = '\0';
+		p = strrchr(link, '.');
+		if ((p == NULL) ||
+			(strtoull(p + 1, NULL, 10) != package_id))
+			continue;
+		for (i = 1; i < TUI_TEMP_INPUTS_MAX; i++) {
+			snprintf(path, sizeof(path),
+				"/sys/class/hwmon/%s/temp%u_label", d->d_name, i);
+			fp = fopen(path, "r");
+			if (fp == NULL)
+				continue;
+			ret = fscanf(fp, "Core %u", &id);
+			fclose(fp);
+			if ((ret == 1) && (id == core_id)) {
+				snprintf(c->temp_path, sizeof(c->temp_path),
+					"/sys/class/hwmon/%s/temp%u_input",
+					d->d_name, i);
+				break;
+			}
+		}
+	}
+	closedir(dir);
+	dprintf("%s(): CPU%u temperature: %s\n", __func__, c->cpu,
+		c->temp_path);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		zones_discover
+ * @BRIEF		find thermal zones.
+ * @DESCRIPTION		find thermal zones, whose maximum temperature is shown
+ *			for CPU cores without a per-core temperature input.
+ *//*------------------------------------------------------------------------ */
+static void zones_discover(void)
+{
+	unsigned long long val;
+	struct dirent *d;
+	DIR *dir;
+
+	zone_count = 0;
+	dir = opendir("/sys/class/thermal");
+	if (dir == NULL)
+		return;
+	while ((zone_count < TUI_ZONES_MAX) && ((d = readdir(dir)) != NULL)) {
+		if (strncmp(d->d_name, "thermal_zone", 12) != 0)
+			continue;
+		snprintf(zones[zone_count], TUI_PATH_MAX,
+			"/sys/class/thermal/%s/temp", d->d_name);
+		if (read_ull(zones[zone_count], &val) == 0)
+			zone_count++;
+	}
+	closedir(dir);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		temp_read
+ * @BRIEF		read temperature of a CPU core.
+ * @RETURNS		temperature (millidegree Celsius), -1 if not available
+ * @param[in]		c: CPU core
+ * @DESCRIPTION		read temperature of a CPU core: its own coretemp
+ *			input, or the maximum of all thermal zones.
+ *//*------------------------------------------------------------------------ */
+static long long temp_read(const tui_core *c)
+{
+	unsigned long long val;
+	long long max = -1;
+	unsigned int i;
+
+	if ((c->temp_path[0] != '\0') && (read_ull(c->temp_path, &val) == 0))
+		return (long long) val;
+	for (i = 0; i < zone_count; i++) {
+		if ((read_ull(zones[i], &val) == 0) && ((long long) val > max))
+			max = (long long) val;
+	}
+
+	return max;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		core_busy_s
+ * @BRIEF		read CPU time of the load threads of a CPU core.
+ * @RETURNS		CPU time of all load threads of CPU core, in seconds
+ * @param[in]		cpu: CPU core
+ * @DESCRIPTION		read CPU time of all load threads of a CPU core, from
+ *			their live counters (never written from here).
+ *//*------------------------------------------------------------------------ */
+static double core_busy_s(unsigned int cpu)
+{
+	metrics_worker *w;
+	double busy_s = 0.0;
+	unsigned int t;
+
+	for (t = 0; t < tui_threads_per_cpu; t++) {
+		w = metrics_worker_get(cpu * tui_threads_per_cpu + t);
+		if (w != NULL)
+			busy_s += metrics_worker_busy_s(w);
+	}
+
+	return busy_s;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_sample
+ * @BRIEF		update achieved load of all CPU cores.
+ * @DESCRIPTION		update achieved load of all CPU cores: CPU time of
+ *			their load threads since last refresh, over elapsed
+ *			time.
+ *//*------------------------------------------------------------------------ */
+static void tui_sample(void)
+{
+	struct timespec now;
+	double elapsed_s, busy_s;
+	unsigned int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_s = (double) (now.tv_sec - refresh_last.tv_sec) +
+		(double) (now.tv_nsec - refresh_last.tv_nsec) * 1.0e-9;
+	refresh_last = now;
+	for (i = 0; i < core_count; i++) {
+		busy_s = core_busy_s(cores[i].cpu);
+		if (elapsed_s > 0.0)
+			cores[i].achieved = 100.0 *
+				(busy_s - cores[i].busy_s) / elapsed_s;
+		cores[i].busy_s = busy_s;
+	}
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_draw
+ * @BRIEF		draw a frame.
+ * @DESCRIPTION		draw a frame: one heatmap cell per CPU core (name,
+ *			requested and achieved load or "off" if offline or out
+ *			of cpuset, frequency, temperature),
+ *			wrapped to terminal width. The whole frame is written
+ *			at once, overwriting the previous one in place.
+ *//*------------------------------------------------------------------------ */
+static void tui_draw(void)
+{
+	unsigned int i, row, columns, level;
+	unsigned long long khz;
+	char path[TUI_PATH_MAX];
+	struct winsize ws;
+	long long temp;
+	tui_core *c;
+	int setpoint;
+
+	columns = TUI_DEFAULT_COLUMNS;
+	if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) && (ws.ws_col > 0))
+		columns = ws.ws_col;
+	columns /= TUI_CELL_WIDTH;
+	if (columns == 0)
+		columns = 1;
+
+	screen_len = 0;
+	scr_printf("\033[H\033[1mcpuloadgen\033[0m: requested -> achieved load, frequency, temperature\033[K\n");
+	scr_printf("left/right: select core, up/down or +/-: %d%% step, 1-9: 10-90%%, 0: 100%%, q: quit\033[K\n\033[K\n",
+		TUI_STEP);
+
+	for (row = 0; row < core_count; row += columns) {
+		/* CPU core name, highlighted if selected */
+		for (i = row; (i < core_count) && (i < row + columns); i++) {
+			scr_printf((i == selected) ? "\033[7m" : "\033[1m");
+			scr_printf(" CPU%-*u\033[0m ", TUI_CELL_WIDTH - 5,
+				cores[i].cpu);
+		}
+		scr_printf("\033[K\n");
+
+		/* Requested and achieved load, on achieved load color */
+		for (i = row; (i < core_count) && (i < row + columns); i++) {
+			c = &cores[i];
+			setpoint = __atomic_load_n(&tui_setpoints[c->cpu],
+				__ATOMIC_RELAXED);
+			if (!hotplug_cpu_available(c->cpu)) {
+				scr_printf(" %3d -> off   ", setpoint);
+				continue;
+			}
+			if (c->achieved < 0.0) {
+				scr_printf(" %3d ->   -%%  ", setpoint);
+				continue;
+			}
+			level = (unsigned int) (c->achieved *
+				(double) (HEAT_LEVELS - 1) / 100.0 + 0.5);
+			if (level >= HEAT_LEVELS)
+				level = HEAT_LEVELS - 1;
+			scr_printf("\033[48;5;%um\033[38;5;%um %3d -> %3.0f%% \033[0m ",
+				heat_ramp[level],
+				(level < HEAT_LEVELS / 3) ? 231 : 16, setpoint,
+				c->achieved);
+		}
+		scr_printf("\033[K\n");
+
+		/* Current frequency */
+		for (i = row; (i < core_count) && (i < row + columns); i++) {
+			snprintf(path, sizeof(path),
+				"/sys/devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq",
+				cores[i].cpu);
+			if (read_ull(path, &khz) == 0)
+				scr_printf(" %5llu MHz    ", khz / 1000);
+			else
+				scr_printf("     - MHz    ");
+		}
+		scr_printf("\033[K\n");
+
+		/* Temperature */
+		for (i = row; (i < core_count) && (i < row + columns); i++) {
+			temp = temp_read(&cores[i]);
+			if (temp >= 0)
+				scr_printf(" %5.1f C      ", (double) temp / 1000.0);
+			else
+				scr_printf("     - C      ");
+		}
+		scr_printf("\033[K\n\033[K\n");
+	}
+
+	scr_printf("\033[J");
+
+	tui_write(screen, screen_len);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		setpoint_set
+ * @BRIEF		change requested load of selected CPU core.
+ * @param[in]		load: new requested load (clamped to [1-100])
+ * @DESCRIPTION		change requested load of selected CPU core. Load
+ *			threads pick it up at their next PWM period.
+ *//*------------------------------------------------------------------------ */
+static void setpoint_set(int load)
+{
+	if (load < 1)
+		load = 1;
+	else if (load > 100)
+		load = 100;
+	__atomic_store_n(&tui_setpoints[cores[selected].cpu], load,
+		__ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_keys
+ * @BRIEF		handle key presses.
+ * @RETURNS		1 if frame needs redrawing, 0 otherwise
+ * @param[in]		buf: bytes read from terminal
+ * @param[in]		len: number of bytes
+ * @DESCRIPTION		handle key presses: select CPU core (arrows, h/l),
+ *			change its requested load (+/-, up/down arrows,
+ *			digits) or quit (q).
+ *//*------------------------------------------------------------------------ */
+static int tui_keys(const char *buf, size_t len)
+{
+	int load, redraw = 0;
+	size_t i;
+	char key;
+
+	for (i = 0; i < len; i++) {
+		key = buf[i];
+		/* Arrow keys: ESC [ A-D, mapped to k/j/l/h */
+		if ((key == '\033') && (i + 2 < len) && (buf[i + 1] == '[')) {
+			switch (buf[i + 2]) {
+			case 'A':
+				key = 'k';
+				break;
+			case 'B':
+				key = 'j';
+				break;
+			case 'C':
+				key = 'l';
+				break;
+			case 'D':
+				key = 'h';
+				break;
+			}
+			i += 2;
+		}
+		load = __atomic_load_n(&tui_setpoints[cores[selected].cpu],
+			__ATOMIC_RELAXED);
+		switch (key) {
+		case 'h':
+			selected = (selected + core_count - 1) % core_count;
+			break;
+		case 'l':
+			selected = (selected + 1) % core_count;
+			break;
+		case '+':
+		case '=':
+		case 'k':
+			setpoint_set(load + TUI_STEP);
+			break;
+		case '-':
+		case '_':
+		case 'j':
+			setpoint_set(load - TUI_STEP);
+			break;
+		case '0':
+			setpoint_set(100);
+			break;
+		case 'q':
+		case 'Q':
+			if (tui_quit != NULL)
+				tui_quit();
+			break;
+		default:
+			if ((key >= '1') && (key <= '9'))
+				setpoint_set((key - '0') * 10);
+			else
+				continue;
+		}
+		redraw = 1;
+	}
+
+	return redraw;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_main
+ * @BRIEF		TUI thread.
+ * @RETURNS		NULL
+ * @param[in]		ptr: unused
+ * @DESCRIPTION		TUI thread: refresh frame every TUI_REFRESH_MS,
+ *			handling key presses meanwhile. Termination signals
+ *			are left to other threads, so that main thread wakes
+ *			up on CTRL+C.
+ *//*------------------------------------------------------------------------ */
+static void *tui_main(void *ptr)
+{
+	struct timespec next, now;
+	struct pollfd pfd;
+	char buf[64];
+	sigset_t set;
+	ssize_t len;
+	long ms;
+
+	(void) ptr;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!tui_halt) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		ms = (long) (next.tv_sec - now.tv_sec) * 1000L +
+			(next.tv_nsec - now.tv_nsec) / 1000000L;
+		if (ms <= 0) {
+			tui_sample();
+			tui_draw();
+			next = now;
+			next.tv_nsec += TUI_REFRESH_MS * 1000000L;
+			next.tv_sec += next.tv_nsec / 1000000000L;
+			next.tv_nsec %= 1000000000L;
+			continue;
+		}
+		pfd.fd = STDIN_FILENO;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, (int) ms) <= 0)
+			continue;
+		len = read(STDIN_FILENO, buf, sizeof(buf));
+		if ((len > 0) && (tui_keys(buf, (size_t) len)))
+			tui_draw();
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_release
+ * @BRIEF		restore terminal and release TUI resources.
+ * @DESCRIPTION		restore terminal (main screen, cursor, line mode)
+ *			and release TUI resources.
+ *//*------------------------------------------------------------------------ */
+static void tui_release(void)
+{
+	static const char leave[] = "\033[?25h\033[?1049l";
+
+	if (termios_saved) {
+		tui_write(leave, sizeof(leave) - 1);
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+		termios_saved = 0;
+	}
+	free(screen);
+	screen = NULL;
+	free(cores);
+	cores = NULL;
+	core_count = 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_start
+ * @BRIEF		start live per-core load heatmap.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[in]		cpu_count: number of CPU cores
+ * @param[in]		threads_per_cpu: number of load threads per CPU core
+ * @param[in, out]	setpoints: requested load of each CPU core (-1 if
+ *			not loaded), changed by key presses
+ * @param[in]		quit: callback called when quit key is pressed
+ * @DESCRIPTION		start live per-core load heatmap of loaded CPU cores,
+ *			on the alternate screen of the terminal, from its
+ *			own thread. Achieved load is derived from load
+ *			threads live counters (metrics_start()), which are
+ *			only read: load threads are never disturbed.
+ *//*------------------------------------------------------------------------ */
+int tui_start(unsigned int cpu_count, unsigned int threads_per_cpu,
+	int *setpoints, void (*quit)(void))
+{
+	static const char enter[] = "\033[?1049h\033[?25l\033[2J";
+	struct termios raw;
+	unsigned int i;
+	int ret;
+
+	if ((!isatty(STDIN_FILENO)) || (!isatty(STDOUT_FILENO))) {
+		fprintf(stderr, "cpuloadgen: tui requires a terminal!\n");
+		return -ENOTTY;
+	}
+
+	cores = calloc(cpu_count, sizeof(tui_core));
+	if (cores == NULL)
+		return -ENOMEM;
+	core_count = 0;
+	for (i = 0; i < cpu_count; i++) {
+		if (setpoints[i] == -1)
+			continue;
+		cores[core_count].cpu = i;
+		cores[core_count].achieved = -1.0;
+		temp_discover(&cores[core_count]);
+		core_count++;
+	}
+	if (core_count == 0) {
+		tui_release();
+		return -EINVAL;
+	}
+	zones_discover();
+	screen_size = TUI_SCREEN_BYTES + core_count * TUI_CELL_BYTES;
+	screen = malloc(screen_size);
+	if (screen == NULL) {
+		tui_release();
+		return -ENOMEM;
+	}
+	selected = 0;
+	tui_threads_per_cpu = threads_per_cpu;
+	tui_setpoints = setpoints;
+	tui_quit = quit;
+
+	if (tcgetattr(STDIN_FILENO, &saved_termios) != 0) {
+		ret = -errno;
+		tui_release();
+		return ret;
+	}
+	raw = saved_termios;
+	raw.c_lflag &= ~(ICANON | ECHO);
+	raw.c_cc[VMIN] = 0;
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+		ret = -errno;
+		tui_release();
+		return ret;
+	}
+	termios_saved = 1;
+	fflush(stdout);
+	tui_write(enter, sizeof(enter) - 1);
+
+	for (i = 0; i < core_count; i++)
+		cores[i].busy_s = core_busy_s(cores[i].cpu);
+	clock_gettime(CLOCK_MONOTONIC, &refresh_last);
+
+	tui_halt = 0;
+	ret = pthread_create(&tui_thread, NULL, tui_main, NULL);
+	if (ret != 0) {
+		tui_release();
+		return -ret;
+	}
+	tui_running = 1;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		tui_stop
+ * @BRIEF		stop live per-core load heatmap.
+ * @DESCRIPTION		stop live per-core load heatmap thread and restore
+ *			terminal, so that reports are printed on the main
+ *			screen. Does nothing if not started.
+ *//*------------------------------------------------------------------------ */
+void tui_stop(void)
+{
+	if (!tui_running)
+		return;
+	tui_halt = 1;
+	pthread_join(tui_thread, NULL);
+	tui_running = 0;
+	tui_release();
+}
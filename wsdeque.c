@@ -0,0 +1,218 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			wsdeque.c
+ * @Description			Lock-free work-stealing deque
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "wsdeque.h"
+
+
+/* #define DEBUG */
+#ifdef DEBUG
+#define dprintf(format, ...)	 printf(format, ## __VA_ARGS__)
+#else
+#define dprintf(format, ...)
+#endif
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_init
+ * @BRIEF		initialise a work-stealing deque.
+ * @RETURNS		0 on success
+ *			-errno in case of failure
+ * @param[out]		q: deque
+ * @param[in]		size: deque capacity (power of 2)
+ * @DESCRIPTION		initialise a work-stealing deque.
+ *//*------------------------------------------------------------------------ */
+int wsdeque_init(wsdeque *q, long size)
+{
+	if ((size < 2) || ((size & (size - 1)) != 0))
+		return -EINVAL;
+
+	q->buf = calloc(size, sizeof(unsigned int));
+	if (q->buf == NULL)
+		return -ENOMEM;
+	q->size = size;
+	q->top = 0;
+	q->bottom = 0;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_deinit
+ * @BRIEF		release a work-stealing deque.
+ * @param[in, out]	q: deque
+ * @DESCRIPTION		release a work-stealing deque.
+ *//*------------------------------------------------------------------------ */
+void wsdeque_deinit(wsdeque *q)
+{
+	free(q->buf);
+	q->buf = NULL;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_clear
+ * @BRIEF		drop all items of a work-stealing deque.
+ * @param[in, out]	q: deque
+ * @DESCRIPTION		drop all items of a work-stealing deque. Must not be
+ *			called while the deque is in use.
+ *//*------------------------------------------------------------------------ */
+void wsdeque_clear(wsdeque *q)
+{
+	__atomic_store_n(&q->bottom, __atomic_load_n(&q->top,
+		__ATOMIC_RELAXED), __ATOMIC_RELEASE);
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_push
+ * @BRIEF		push an item at the bottom of a deque (owner only).
+ * @RETURNS		0 on success
+ *			-ENOSPC if deque is full
+ * @param[in, out]	q: deque
+ * @param[in]		item: item to push
+ * @DESCRIPTION		push an item at the bottom of a deque (owner only).
+ *//*------------------------------------------------------------------------ */
+int wsdeque_push(wsdeque *q, unsigned int item)
+{
+	long b, t;
+
+	b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+	t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	if (b - t >= q->size)
+		return -ENOSPC;
+	__atomic_store_n(&q->buf[b & (q->size - 1)], item, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_take
+ * @BRIEF		take an item from the bottom of a deque (owner only).
+ * @RETURNS		0 on success
+ *			-EAGAIN if deque is empty (or last item was stolen)
+ * @param[in, out]	q: deque
+ * @param[out]		item: item taken
+ * @DESCRIPTION		take an item from the bottom of a deque (owner only,
+ *			LIFO order).
+ *//*------------------------------------------------------------------------ */
+int wsdeque_take(wsdeque *q, unsigned int *item)
+{
+	long b, t;
+	int ret = 0;
+
+	b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+	__atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+	if (t > b) {
+		/* Empty */
+		__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+		return -EAGAIN;
+	}
+
+	*item = __atomic_load_n(&q->buf[b & (q->size - 1)], __ATOMIC_RELAXED);
+	if (t == b) {
+		/* Last item: race against thieves */
+		if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+			__ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			ret = -EAGAIN;
+		__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+	}
+
+	return ret;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_steal
+ * @BRIEF		steal an item from the top of a deque.
+ * @RETURNS		0 on success
+ *			-EAGAIN if deque is empty or steal lost a race
+ * @param[in, out]	q: deque
+ * @param[out]		item: item stolen
+ * @DESCRIPTION		steal an item from the top of a deque (any thread,
+ *			FIFO order).
+ *//*------------------------------------------------------------------------ */
+int wsdeque_steal(wsdeque *q, unsigned int *item)
+{
+	long b, t;
+
+	t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return -EAGAIN;
+
+	*item = __atomic_load_n(&q->buf[t & (q->size - 1)], __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+		__ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return -EAGAIN;
+
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------*//**
+ * @FUNCTION		wsdeque_depth
+ * @BRIEF		return number of items in a deque.
+ * @RETURNS		number of items in deque (approximate if in use)
+ * @param[in]		q: deque
+ * @DESCRIPTION		return number of items in a deque.
+ *//*------------------------------------------------------------------------ */
+long wsdeque_depth(wsdeque *q)
+{
+	long b, t;
+
+	t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+
+	return (b > t) ? b - t : 0;
+}
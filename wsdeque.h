@@ -0,0 +1,76 @@
+/*
+ *
+ * @Component			CPULOADGEN
+ * @Filename			wsdeque.h
+ * @Description			Lock-free work-stealing deque
+ * @Author			Patrick Titiano (p-titiano@ti.com)
+ * @Date			2010
+ * @Copyright			Texas Instruments Incorporated
+ *
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __CPULOADGEN_WSDEQUE_H__
+#define __CPULOADGEN_WSDEQUE_H__
+
+
+#define WSDEQUE_CACHE_LINE	64
+
+
+/*
+ * Chase-Lev deque: owner pushes and takes at bottom, thieves steal at top.
+ * top and bottom live on separate cache lines, as they are written by
+ * different threads.
+ */
+typedef struct {
+	volatile long top;
+	char pad0[WSDEQUE_CACHE_LINE - sizeof(long)];
+	volatile long bottom;
+	char pad1[WSDEQUE_CACHE_LINE - sizeof(long)];
+	unsigned int *buf;
+	long size;
+} wsdeque;
+
+
+int wsdeque_init(wsdeque *q, long size);
+void wsdeque_deinit(wsdeque *q);
+void wsdeque_clear(wsdeque *q);
+int wsdeque_push(wsdeque *q, unsigned int item);
+int wsdeque_take(wsdeque *q, unsigned int *item);
+int wsdeque_steal(wsdeque *q, unsigned int *item);
+long wsdeque_depth(wsdeque *q);
+
+
+#endif